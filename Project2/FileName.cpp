@@ -2,6 +2,10 @@
  * 优化版智能农场监控系统 - 基于原始脚本完整优化
  * 修复：自由镜头、天气系统、植物位置、参数显示、农场功能
  * 完全基于原始代码结构，确保兼容性
+ *
+ * 无窗口模式：定义 FARM_HEADLESS 可编译不依赖 OpenGL/GLFW 的纯模拟版本，例如
+ *   g++ -std=c++14 -O2 -DFARM_HEADLESS -I<glm路径> FileName.cpp -o farm_headless
+ * 普通版本也可以用 --headless 参数跳过窗口直接运行模拟
  */
 
 #define GLEW_STATIC
@@ -9,8 +13,10 @@
 #define NOMINMAX
 #endif
 
+#ifndef FARM_HEADLESS
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#endif
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -21,11 +27,63 @@
 #include <random>
 #include <string>
 #include <sstream>
+#include <fstream>
 #include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+
+// SIMD内核运行时选择（x86/x64）
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define FARM_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define FARM_TARGET_AVX2
+#else
+#define FARM_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
 
 #ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
 #include <windows.h>
+#pragma comment(lib, "ws2_32.lib")
+#ifndef FARM_HEADLESS
 #pragma comment(lib, "opengl32.lib")
+#endif
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#endif
+
+// 套接字封装（Windows 为 Winsock，其余为 POSIX）
+#ifdef _WIN32
+typedef SOCKET FarmSocket;
+const FarmSocket invalidFarmSocket = INVALID_SOCKET;
+inline void closeFarmSocket(FarmSocket s) { closesocket(s); }
+inline void setFarmSocketNonBlocking(FarmSocket s) { u_long mode = 1; ioctlsocket(s, FIONBIO, &mode); }
+inline int pollFarmSockets(pollfd* fds, size_t count, int timeoutMs) { return WSAPoll(fds, (ULONG)count, timeoutMs); }
+#else
+typedef int FarmSocket;
+const FarmSocket invalidFarmSocket = -1;
+inline void closeFarmSocket(FarmSocket s) { close(s); }
+inline void setFarmSocketNonBlocking(FarmSocket s) { fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK); }
+inline int pollFarmSockets(pollfd* fds, size_t count, int timeoutMs) { return poll(fds, (nfds_t)count, timeoutMs); }
 #endif
 
  // 兼容性修复
@@ -50,6 +108,7 @@ struct Vertex {
     }
 };
 
+#ifndef FARM_HEADLESS
 struct RenderObject {
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
@@ -72,6 +131,7 @@ struct RenderObject {
         }
     }
 };
+#endif
 
 // 天气系统结构
 struct WeatherSystem {
@@ -90,9 +150,74 @@ struct WeatherSystem {
     }
 };
 
-// 传感器数据结构
-struct SensorData {
-    glm::vec3 position;
+// 天气时间线 - 整个模拟季节逐小时预先生成：天气类型按马尔可夫链逐小时转移，气温和湿度为季节均值叠加
+// 按天气类型缩放的日变化曲线，云量、降水、风力和雾取天气类型的基准值加逐小时扰动。每个模拟步只在相邻
+// 两个整点之间线性插值（天气类型取前一整点），超过季节长度后从头循环
+struct WeatherTimeline {
+    std::vector<unsigned char> type;
+    std::vector<float> temperature;       // 室外气温（°C）
+    std::vector<float> humidity;          // 室外相对湿度（%）
+    std::vector<float> cloudCoverage;
+    std::vector<float> precipitation;
+    std::vector<float> windStrength;
+    std::vector<float> fogDensity;
+
+    size_t hours() const { return type.size(); }
+};
+
+// 各天气类型的雾浓度和雾颜色（天气时间线和气象文件共用）
+const float weatherFogDensity[4] = { 0.005f, 0.01f, 0.025f, 0.04f };
+const glm::vec3 weatherFogColors[4] = {
+    glm::vec3(0.9f, 0.9f, 1.0f), glm::vec3(0.8f, 0.8f, 0.9f),
+    glm::vec3(0.65f, 0.65f, 0.75f), glm::vec3(0.4f, 0.4f, 0.55f)
+};
+
+// 气象文件中一个整点的记录
+struct WeatherRecord {
+    float temperature;     // 干球温度（°C）
+    float humidity;        // 相对湿度（%）
+    float cloudCoverage;   // 总云量 0..1
+    float precipitation;   // 降水量（mm/h）
+    float windSpeed;       // 风速（m/s）
+
+    WeatherRecord() : temperature(22.0f), humidity(65.0f), cloudCoverage(0.3f), precipitation(0.0f), windSpeed(2.0f) {}
+};
+
+enum WeatherField {
+    WEATHER_FIELD_TEMPERATURE = 0,
+    WEATHER_FIELD_HUMIDITY = 1,
+    WEATHER_FIELD_CLOUD = 2,
+    WEATHER_FIELD_PRECIPITATION = 3,
+    WEATHER_FIELD_WIND = 4,
+    WEATHER_FIELD_HOUR = 5,
+    WEATHER_FIELDS = 6
+};
+
+// 逐小时气象文件（EnergyPlus EPW，或带表头的 CSV）流式读取：缓冲区只保留当前小时起的有限条记录，
+// 低于一半时顺序读入补满；读到文件末尾后回到第一条数据记录循环。多年文件也不会整体载入内存，
+// 时间加速时按模拟时间跳过已过去的小时
+struct WeatherFileSource {
+    std::string path;
+    std::ifstream file;
+    bool epw;
+    int column[WEATHER_FIELDS];         // 各字段所在列（-1 为文件中没有）
+    std::streampos dataStart;           // 第一条数据记录（已对齐到模拟起点 06:00）
+    std::deque<WeatherRecord> buffer;   // 预读的记录，front() 为第 bufferHour 小时
+    size_t bufferHour;
+    WeatherRecord last;                 // 缺测字段沿用上一条记录的值
+    long long recordsRead;
+    long long missingValues;
+    int rewinds;
+
+    WeatherFileSource() : epw(false), dataStart(0), bufferHour(0), recordsRead(0), missingValues(0), rewinds(0) {
+        for (int f = 0; f < WEATHER_FIELDS; f++) column[f] = -1;
+    }
+
+    bool active() const { return file.is_open(); }
+};
+
+// 传感器读数 - 模拟热数据，每次刷新整体读写
+struct SensorReadings {
     float temperature;
     float humidity;
     float soilMoisture;
@@ -101,19 +226,273 @@ struct SensorData {
     float nitrogenLevel;     // 新增：氮含量
     float phosphorusLevel;   // 新增：磷含量
     float potassiumLevel;    // 新增：钾含量
+
+    SensorReadings() : temperature(22.0f), humidity(60.0f),
+        soilMoisture(45.0f), lightLevel(700.0f), pH(6.8f),
+        nitrogenLevel(50.0f), phosphorusLevel(30.0f), potassiumLevel(40.0f) {
+    }
+};
+
+// 传感器显示数据 - 状态指示灯和数据柱，只有渲染读取
+struct SensorDisplay {
     glm::vec3 statusColor;
     float dataHeight[7];     // 扩展到7个数据维度
-    bool isActive;
 
-    SensorData() : position(0.0f), temperature(22.0f), humidity(60.0f),
-        soilMoisture(45.0f), lightLevel(700.0f), pH(6.8f),
-        nitrogenLevel(50.0f), phosphorusLevel(30.0f), potassiumLevel(40.0f),
-        statusColor(0.2f, 1.0f, 0.3f), isActive(true) {
+    SensorDisplay() : statusColor(0.2f, 1.0f, 0.3f) {
         for (int i = 0; i < 7; i++) dataHeight[i] = 0.5f;
     }
 };
 
-// 增强的植物实例结构
+// 传感器通道（前7个与数据柱顺序一致）
+enum SensorChannel {
+    SENSOR_CHANNEL_TEMPERATURE = 0,
+    SENSOR_CHANNEL_HUMIDITY = 1,
+    SENSOR_CHANNEL_SOIL_MOISTURE = 2,
+    SENSOR_CHANNEL_PH = 3,
+    SENSOR_CHANNEL_NITROGEN = 4,
+    SENSOR_CHANNEL_PHOSPHORUS = 5,
+    SENSOR_CHANNEL_POTASSIUM = 6,
+    SENSOR_CHANNEL_LIGHT = 7,
+    SENSOR_CHANNELS = 8
+};
+
+// 各通道在读数结构中的字段
+float SensorReadings::* const sensorChannelField[SENSOR_CHANNELS] = {
+    &SensorReadings::temperature, &SensorReadings::humidity, &SensorReadings::soilMoisture, &SensorReadings::pH,
+    &SensorReadings::nitrogenLevel, &SensorReadings::phosphorusLevel, &SensorReadings::potassiumLevel,
+    &SensorReadings::lightLevel
+};
+
+// 例外上报的默认死区和回差（约为探头精度；--deadband / --hysteresis 可按通道覆盖）
+const float defaultSensorDeadband[SENSOR_CHANNELS] = { 0.5f, 2.0f, 1.0f, 0.05f, 2.0f, 2.0f, 2.0f, 50.0f };
+const float defaultSensorHysteresis[SENSOR_CHANNELS] = { 0.2f, 1.0f, 0.5f, 0.02f, 1.0f, 1.0f, 1.0f, 20.0f };
+
+const unsigned int sensorDisplayChannels = (1u << SENSOR_CHANNEL_LIGHT) - 1;   // 数据柱和状态灯只用前7个通道
+
+// 传感器例外上报状态：每个通道上次上报的变化方向（+1/-1，0为尚未上报），以及上报值变化后尚未刷新显示的通道
+struct SensorReportState {
+    signed char trend[SENSOR_CHANNELS];
+    unsigned char dirty;
+
+    SensorReportState() : dirty(0) {
+        for (int c = 0; c < SENSOR_CHANNELS; c++) trend[c] = 0;
+    }
+};
+
+// 例外上报累计计数
+struct SensorReportStats {
+    uint64_t channelSamples;    // 进入死区过滤的通道测量值
+    uint64_t channelReports;    // 其中超出死区、发布为上报值的
+    uint64_t sensorRefreshes;   // 传感器刷新次数
+    uint64_t cleanRefreshes;    // 其中没有通道变化、跳过显示重算的
+
+    SensorReportStats() : channelSamples(0), channelReports(0), sensorRefreshes(0), cleanRefreshes(0) {}
+};
+
+// 多速率采样计划 - 通道 c 每 P = periodTicks[c] 步采样一次，第 r 行（共 N 行）在 (步数 + c * P / 通道数) mod P
+// 等于 floor(r * P / N) 的步到期。每一步到期的行是一个连续区间，各步分到的行数相差不超过1；
+// 各通道的时间起点错开，同一行的各通道不会总在同一步到期。同一行同一步到期的通道一起刷新
+struct SensorSampleSchedule {
+    uint32_t periodTicks[SENSOR_CHANNELS];
+    float drift[SENSOR_CHANNELS];         // 每次采样的噪声和随机游走步长系数（按采样周期折算，漂移速率与周期无关）
+    float relax[SENSOR_CHANNELS];         // 露天气温、湿度每次采样向天气基准回归的比例（按采样周期折算）
+    std::vector<uint32_t> rows;           // 本步到期的行（升序）
+    std::vector<unsigned char> due;       // 按行，本步到期的通道（处理完清零）
+    uint64_t ticks;
+    uint64_t rowsSampled;
+    uint64_t channelsSampled;
+    size_t peakRows;                      // 单步最多刷新的行数
+    double millis;                        // 刷新累计耗时
+    double peakMillis;                    // 单步最长耗时
+
+    SensorSampleSchedule() : ticks(0), rowsSampled(0), channelsSampled(0), peakRows(0), millis(0.0), peakMillis(0.0) {
+        for (int c = 0; c < SENSOR_CHANNELS; c++) {
+            periodTicks[c] = 1;
+            drift[c] = 1.0f;
+            relax[c] = 0.2f;
+        }
+    }
+};
+
+inline int countChannels(unsigned int mask) {
+    int n = 0;
+    for (; mask != 0; mask &= mask - 1) n++;
+    return n;
+}
+
+// 一条实测读数。批量数据报（小端）：8字节头（魔数 "FSB1"、读数条数 uint16、保留 uint16），
+// 随后每条读数按本结构原样排列（40字节）
+struct SensorSample {
+    uint32_t sensorId;     // 传感器句柄编号（EntityHandle::id）
+    uint32_t channels;     // 位 k 置位表示 value[k] 有效
+    float value[SENSOR_CHANNELS];
+};
+static_assert(sizeof(SensorSample) == 40, "SensorSample is sent as-is on the wire");
+
+const uint32_t sensorBatchMagic = 0x31425346;   // "FSB1"
+const size_t sensorBatchHeaderSize = 8;
+const size_t sensorBatchMaxSamples = 1600;      // 一个数据报最多约64KB
+const size_t sensorTextDatagramMax = 60000;     // 行协议文本数据报的上限
+
+// 增量帧（版本1，小端）：魔数 "FSD" + 版本字节、帧序号 varint、记录条数 uint16，随后每条记录为
+//   varint(zigzag(编号 - 帧内上一条编号) << 2 | 部分通道标志 << 1 | 绝对值标志)、发送通道位掩码1字节、
+//   [部分通道标志置位时：本条实测通道位掩码1字节]、
+//   每个发送通道一个 varint(zigzag(量化值 - 该传感器该通道的上次量化值))（绝对值记录相对0）。
+// 增量记录只发送与上次不同的通道；本条出现了尚无基准的通道时整条改为绝对值记录（并带上其余已知通道）。
+// 实测通道默认为该传感器全部已知通道，不同时才带实测掩码。
+// 解码端按帧序号检测丢帧，丢帧后增量记录在下一个全量帧之前无法还原
+const uint32_t sensorFrameMagic = 0x01445346;   // "FSD" + 版本1
+const uint32_t sensorFrameMagicMask = 0x00FFFFFF;
+const size_t sensorFrameHeaderMax = 4 + 5 + 2;
+const size_t sensorFrameRecordMax = 10 + 2 + SENSOR_CHANNELS * 5;
+const uint32_t sensorFrameMaxId = 1u << 24;     // 编解码状态按编号直接索引，编号上限（见 SensorDeltaCodec::idLimit）
+// 各通道量化分辨率（温度 0.01°C，pH 0.001，光照 0.1 lux）
+const double sensorChannelResolution[SENSOR_CHANNELS] = { 0.01, 0.01, 0.01, 0.001, 0.01, 0.01, 0.01, 0.1 };
+
+// 遥测数据格式（回放和转换工具）
+enum TelemetryFormat {
+    TELEMETRY_BATCH = 0,   // 40字节定长记录的批量帧
+    TELEMETRY_TEXT = 1,    // 行协议文本
+    TELEMETRY_DELTA = 2    // 增量帧
+};
+
+// 增量帧编解码状态 - 每个传感器每个通道的上次量化值。编码端和解码端各持一份，按帧序号保持同步
+struct SensorDeltaCodec {
+    std::vector<int32_t> last;           // 按 编号 * SENSOR_CHANNELS + 通道
+    std::vector<unsigned char> known;    // 按编号，已有基准值的通道
+    uint32_t sequence;                   // 编码：下一帧序号；解码：期望的下一帧序号
+    uint32_t keyInterval;                // 编码：每隔多少帧发送一次全量帧（0为只在首次出现时发送绝对值）
+    uint32_t idLimit;                    // 接受的编号上限（不含），接入端按传感器数量设置，防止异常编号撑大状态表
+    bool started;                        // 解码：是否收到过帧
+    uint64_t frames;
+    uint64_t records;
+    uint64_t channelValues;              // 实际发送的通道值
+    uint64_t resyncs;                    // 解码：检测到丢帧或乱序的次数
+    uint64_t orphanValues;               // 解码：缺少基准而丢弃的增量值
+    uint64_t rejectedIds;                // 编号超出 idLimit 而跳过的读数（编码）或记录（解码）
+
+    SensorDeltaCodec() : sequence(0), keyInterval(64), idLimit(sensorFrameMaxId), started(false), frames(0), records(0),
+        channelValues(0), resyncs(0), orphanValues(0), rejectedIds(0) {
+    }
+
+    void track(uint32_t id) {
+        if (id < known.size()) return;
+        size_t size = std::max((size_t)id + 1, known.size() * 2);
+        known.resize(size, 0);
+        last.resize(size * SENSOR_CHANNELS, 0);
+    }
+};
+
+// 行协议文本的一段（不持有数据，直接指向接收缓冲区）
+struct TextSlice {
+    const char* begin;
+    const char* end;
+
+    TextSlice(const char* b, const char* e) : begin(b), end(e) {}
+
+    size_t size() const { return (size_t)(end - begin); }
+    bool is(const char* text, size_t length) const { return size() == length && memcmp(begin, text, length) == 0; }
+};
+
+// 行协议解析计数
+struct LineParseStats {
+    uint64_t lines;       // 非空、非注释行
+    uint64_t malformed;   // 其中格式错误的行
+    uint64_t bytes;       // 已消费的字节数
+
+    LineParseStats() : lines(0), malformed(0), bytes(0) {}
+};
+
+// 换行符扫描内核：返回 [begin, end) 中第一个 '\n' 的位置，没有则返回 end
+typedef const char* (*LineScanFn)(const char* begin, const char* end);
+
+// 读数环形队列 - 多生产者单消费者、无锁。每个槽位带序号：序号等于写位置时可写，等于写位置+1时可读。
+// 生产者用 CAS 抢占写位置，队列满时 push 立即返回 false，由调用方计入背压丢弃数
+struct SensorSampleRing {
+    struct Slot {
+        std::atomic<uint64_t> sequence;
+        SensorSample sample;
+    };
+    std::unique_ptr<Slot[]> slots;
+    size_t mask;
+    alignas(64) std::atomic<uint64_t> head;   // 下一个写位置（生产者共享）
+    alignas(64) uint64_t tail;                // 下一个读位置（只有模拟线程读写）
+
+    SensorSampleRing() : mask(0), head(0), tail(0) {}
+
+    size_t capacity() const { return slots ? mask + 1 : 0; }
+
+    // capacity 须为2的幂
+    void reset(size_t capacity) {
+        slots.reset(new Slot[capacity]);
+        mask = capacity - 1;
+        for (size_t i = 0; i < capacity; i++) slots[i].sequence.store(i, std::memory_order_relaxed);
+        head.store(0, std::memory_order_relaxed);
+        tail = 0;
+    }
+
+    bool push(const SensorSample& sample) {
+        uint64_t position = head.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots[position & mask];
+            uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            int64_t difference = (int64_t)(sequence - position);
+            if (difference == 0) {
+                if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    slot.sample = sample;
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0) {
+                return false;
+            }
+            else {
+                position = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool pop(SensorSample& sample) {
+        Slot& slot = slots[tail & mask];
+        if (slot.sequence.load(std::memory_order_acquire) != tail + 1) return false;
+        sample = slot.sample;
+        slot.sequence.store(tail + mask + 1, std::memory_order_release);
+        tail++;
+        return true;
+    }
+};
+
+// 传感器实时接入 - 独立 I/O 线程监听 UDP 和 Unix 域数据报套接字，解码批量数据报后写入读数环形队列；
+// 模拟线程每步取出读数，按传感器编号写入 sensorStore。近期收到实测值的通道不再由模拟生成。
+// 接收计数由 I/O 线程写、主线程读，丢弃数即背压（模拟线程取数跟不上时队列满）
+struct SensorIngest {
+    std::vector<FarmSocket> sockets;
+    std::vector<std::string> unixPaths;       // 停止时删除
+    std::thread thread;
+    std::atomic<bool> running;
+    SensorSampleRing ring;
+    std::atomic<uint64_t> datagrams;
+    std::atomic<uint64_t> samplesReceived;
+    std::atomic<uint64_t> samplesDropped;     // 队列满被丢弃
+    std::atomic<uint64_t> malformed;          // 格式错误的数据报或文本行
+    std::vector<SensorSample> textSamples;    // 行协议和增量帧数据报的解析结果（只有 I/O 线程使用，复用容量）
+    std::vector<SensorDeltaCodec> frameDecoders; // 每个套接字一份增量帧解码状态（只有 I/O 线程使用）
+    // 以下只有模拟线程读写
+    uint64_t samplesApplied;
+    uint64_t unknownSensors;                  // 编号不存在或已删除
+    size_t peakBacklog;                       // 单步取出的最多读数
+    std::vector<unsigned char> liveChannels;  // 每个传感器（行）收到过实测值的通道
+    std::vector<double> liveTime;             // 最近一次实测值的模拟时间
+
+    SensorIngest() : running(false), datagrams(0), samplesReceived(0), samplesDropped(0), malformed(0),
+        samplesApplied(0), unknownSensors(0), peakBacklog(0) {
+    }
+
+    bool active() const { return !sockets.empty(); }
+};
+
+// 植物生成记录 - 初始化时组装，随后拆分写入 plantStore 的各列
 struct DetailedPlant {
     glm::vec3 position;
     float height;
@@ -125,15 +504,12 @@ struct DetailedPlant {
     float healthFactor;
     glm::vec3 stemColor;
     glm::vec3 leafColor;
-    int plantType; // 0=玉米, 1=小麦, 2=番茄, 3=菠菜
+    int plantType; // cropTable 下标（内置 0=玉米, 1=小麦, 2=番茄, 3=菠菜）
     float growthStage; // 0.0-1.0
     bool hasFlowers;
     bool hasFruits;
 
-    // 新增细节特性
-    std::vector<glm::vec3> leafPositions;    // 每片叶子的位置
-    std::vector<float> leafSizes;            // 每片叶子的大小
-    std::vector<glm::vec3> branchPositions;  // 分支位置
+    // 新增细节特性（叶片布局由 computeLeafLayout 按需计算）
     float rootSpread;                        // 根系扩展范围
     int diseaseLevel;                        // 病害等级 0-3
     float waterNeed;                         // 水分需求
@@ -150,6 +526,685 @@ struct DetailedPlant {
     }
 };
 
+// 植物模拟热数据 - 列式存储，每个字段连续排列供SIMD内核批量处理
+// plants 中对应下标的 DetailedPlant 保存位置、形态等冷数据
+struct PlantColumns {
+    std::vector<float> healthFactor;
+    std::vector<float> growthStage;
+    std::vector<float> leafColorR;           // 叶片颜色（蓝色分量恒为0.1）
+    std::vector<float> leafColorG;
+    std::vector<unsigned char> pestInfected;
+    std::vector<unsigned char> hasFlowers;
+    std::vector<unsigned char> hasFruits;
+    // 小气候（每tick由 samplePlantMicroclimate 从传感器和土壤网格收集）
+    std::vector<float> localTemperature;
+    std::vector<float> localHumidity;
+    std::vector<float> localMoisture;
+    std::vector<float> witherSeconds;        // 健康持续处于枯死阈值的时间（cullDeadPlants 每秒累计）
+
+    size_t size() const { return healthFactor.size(); }
+};
+
+// 作物生长习性 - 决定植物内核的特化版本（是否计算开花、结果）
+enum CropHabit {
+    CROP_LEAFY = 0,       // 叶菜：不开花不结果
+    CROP_FLOWERING = 1,   // 抽穗/开花作物
+    CROP_FRUITING = 2     // 开花后结果
+};
+const int cropHabitCount = 3;
+
+// 叶片渲染形状
+enum LeafStyle {
+    LEAF_BLADE = 0,       // 长条形（玉米）
+    LEAF_NARROW = 1,      // 细长（小麦）
+    LEAF_COMPOUND = 2,    // 复合叶（番茄）
+    LEAF_ROUND = 3        // 圆形（菠菜）
+};
+
+// 作物参数表的一项：积温模型、物候阶段、适宜范围和形态，内置作物之外可由 --crops 文件追加
+struct CropSpec {
+    std::string name;
+    CropHabit habit;
+    float baseTemperature;      // 积温起算温度（°C），低于此温度不发育
+    float upperTemperature;     // 积温上限温度，高于此温度按上限计
+    float gddToMaturity;        // 从播种到成熟所需积温（°C·天）
+    float flowerStage;          // 开花的生长阶段（成熟积温的比例）
+    float fruitStage;           // 结果的生长阶段
+    float optimalTemperature;   // 小气候适宜范围：温度 optimal±tolerance、土壤水分、空气湿度下限
+    float temperatureTolerance;
+    float minMoisture;
+    float maxMoisture;
+    float minHumidity;
+    float heightScale;          // 形态：株高倍数、茎粗、叶片数（基数+按序号轮换）、叶片大小
+    float stemRadius;
+    int leafCount;
+    int leafCountSpread;
+    float leafSize;
+    glm::vec3 stemColor;
+    glm::vec3 leafColor;
+    LeafStyle leafStyle;
+    int petalCount;
+    float kcInitial;            // 作物系数（FAO-56）：苗期、生长中期、成熟末期
+    float kcMid;
+    float kcEnd;
+
+    CropSpec() : habit(CROP_FLOWERING), baseTemperature(10.0f), upperTemperature(30.0f), gddToMaturity(1200.0f),
+        flowerStage(0.7f), fruitStage(2.0f), optimalTemperature(24.0f), temperatureTolerance(8.0f),
+        minMoisture(30.0f), maxMoisture(85.0f), minHumidity(35.0f), heightScale(1.0f), stemRadius(0.03f),
+        leafCount(8), leafCountSpread(3), leafSize(0.15f), stemColor(0.4f, 0.6f, 0.2f), leafColor(0.2f, 0.8f, 0.1f),
+        leafStyle(LEAF_BLADE), petalCount(6), kcInitial(0.4f), kcMid(1.1f), kcEnd(0.7f) {
+    }
+};
+
+// 每个tick对所有植物相同的参数，由天气和farmStatus开关预先算好，内核里不再逐株分支；
+// 作物相关的字段由 setCrop 按作物填入，每个作物批次使用自己的一份
+struct PlantKernelParams {
+    float gddScale;           // 每°C有效积温带来的生长阶段增量（已含本tick时长和作物日历压缩）
+    float baseTemperature;    // 积温起算/上限温度
+    float upperTemperature;
+    float flowerStage;        // 开花、结果的生长阶段
+    float fruitStage;
+    float weatherEffect;      // 天气系数（已合并夜间照明和气候控制）
+    float fertilizerHealth;   // 施肥带来的健康提升
+    float fertilizerGrowth;   // 施肥带来的生长加速
+    float nightGrowth;        // 夜间照明额外生长
+    float climateHealth;      // 气候控制的长期健康提升
+    float harvestGrowthMin;   // 自动收获的成熟阈值（关闭时为2.0）
+    float optimalTemperature; // 小气候适宜范围：温度 optimal±tolerance、土壤水分、空气湿度下限
+    float temperatureTolerance;
+    float minMoisture;
+    float maxMoisture;
+    float minHumidity;
+    float pestHealthCap;      // 感染植物的健康上限（治疗由 sprayPestFootprints 按喷洒范围执行）
+
+    PlantKernelParams() : gddScale(0.0f), baseTemperature(10.0f), upperTemperature(30.0f),
+        flowerStage(2.0f), fruitStage(2.0f), weatherEffect(1.0f),
+        fertilizerHealth(0.0f), fertilizerGrowth(0.0f), nightGrowth(0.0f), climateHealth(0.0f),
+        harvestGrowthMin(2.0f), optimalTemperature(24.0f), temperatureTolerance(8.0f),
+        minMoisture(30.0f), maxMoisture(85.0f), minHumidity(35.0f), pestHealthCap(0.6f) {
+    }
+
+    void setCrop(const CropSpec& crop, float deltaTime);
+};
+
+// 植物内核统计结果
+struct PlantKernelResult {
+    int harvested;
+    std::vector<uint32_t> harvestedRows;   // 本块收获（原地重新种植）的行，按行号递增
+
+    PlantKernelResult() : harvested(0) {}
+
+    // 清零但保留行列表容量，稳定运行时不再分配
+    void reset() {
+        harvested = 0;
+        harvestedRows.clear();
+    }
+};
+
+// 植物内核指令集级别
+enum PlantKernelLevel {
+    PLANT_KERNEL_SCALAR = 0,
+    PLANT_KERNEL_SSE2 = 1,
+    PLANT_KERNEL_AVX2 = 2
+};
+
+typedef void (*PlantKernelFn)(PlantColumns& columns, size_t begin, size_t end,
+    const PlantKernelParams& params, PlantKernelResult& result);
+
+// 同一作物的一段连续行（不超过一个植物块），植物内核按批调用对应作物习性的特化版本
+struct PlantBatch {
+    uint32_t crop;
+    size_t begin;
+    size_t end;
+
+    PlantBatch(uint32_t c, size_t b, size_t e) : crop(c), begin(b), end(e) {}
+};
+
+// 随机流用途 - 与实体编号、模拟步数一起组成计数器，不同用途的流互不相关
+enum RandomDomain {
+    RNG_SENSOR_INIT = 1,
+    RNG_PLANT_PLACEMENT = 2,
+    RNG_PLANT_INIT = 3,
+    RNG_SENSOR_TICK = 4,
+    RNG_PEST_SPREAD = 5,
+    RNG_WEATHER = 6,
+    RNG_SENSOR_REPLAY = 7
+};
+
+// Philox4x32-10 计数器随机数流 - 输出只由(种子, 用途, 实体, 步数, 抽取序号)决定，
+// 与线程数和执行顺序无关，每个实体每一步可以独立构造自己的流
+struct PhiloxStream {
+    uint32_t key[2];
+    uint32_t counter[4];   // [抽取块序号, 实体, 步数低32位, 用途<<24 ^ 步数高位]
+    uint32_t block[4];
+    int used;
+
+    PhiloxStream(uint64_t seed, uint32_t domain, uint32_t entity, uint64_t step) : used(4) {
+        key[0] = (uint32_t)seed;
+        key[1] = (uint32_t)(seed >> 32);
+        counter[0] = 0;
+        counter[1] = entity;
+        counter[2] = (uint32_t)step;
+        counter[3] = (domain << 24) ^ (uint32_t)(step >> 32);
+    }
+
+    static uint32_t mulhilo(uint32_t a, uint32_t b, uint32_t& hi) {
+        uint64_t product = (uint64_t)a * b;
+        hi = (uint32_t)(product >> 32);
+        return (uint32_t)product;
+    }
+
+    void generateBlock() {
+        uint32_t c[4] = { counter[0], counter[1], counter[2], counter[3] };
+        uint32_t k0 = key[0], k1 = key[1];
+        for (int round = 0; round < 10; round++) {
+            uint32_t hi0, hi1;
+            uint32_t lo0 = mulhilo(0xD2511F53u, c[0], hi0);
+            uint32_t lo1 = mulhilo(0xCD9E8D57u, c[2], hi1);
+            c[0] = hi1 ^ c[1] ^ k0;
+            c[1] = lo1;
+            c[2] = hi0 ^ c[3] ^ k1;
+            c[3] = lo0;
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+        }
+        for (int i = 0; i < 4; i++) block[i] = c[i];
+        counter[0]++;
+        used = 0;
+    }
+
+    uint32_t nextU32() {
+        if (used == 4) generateBlock();
+        return block[used++];
+    }
+
+    // [lo, hi) 均匀浮点数（24位精度，各平台结果一致）
+    float uniform(float lo, float hi) {
+        return lo + (hi - lo) * ((nextU32() >> 8) * (1.0f / 16777216.0f));
+    }
+
+    // [0, n) 均匀整数
+    uint32_t below(uint32_t n) {
+        return (uint32_t)(((uint64_t)nextU32() * n) >> 32);
+    }
+};
+
+// 禁止种植的圆形区域（建筑、传感器周围）
+struct ExclusionZone {
+    glm::vec2 center;
+    float radius;
+
+    ExclusionZone(glm::vec2 c, float r) : center(c), radius(r) {}
+};
+
+// 均匀网格空间哈希 - 点按所在单元格分桶（连续存储），用于半径邻域查询
+struct SpatialHashGrid {
+    float cellSize;
+    float originX, originZ;
+    int cellsX, cellsZ;
+    std::vector<int> cellStart;   // 每个单元格在 items 中的起始位置（长度为单元格数+1）
+    std::vector<int> items;       // 按单元格排列的点编号
+
+    SpatialHashGrid() : cellSize(1.0f), originX(0.0f), originZ(0.0f), cellsX(0), cellsZ(0) {}
+
+    int cellX(float x) const { return clampCell((int)std::floor((x - originX) / cellSize), cellsX); }
+    int cellZ(float z) const { return clampCell((int)std::floor((z - originZ) / cellSize), cellsZ); }
+    static int clampCell(int c, int n) { return c < 0 ? 0 : (c >= n ? n - 1 : c); }
+
+    void build(const std::vector<glm::vec2>& points, float size);
+
+    // 对半径 radius 内可能相邻的每个点调用 fn(编号)，调用方自行判断精确距离
+    template<typename Fn>
+    void forEachNear(float x, float z, float radius, Fn fn) const {
+        if (items.empty()) return;
+        int x0 = cellX(x - radius), x1 = cellX(x + radius);
+        int z0 = cellZ(z - radius), z1 = cellZ(z + radius);
+        for (int cz = z0; cz <= z1; cz++) {
+            for (int cx = x0; cx <= x1; cx++) {
+                int cell = cz * cellsX + cx;
+                for (int k = cellStart[cell]; k < cellStart[cell + 1]; k++) {
+                    fn(items[k]);
+                }
+            }
+        }
+    }
+};
+
+// 土壤场单步参数 - 由天气、昼夜和步长预先算好，对全网格相同
+struct SoilStepParams {
+    float dt;                    // 本步时长（秒）
+    float diffusion;             // 水分横向扩散系数（已换算为网格单位 D*dt/dx²）
+    float nutrientDiffusion;     // 氮素横向扩散系数
+    float rainfall;              // 本步降雨入渗（%）
+    float evaporation;           // 本步蒸发比例（随昼夜变化）
+    float fieldCapacity;         // 田间持水量（%），超出部分向深层渗漏
+    float drainFraction;         // 超出部分本步渗漏的比例
+    float leachRate;             // 每渗漏1%水分带走的氮比例
+    const float* zoneWater;      // 各控制区喷灌强度（%/秒，阀门关闭为0）
+    const float* zoneNitrogen;   // 各控制区随水施氮强度（%/秒）
+
+    SoilStepParams() : dt(0.0f), diffusion(0.0f), nutrientDiffusion(0.0f), rainfall(0.0f),
+        evaporation(0.0f), fieldCapacity(60.0f), drainFraction(0.0f), leachRate(0.0f),
+        zoneWater(nullptr), zoneNitrogen(nullptr) {
+    }
+};
+
+// 土壤网格 - 覆盖种植区的二维水分/氮素场，双缓冲。每个单元格归属最近的传感器控制区，
+// 传感器刷新时开关控制区阀门；喷头网格的覆盖系数可分离为 coverageX[x] * coverageZ[z]
+struct SoilGrid {
+    int width, height;
+    float cellSize;
+    float originX, originZ;
+    std::vector<float> moisture, moistureNext;   // 土壤含水量（%）
+    std::vector<float> nitrogen, nitrogenNext;   // 硝态氮（0-100，随渗漏淋洗）
+    std::vector<uint32_t> zone;                  // 单元格所属传感器行
+    std::vector<float> coverageX, coverageZ;     // 喷头网格覆盖系数（网格内部约为1）
+    std::vector<float> zoneWater;                // 每个传感器控制区的喷灌强度（%/秒）
+    std::vector<float> zoneNitrogen;             // 每个传感器控制区的随水施氮强度（%/秒）
+
+    SoilGrid() : width(0), height(0), cellSize(1.0f), originX(0.0f), originZ(0.0f) {}
+
+    size_t cells() const { return (size_t)width * height; }
+
+    size_t cellAt(float x, float z) const {
+        int cx = SpatialHashGrid::clampCell((int)std::floor((x - originX) / cellSize), width);
+        int cz = SpatialHashGrid::clampCell((int)std::floor((z - originZ) / cellSize), height);
+        return (size_t)cz * width + cx;
+    }
+};
+
+// 土壤模板更新的一行：上下行在边界处取本行（零通量边界）
+struct SoilRowView {
+    const float* moistureUp;
+    const float* moisture;
+    const float* moistureDown;
+    const float* nitrogenUp;
+    const float* nitrogen;
+    const float* nitrogenDown;
+    const uint32_t* zone;
+    const float* coverageX;
+    float* moistureOut;
+    float* nitrogenOut;
+    float coverageZ;             // 本行覆盖系数（已乘步长）
+    int width;
+
+    SoilRowView(SoilGrid& grid, int z, float dt) : width(grid.width) {
+        size_t up = (size_t)std::max(z - 1, 0) * grid.width;
+        size_t mid = (size_t)z * grid.width;
+        size_t down = (size_t)std::min(z + 1, grid.height - 1) * grid.width;
+        moistureUp = grid.moisture.data() + up;
+        moisture = grid.moisture.data() + mid;
+        moistureDown = grid.moisture.data() + down;
+        nitrogenUp = grid.nitrogen.data() + up;
+        nitrogen = grid.nitrogen.data() + mid;
+        nitrogenDown = grid.nitrogen.data() + down;
+        zone = grid.zone.data() + mid;
+        coverageX = grid.coverageX.data();
+        moistureOut = grid.moistureNext.data() + mid;
+        nitrogenOut = grid.nitrogenNext.data() + mid;
+        coverageZ = grid.coverageZ[z] * dt;
+    }
+};
+
+typedef void (*SoilRowFn)(SoilGrid& grid, int z, const SoilStepParams& params);
+
+// 灌溉需水预报 - 每个灌溉区（传感器行）按 Penman-Monteith 逐小时计算参考蒸散 ET0，
+// 乘区内作物系数得到作物蒸散 ETc，累计未来24/48/72小时需水量。逐小时的共享输入先算好，
+// 内核按区域分通道向量化，每条通道内循环各小时
+const int etForecastHours = 72;
+struct EtForecast {
+    // 逐小时共享输入（与区域无关）
+    float dayFactor[etForecastHours];         // 昼夜系数，与传感器刷新相同的公式
+    float radiation[etForecastHours];         // 太阳辐射（MJ/m²/h，已含云量折减，未乘区域光照系数）
+    float soilHeatFraction[etForecastHours];  // 土壤热通量占净辐射比例：白天0.1，夜间0.5
+    float dayFactorNow;
+    float temperatureSwing;   // 气温日较差的一半（预报气温 = 当前 + swing × 昼夜系数变化）
+    float windSpeed;          // 2米高风速（m/s）
+    float cloudFactor;        // 净长波辐射的云量项 1.35·Rs/Rso − 0.35
+    // 每区输入
+    std::vector<float> temperature;
+    std::vector<float> humidity;
+    std::vector<float> lightScale;        // 区域光照相对晴空曲线的比例
+    std::vector<float> cropCoefficient;   // 区内植物的平均作物系数
+    std::vector<float> area;              // 区域面积（m²，土壤网格中最近传感器为本区的单元格）
+    // 每区输出（mm）
+    std::vector<float> etNow;             // 当前小时 ETc
+    std::vector<float> demand24;
+    std::vector<float> demand48;
+    std::vector<float> demand72;
+    // 全场合计（升）与刷新耗时统计
+    double totalDemand24;
+    double totalDemand48;
+    double totalDemand72;
+    int refreshCount;
+    double refreshMillis;
+
+    EtForecast() : dayFactorNow(0.5f), temperatureSwing(6.0f), windSpeed(2.0f), cloudFactor(1.0f),
+        totalDemand24(0.0), totalDemand48(0.0), totalDemand72(0.0), refreshCount(0), refreshMillis(0.0) {
+        for (int h = 0; h < etForecastHours; h++) {
+            dayFactor[h] = 0.5f;
+            radiation[h] = 0.0f;
+            soilHeatFraction[h] = 0.5f;
+        }
+    }
+
+    size_t zones() const { return temperature.size(); }
+};
+
+typedef void (*EtForecastFn)(EtForecast& forecast, size_t begin, size_t end);
+
+// 灌溉排程 - 每个灌溉区一个阀门，计划覆盖未来 irrigationSlots 个土壤步长（槽位），每个阀门至多一个
+// 连续开启窗口。约束：水泵流量、管网压力（泵特性曲线下喷头最低压力对应的流量）、各支管流量和
+// 水箱可用水量。先按缺水紧迫度贪心求解体积分配的线性规划（支管约束互不相交、总量约束包含全部支管，
+// 约束集为层状结构，贪心即最优），再把分配装入逐槽位的流量容量，最后用剩余容量细化被截断的窗口
+const int irrigationSlots = 24;
+
+struct IrrigationSchedule {
+    // 每个阀门（与传感器行一致）
+    std::vector<float> flowPerRate;       // 每 1%/秒 喷灌强度对应的流量（升/秒，= 面积 × 根区每1%含水量的升数）
+    std::vector<float> flow;              // 当前强度下阀门全开流量（升/秒）
+    std::vector<uint32_t> branch;         // 所在支管（传感器网格列）
+    std::vector<float> urgency;           // 预计缺水量（%），0表示不需要灌溉
+    std::vector<uint8_t> needSlots;       // 补足缺水需要的槽位数
+    std::vector<uint8_t> allocatedSlots;  // 线性规划分配的槽位数
+    std::vector<uint8_t> windowStart;     // 开启窗口（相对计划起点的槽位）
+    std::vector<uint8_t> windowLength;
+    std::vector<uint32_t> queue;          // 本次求解的候选阀门，按紧迫度从高到低
+    // 每个支管 / 每个槽位
+    int branchCount;
+    std::vector<float> branchCapacity;    // 支管流量上限（升/秒）
+    std::vector<float> branchVolume;      // 求解时支管剩余可分配水量（升）
+    std::vector<float> slotFlow;          // [槽位] 已排流量
+    std::vector<float> branchSlotFlow;    // [支管 * irrigationSlots + 槽位] 已排流量
+    // 供水系统
+    float pumpCapacity;          // 水泵额定流量（升/秒）
+    float pressureLimitedFlow;   // 压力不低于喷头最低工作压力时的最大流量
+    float tankCapacity;          // 水箱容量（升）
+    float tankRefill;            // 水源补水流量（升/秒）
+    float valveRate;             // 当前强度下阀门开启时的喷灌强度（%/秒）
+    int slot;                    // 正在执行的槽位
+    bool dirty;                  // 传感器刷新或手动调节后置位，下一个土壤步长前重新求解
+    // 最近一次求解结果
+    float flowPrice;             // 对偶价格：被截断的第一个阀门的紧迫度（每升），0表示约束不紧
+    float tankPrice;
+    float branchPrice;
+    int scheduledValves;
+    int truncatedValves;
+    double plannedVolume;        // 计划用水（升）
+    int solveCount;
+    double solveMillis;
+
+    IrrigationSchedule() : branchCount(0), pumpCapacity(0.0f), pressureLimitedFlow(0.0f),
+        tankCapacity(1.0f), tankRefill(0.0f), valveRate(0.0f), slot(irrigationSlots), dirty(true),
+        flowPrice(0.0f), tankPrice(0.0f), branchPrice(0.0f), scheduledValves(0), truncatedValves(0),
+        plannedVolume(0.0), solveCount(0), solveMillis(0.0) {
+    }
+
+    size_t valves() const { return flow.size(); }
+};
+
+// 管网多重网格的一层
+struct PipeLevel {
+    int size;                           // 每边节点数（上一层 2×2 节点聚合为本层一个节点）
+    std::vector<double> gEast, gNorth;  // 节点向东、向北的电导（粗层为跨聚合的细层电导之和）
+    std::vector<double> diag;
+    std::vector<double> x, b, r;        // 解、右端项、残差
+
+    PipeLevel() : size(0) {}
+};
+
+// 管段水力特性：流量 Q = (Δh/r)^exponent，小水头差区间 Q = c1·Δ + c3·Δ³（系数初始化时算好）
+struct PipeLaw {
+    double resistance;
+    double exponent;
+    double c1, c3;
+
+    PipeLaw() : resistance(1.0), exponent(0.5), c1(0.0), c3(0.0) {}
+};
+
+// 灌溉管网 - 喷头格网（与 generateDetailedFarm 中的管道布局相同）上每个喷头一个节点，相邻喷头之间一段
+// 支管；西侧边缘一列是较粗的干管，主管从水泵站接入西侧边缘中点。水泵出口另设一个节点，水泵按特性曲线
+// 从关死扬程的水源取水。管段按 Hazen-Williams 公式、喷头按 q = K·√p 出水，对节点水头做牛顿迭代，
+// 每步的线性化方程（对称正定）消去水泵出口节点后用共轭梯度求解，预条件为聚合多重网格V循环。
+// 节点水头跨 tick 保留作为下次求解的初值，阀门开关不变且已收敛时跳过求解
+struct PipeNetwork {
+    int size;                           // 每边喷头节点数
+    uint32_t inlet;                     // 主管接入的格网节点
+    double reservoirHead;               // 水泵关死扬程（m）
+    PipeLaw pumpLaw;                    // 水泵扬程损失 = r·Q²
+    PipeLaw mainLaw;                    // 主管 Hazen-Williams（水头损失 = r·Q^1.852）
+    PipeLaw headerLaw;                  // 西侧干管每段
+    PipeLaw lateralLaw;                 // 格网支管每段
+    double emitterK;                    // 喷头流量系数
+    double nominalFlow;                 // 额定压力下单个喷头流量（m³/s）
+    std::vector<uint32_t> zone;         // 喷头节点所属灌溉区
+    std::vector<unsigned char> open;    // 所在区阀门是否开启
+    std::vector<double> head;           // 格网节点水头（m，地面为0）
+    double pumpHead;                    // 水泵出口水头
+    std::vector<double> flowEast;       // 节点向东、向北管段的流量（m³/s）
+    std::vector<double> flowNorth;
+    std::vector<double> residual;       // 节点流量不平衡（流出为正）
+    double pumpResidual;
+    std::vector<PipeLevel> levels;      // 第0层为牛顿雅可比（电导 dQ/dΔh），共轭梯度的 r、z 即第0层的 b、x
+    std::vector<double> coarseFactor;   // 最粗层稠密矩阵的 Cholesky 分解
+    std::vector<double> delta, cgP, cgPNext, cgAp;   // 牛顿步和共轭梯度工作向量
+    double pumpDelta;
+    std::vector<double> chunkSums;      // 按行块的部分和（按块顺序归约，与线程数无关）
+    std::vector<double> chunkSums2;
+    double mainFlow, mainConductance;
+    double pumpFlow, pumpConductance;
+    std::vector<float> zoneOutput;      // 各区开启喷头平均出水与额定出水之比（区内没有喷头为0）
+    std::vector<int> zoneNozzles;
+    bool dirty;                         // 阀门开关变化后置位
+    bool converged;
+    // 求解统计
+    int solves;
+    int unconverged;                    // 达到迭代上限仍未收敛的求解次数
+    int newtonSteps;
+    int cgIterations;
+    double solveMillis;
+    double residualNorm;
+
+    PipeNetwork() : size(0), inlet(0), reservoirHead(0.0), emitterK(0.0), nominalFlow(0.0),
+        pumpHead(0.0), pumpResidual(0.0), pumpDelta(0.0), mainFlow(0.0), mainConductance(0.0), pumpFlow(0.0), pumpConductance(0.0), dirty(true), converged(false),
+        solves(0), unconverged(0), newtonSteps(0), cgIterations(0), solveMillis(0.0), residualNorm(0.0) {
+    }
+
+    size_t nodes() const { return (size_t)size * size; }
+    size_t segments() const { return 2 * (size_t)size * (size - 1) + 2; }   // 格网管段 + 主管 + 水泵
+};
+
+// 温室气候控制回路：每栋温室4个PID回路（加热、通风降温、喷雾加湿、通风除湿），全部温室的回路按类型
+// 分段连续存放（第 k 类回路在 [k·温室数, (k+1)·温室数)），一次批量内核计算所有回路。
+// 微分项只作用于测量值（设定值变化不产生冲击），积分用反算法抗饱和：输出被限幅时按差值回退积分
+enum ClimateLoopKind {
+    CLIMATE_LOOP_HEAT = 0,
+    CLIMATE_LOOP_VENT_COOL = 1,
+    CLIMATE_LOOP_MIST = 2,
+    CLIMATE_LOOP_VENT_DRY = 3,
+    CLIMATE_LOOP_KINDS = 4
+};
+
+struct ClimateLoops {
+    std::vector<float> setpoint;
+    std::vector<float> measurement;
+    std::vector<float> direction;     // +1：测量值低于设定值时加大输出（加热、加湿）；-1：高于时加大（通风）
+    std::vector<float> kp;
+    std::vector<float> ki;            // 1/s
+    std::vector<float> kd;            // s
+    std::vector<float> tracking;      // 抗饱和反算增益 1/Tt（1/s）
+    std::vector<float> integral;      // 积分项（已乘 ki，与输出同单位）
+    std::vector<float> previous;      // 上一步测量值
+    std::vector<float> output;        // 限幅后的输出 0..1
+
+    size_t size() const { return setpoint.size(); }
+};
+
+typedef void (*ClimateLoopFn)(ClimateLoops& loops, size_t begin, size_t end, float dt);
+
+// 温室热湿区 - buildings 中每栋温室一个集总参数区，状态为空气温度（热容含作物和结构）和水汽密度。
+// 热平衡：太阳得热 + 加热 − 喷雾蒸发潜热 − 覆盖层传热 − 通风换热；水汽平衡：作物蒸腾 + 喷雾 − 通风排湿，
+// 超过饱和的部分在覆盖层结露。两式按后退欧拉积分（通风量和得热取步初值），任意步长都稳定
+struct GreenhouseZones {
+    std::vector<uint32_t> building;       // 所在建筑行
+    std::vector<float> floorArea;         // m²
+    std::vector<float> volume;            // m³
+    std::vector<float> heatCapacity;      // 等效热容（J/K）
+    std::vector<float> glazingUA;         // 覆盖层传热系数 × 面积（W/K）
+    std::vector<float> heaterPower;       // 加热器额定功率（W）
+    std::vector<float> mistRate;          // 喷雾额定蒸发量（g/s）
+    std::vector<float> airTemperature;    // °C
+    std::vector<float> vapourDensity;     // g/m³
+    std::vector<float> humidity;          // 相对湿度（%）
+    std::vector<float> heat, vent, mist;  // 本步执行器开度 0..1
+    std::vector<int32_t> sensorZone;      // 每个传感器所在温室（-1 为露天）
+    ClimateLoops loops;
+    float outdoorTemperature;
+    float outdoorHumidity;
+    float electricPower;                  // 加热（热泵）、风机和喷雾泵的电功率（kW）
+    double heatEnergy;                    // 累计供热量（kWh）
+    int steps;
+    double controlMillis;                 // 回路内核累计耗时
+
+    GreenhouseZones() : outdoorTemperature(22.0f), outdoorHumidity(65.0f), electricPower(0.0f),
+        heatEnergy(0.0), steps(0), controlMillis(0.0) {
+    }
+
+    size_t zones() const { return airTemperature.size(); }
+};
+
+// 病虫害传播网格 - 植物按所在单元格分桶。含感染植物的单元格用位集表示，每行单元格按64位对齐，
+// 本tick需要检测的暴露单元格（感染格及其8邻域）由相邻三行的位集移位、按位或即时得到
+struct PestGrid {
+    SpatialHashGrid plants;                 // 单元格 -> 植物行（植物增删后置 bucketsStale，传播前重建）
+    int rowWords;                           // 每行单元格占用的64位字数
+    std::vector<uint64_t> infectedCells;
+    std::vector<uint32_t> infectedCount;    // 每格感染株数
+    std::vector<float> susceptibility;      // 每格未感染植株的湿度系数之和
+    bool susceptibilityStale;               // 小气候重新采样后置位，传播前整体重算
+    bool bucketsStale;                      // 种植或清除植物后置位（行号已变化）
+    size_t sprayCursor;                     // 喷洒轮转的起始位（位集下标）
+
+    PestGrid() : rowWords(0), susceptibilityStale(true), bucketsStale(true), sprayCursor(0) {}
+
+    int cellOf(float x, float z) const { return plants.cellZ(z) * plants.cellsX + plants.cellX(x); }
+    size_t bitOf(int cell) const {
+        return (size_t)(cell / plants.cellsX) * rowWords * 64 + cell % plants.cellsX;
+    }
+    void setBit(std::vector<uint64_t>& bits, size_t bit) { bits[bit >> 6] |= 1ull << (bit & 63); }
+    void clearBit(std::vector<uint64_t>& bits, size_t bit) { bits[bit >> 6] &= ~(1ull << (bit & 63)); }
+};
+
+// 传感器刷新时对所有传感器相同的参数
+struct SensorTickParams {
+    float dayFactor;
+    float outdoorTemperature;   // 露天传感器的基准值（天气时间线或气象文件）
+    float outdoorHumidity;
+    bool applyFertilizer;    // 自动施肥开启且肥料充足（按本步刷新开始时的肥料量判断）
+
+    SensorTickParams() : dayFactor(0.5f), outdoorTemperature(22.0f), outdoorHumidity(65.0f), applyFertilizer(false) {
+    }
+};
+
+// 传感器刷新中发生的事件（并行更新后按顺序输出）
+enum SensorEvent {
+    SENSOR_EVENT_FERTILIZED = 2
+};
+
+// 每个块独立的累加器 - 共享计数先在块内累加，结束后按块顺序归约到 farmStatus，
+// 浮点求和顺序因此与线程数无关
+struct TickAccumulator {
+    // 传感器刷新
+    float fertilizerUsed;
+    int channelSamples;
+    int channelReports;
+    int cleanSensors;
+    unsigned int reportedChannels;   // 本次有上报变化的通道（任一传感器）
+    // 植物内核
+    PlantKernelResult plants;
+    // 病虫害传播：本块新感染的植物行（按单元格顺序）
+    std::vector<uint32_t> newInfections;
+    // 状态统计
+    int excellentPlants;
+    int healthyPlants;
+    int sickPlants;
+    int criticalPlants;
+    int alertSensors;
+    int warningSensors;
+    int perfectSensors;
+    float totalTemp;
+    float totalHumid;
+    float totalSoil;
+    char padding[64];        // 避免相邻块的累加器落在同一缓存行
+
+    TickAccumulator() { reset(); }
+
+    void reset() {
+        fertilizerUsed = 0.0f;
+        channelSamples = 0; channelReports = 0; cleanSensors = 0; reportedChannels = 0;
+        plants.reset();
+        newInfections.clear();
+        excellentPlants = 0; healthyPlants = 0; sickPlants = 0; criticalPlants = 0;
+        alertSensors = 0; warningSensors = 0; perfectSensors = 0;
+        totalTemp = 0.0f; totalHumid = 0.0f; totalSoil = 0.0f;
+    }
+
+    void add(const TickAccumulator& other) {
+        fertilizerUsed += other.fertilizerUsed;
+        channelSamples += other.channelSamples; channelReports += other.channelReports;
+        cleanSensors += other.cleanSensors; reportedChannels |= other.reportedChannels;
+        plants.harvested += other.plants.harvested;
+        plants.harvestedRows.insert(plants.harvestedRows.end(),
+            other.plants.harvestedRows.begin(), other.plants.harvestedRows.end());
+        newInfections.insert(newInfections.end(), other.newInfections.begin(), other.newInfections.end());
+        excellentPlants += other.excellentPlants; healthyPlants += other.healthyPlants;
+        sickPlants += other.sickPlants; criticalPlants += other.criticalPlants;
+        alertSensors += other.alertSensors; warningSensors += other.warningSensors;
+        perfectSensors += other.perfectSensors;
+        totalTemp += other.totalTemp; totalHumid += other.totalHumid; totalSoil += other.totalSoil;
+    }
+};
+
+// 工作窃取线程池 - 常驻工作线程，parallelFor 把循环拆成块分发到各线程队列，
+// 线程先处理自己队列尾部的块，空闲后从其它队列头部窃取。调用线程也作为0号工作线程参与
+struct FarmThreadPool {
+    typedef std::function<void(size_t begin, size_t end, int worker)> RangeFn;
+
+    struct Chunk {
+        size_t begin;
+        size_t end;
+    };
+
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Chunk> chunks;
+    };
+
+    std::vector<std::thread> threads;
+    std::vector<std::unique_ptr<WorkQueue>> queues;   // 每个工作线程一个（含调用线程）
+    std::mutex jobMutex;
+    std::condition_variable jobReady;
+    std::condition_variable jobDone;
+    const RangeFn* currentJob;
+    unsigned long long jobGeneration;
+    std::atomic<size_t> pendingChunks;
+    int busyWorkers;
+    bool running;
+
+    FarmThreadPool() : currentJob(nullptr), jobGeneration(0), pendingChunks(0), busyWorkers(0), running(false) {}
+    ~FarmThreadPool() { stop(); }
+
+    int workerCount() const { return queues.empty() ? 1 : (int)queues.size(); }
+
+    void start(int threadCount);
+    void stop();
+    void parallelFor(size_t count, size_t chunkSize, const RangeFn& fn);
+    bool popLocal(int worker, Chunk& chunk);
+    bool steal(int worker, Chunk& chunk);
+    void runChunks(int worker);
+    void workerLoop(int worker);
+};
+
 // 建筑结构定义
 struct Building {
     glm::vec3 position;
@@ -160,9 +1215,10 @@ struct Building {
     bool hasWindows;
     glm::vec3 doorPos;
     std::vector<glm::vec3> windowPositions;
+    bool greenhouse;        // 温室（建立温室气候区，渲染为半透明）
 
     Building(const std::string& n, glm::vec3 pos, glm::vec3 s, glm::vec3 col)
-        : name(n), position(pos), size(s), color(col), hasDoor(true), hasWindows(true) {
+        : name(n), position(pos), size(s), color(col), hasDoor(true), hasWindows(true), greenhouse(false) {
     }
 };
 
@@ -193,6 +1249,242 @@ struct BezierPath {
     }
 };
 
+// 实体句柄 - 编号 + 代数。实体在列存储中移动（删除补位）后句柄仍指向同一实体；
+// 实体被删除或换代（如收获后重新种植）后代数加一，旧句柄随之失效
+struct EntityHandle {
+    uint32_t id;
+    uint32_t generation;
+
+    EntityHandle() : id(0xFFFFFFFFu), generation(0) {}
+    EntityHandle(uint32_t i, uint32_t g) : id(i), generation(g) {}
+    bool valid() const { return id != 0xFFFFFFFFu; }
+    bool operator==(const EntityHandle& other) const { return id == other.id && generation == other.generation; }
+    bool operator!=(const EntityHandle& other) const { return !(*this == other); }
+};
+
+// 句柄与存储行的双向映射 - 删除时由末行补位，各列始终保持连续；
+// 删除后的编号进入空闲表，新实体优先复用，所有操作都是 O(1)
+struct EntityIndex {
+    std::vector<uint32_t> rowOfId;        // 句柄编号 -> 行，已删除为 0xFFFFFFFF
+    std::vector<uint32_t> generationOfId; // 句柄编号 -> 当前代数
+    std::vector<uint32_t> idOfRow;        // 行 -> 句柄编号
+    std::vector<uint32_t> freeIds;        // 可复用的编号
+
+    size_t size() const { return idOfRow.size(); }
+
+    bool alive(EntityHandle h) const {
+        return h.id < rowOfId.size() && rowOfId[h.id] != 0xFFFFFFFFu && generationOfId[h.id] == h.generation;
+    }
+
+    uint32_t row(EntityHandle h) const { return rowOfId[h.id]; }
+    EntityHandle handle(size_t row) const { return EntityHandle(idOfRow[row], generationOfId[idOfRow[row]]); }
+
+    EntityHandle add() {
+        uint32_t id;
+        if (!freeIds.empty()) {
+            id = freeIds.back();
+            freeIds.pop_back();
+            rowOfId[id] = (uint32_t)idOfRow.size();
+        }
+        else {
+            id = (uint32_t)rowOfId.size();
+            rowOfId.push_back((uint32_t)idOfRow.size());
+            generationOfId.push_back(0);
+        }
+        idOfRow.push_back(id);
+        return EntityHandle(id, generationOfId[id]);
+    }
+
+    // 删除实体，返回腾出的行；调用方随后把各列末行移入该行。
+    // 句柄已失效（已删除或编号已被复用）时不做任何修改，返回 0xFFFFFFFF
+    uint32_t remove(EntityHandle h) {
+        if (!alive(h)) return 0xFFFFFFFFu;
+        uint32_t row = rowOfId[h.id];
+        uint32_t lastId = idOfRow.back();
+        idOfRow[row] = lastId;
+        rowOfId[lastId] = row;
+        idOfRow.pop_back();
+        rowOfId[h.id] = 0xFFFFFFFFu;
+        generationOfId[h.id]++;
+        freeIds.push_back(h.id);
+        return row;
+    }
+
+    // 行内实体换代（数据原地重置），返回新句柄，旧句柄失效
+    EntityHandle renew(size_t row) {
+        uint32_t id = idOfRow[row];
+        generationOfId[id]++;
+        return EntityHandle(id, generationOfId[id]);
+    }
+
+    void clear() {
+        rowOfId.clear();
+        generationOfId.clear();
+        idOfRow.clear();
+        freeIds.clear();
+    }
+};
+
+// 用末行覆盖指定行并缩短一列
+template<typename T>
+inline void swapRemoveRow(std::vector<T>& column, size_t row) {
+    column[row] = std::move(column.back());
+    column.pop_back();
+}
+
+// 植物形态数据 - 初始化后只读，渲染和事件输出读取
+struct PlantShapeColumns {
+    std::vector<glm::vec3> position;
+    std::vector<float> height;
+    std::vector<float> stemRadius;
+    std::vector<float> leafSize;
+    std::vector<float> rootSpread;           // 根系扩展范围
+    std::vector<float> windPhase;
+    std::vector<float> leafColorB;           // 叶片初始蓝色分量（模拟只更新红绿分量）
+    std::vector<glm::vec3> stemColor;
+    std::vector<unsigned char> leafCount;    // 不超过 maxLeavesPerPlant
+    std::vector<unsigned char> plantType;    // cropTable 下标，植物按作物分批连续存放
+};
+
+// 植物小气候采样权重 - 最近几个传感器及反距离权重（和为1），种植时算好，每tick按表收集
+const int microclimateNeighbors = 4;
+struct SensorWeights {
+    uint32_t sensor[microclimateNeighbors];
+    float weight[microclimateNeighbors];
+};
+
+// 植物所在位置的采样表 - 种植时确定，之后只读（传感器布局变化后需重新计算）
+struct PlantSiteColumns {
+    std::vector<SensorWeights> sensorWeights;
+    std::vector<uint32_t> soilCell;          // 所在土壤网格单元格
+};
+
+// 黄金角螺旋叶序表 - 所有植物共享，第j片叶的方位只取决于j
+const int maxLeavesPerPlant = 32;
+struct LeafSpiralTable {
+    float cosAngle[maxLeavesPerPlant];
+    float sinAngle[maxLeavesPerPlant];
+
+    LeafSpiralTable() {
+        for (int j = 0; j < maxLeavesPerPlant; j++) {
+            float angle = j * 137.5f * 3.14159f / 180.0f; // 黄金角度螺旋
+            cosAngle[j] = std::cos(angle);
+            sinAngle[j] = std::sin(angle);
+        }
+    }
+};
+const LeafSpiralTable leafSpiral;
+
+// 单片叶子的位置和大小
+struct LeafLayout {
+    glm::vec3 position;
+    float size;
+};
+
+// 按需计算第 leafIndex 片叶子的布局，完全由植株形态参数决定，不再为每株植物保存叶片数组
+inline LeafLayout computeLeafLayout(const glm::vec3& base, int leafIndex, int leafCount,
+    float leafSize, float height, float growthStage, float healthFactor) {
+    float heightRatio = (float)(leafIndex + 1) / (leafCount + 1);
+    float radius = leafSize * (1.0f + heightRatio * 0.5f);
+    LeafLayout leaf;
+    leaf.position = base + glm::vec3(
+        leafSpiral.cosAngle[leafIndex] * radius,
+        height * heightRatio * growthStage,
+        leafSpiral.sinAngle[leafIndex] * radius
+    );
+    leaf.size = leafSize * (0.7f + heightRatio * 0.5f) * healthFactor;
+    return leaf;
+}
+
+// 植物原型：模拟热数据、采样表、形态数据分列存放，同一行是同一株植物。
+// 种植、收获重种、清除都是 O(1)；收获的植物在原行换代，清除的编号和各列容量留给新种植复用
+struct PlantArchetype {
+    EntityIndex index;
+    PlantColumns sim;            // 植物内核和状态统计只读写这里
+    PlantSiteColumns site;
+    PlantShapeColumns shape;
+
+    size_t size() const { return index.size(); }
+    bool alive(EntityHandle handle) const { return index.alive(handle); }
+    void reserve(size_t count);
+    EntityHandle add(const DetailedPlant& plant);      // 新种植
+    EntityHandle replant(size_t row);                  // 收获后原地重新种植，返回新句柄
+    bool remove(EntityHandle handle);                  // 清除（枯死），句柄已失效时返回 false
+    void clear();
+};
+
+// 传感器原型：读数（热）、显示数据、位置（冷）分列存放
+struct SensorArchetype {
+    EntityIndex index;
+    std::vector<SensorReadings> readings;      // 上报值（死区过滤后），下游只读这一列
+    std::vector<SensorReadings> measured;      // 探头最近的测量值（模拟和实测都先写入这里）
+    std::vector<SensorReportState> report;
+    std::vector<SensorDisplay> display;
+    std::vector<glm::vec3> position;
+
+    size_t size() const { return index.size(); }
+
+    EntityHandle add(const glm::vec3& pos) {
+        readings.push_back(SensorReadings());
+        measured.push_back(SensorReadings());
+        report.push_back(SensorReportState());
+        display.push_back(SensorDisplay());
+        position.push_back(pos);
+        return index.add();
+    }
+
+    // 删除传感器，句柄已失效时返回 false
+    bool remove(EntityHandle handle) {
+        uint32_t row = index.remove(handle);
+        if (row == 0xFFFFFFFFu) return false;
+        swapRemoveRow(readings, row);
+        swapRemoveRow(measured, row);
+        swapRemoveRow(report, row);
+        swapRemoveRow(display, row);
+        swapRemoveRow(position, row);
+        return true;
+    }
+
+    void clear() {
+        index.clear();
+        readings.clear();
+        measured.clear();
+        report.clear();
+        display.clear();
+        position.clear();
+    }
+};
+
+// 建筑原型：布局查询只读位置列，外形和名称等冷数据只有渲染读取
+struct BuildingArchetype {
+    EntityIndex index;
+    std::vector<glm::vec3> position;
+    std::vector<Building> detail;
+
+    size_t size() const { return index.size(); }
+
+    EntityHandle add(const Building& building) {
+        position.push_back(building.position);
+        detail.push_back(building);
+        return index.add();
+    }
+
+    // 删除建筑，句柄已失效时返回 false
+    bool remove(EntityHandle handle) {
+        uint32_t row = index.remove(handle);
+        if (row == 0xFFFFFFFFu) return false;
+        swapRemoveRow(position, row);
+        swapRemoveRow(detail, row);
+        return true;
+    }
+
+    void clear() {
+        index.clear();
+        position.clear();
+        detail.clear();
+    }
+};
+
 // 增强农场状态监控 - 添加灌溉系统
 struct FarmStatus {
     int healthyPlants;
@@ -231,6 +1523,53 @@ struct FarmStatus {
     }
 };
 
+// 固定步长模拟时钟 - 模拟与渲染帧率解耦
+struct SimulationClock {
+    double simTime;            // 累计模拟时间（秒）
+    double accumulator;        // 待模拟的时间积压
+    float fixedStep;           // 固定模拟步长
+    float timeWarp;            // 时间加速倍数 (1x-1000x)
+    int maxStepsPerFrame;      // 每帧最多追赶的步数（批量上限）
+    int maxSkippedFrames;      // 连续跳过渲染的最大帧数
+    float maxFrameDelta;       // 单帧最长计入时间，防止调试暂停等造成巨大积压
+    float alpha;               // 渲染插值系数 (0-1)
+    long long totalSteps;
+    int skippedFrames;         // 当前连续跳过的渲染帧
+    long long droppedFrames;   // 为保证模拟精度而放弃的渲染帧总数
+    double lastClimateLog;     // 温室气候日志输出计时（模拟时间）
+    double lastStatusUpdate;   // 农场状态统计计时（模拟时间）
+    double lastStatusReport;   // 状态汇总输出计时（模拟时间）
+    double lastSoilUpdate;     // 土壤场步进计时（模拟时间）
+    double lastPestSpread;     // 病虫害传播步进计时（模拟时间）
+    double lastPestSpray;      // 病虫防治喷洒计时（模拟时间）
+    double lastPlantCull;      // 枯死植物清除计时（模拟时间）
+    double lastEtForecast;     // 蒸散需水预报刷新计时（模拟时间）
+
+    SimulationClock() : simTime(0.0), accumulator(0.0), fixedStep(1.0f / 60.0f), timeWarp(1.0f),
+        maxStepsPerFrame(1200), maxSkippedFrames(4), maxFrameDelta(0.25f), alpha(0.0f),
+        totalSteps(0), skippedFrames(0), droppedFrames(0),
+        lastClimateLog(0.0), lastStatusUpdate(0.0), lastStatusReport(0.0), lastSoilUpdate(0.0), lastPestSpread(0.0), lastPestSpray(0.0), lastPlantCull(0.0), lastEtForecast(0.0) {
+    }
+};
+
+// 渲染插值用的模拟状态快照
+struct RenderSnapshot {
+    glm::vec3 lightPos;
+    glm::vec3 lightColor;
+    glm::vec2 windDirection;
+    float windStrength;
+    float cloudCoverage;
+    float precipitation;
+    float fogDensity;
+    glm::vec3 fogColor;
+
+    RenderSnapshot() : lightPos(10.0f, 15.0f, 10.0f), lightColor(1.0f, 0.95f, 0.8f),
+        windDirection(1.0f, 0.3f), windStrength(0.4f), cloudCoverage(0.3f), precipitation(0.0f),
+        fogDensity(0.02f), fogColor(0.8f, 0.8f, 0.9f) {
+    }
+};
+
+#ifndef FARM_HEADLESS
 // 增强着色器源码 - 优化天气效果
 const char* vertexShaderSource = R"(
 #version 120
@@ -428,21 +1767,78 @@ void main() {
     gl_FragColor = vec4(color, alpha);
 }
 )";
+#endif
 
 // 全局变量
+#ifndef FARM_HEADLESS
 GLuint shaderProgram = 0;
 std::vector<RenderObject> renderObjects;
-std::vector<SensorData> sensors;
-std::vector<DetailedPlant> plants;
-std::vector<Building> buildings;
-std::vector<BezierPath> paths;
+GLFWwindow* g_window = nullptr;
+bool useVAO = false;
+#endif
+SensorArchetype sensorStore;
+PlantArchetype plantStore;
+BuildingArchetype buildingStore;
+PlantKernelFn plantKernels[cropHabitCount] = { nullptr, nullptr, nullptr };   // 按作物习性特化
+std::vector<CropSpec> cropTable;                  // 内置作物 + --crops 文件追加的作物
+std::vector<PlantKernelParams> cropKernelParams;  // 每tick每种作物一份内核参数
+std::vector<PlantBatch> plantBatches;             // 按行顺序的作物批次
+bool plantBatchesStale = true;                    // 增删植物后置位，下一个植物tick重新分批
+const float plantDeathHealth = 0.5f;              // 枯死阈值：小气候完全不适宜时的健康上限
+const float plantDeathSeconds = 90.0f;            // 健康持续处于枯死阈值一个模拟日即枯死
+int culledPlants = 0;                             // 累计清除的枯死植物
+PlantKernelLevel plantKernelLevel = PLANT_KERNEL_SCALAR;
+SoilGrid soilGrid;
+SpatialHashGrid sensorLocator;   // 传感器位置空间哈希（单元格为传感器间距）
+bool microclimateStale = true;   // 传感器或土壤网格更新后置位，下一个植物tick重新采样
+PestGrid pestGrid;
+SoilRowFn soilRowKernel = nullptr;
+EtForecast etForecast;
+EtForecastFn etForecastKernel = nullptr;
+IrrigationSchedule irrigationSchedule;
+PipeNetwork pipeNetwork;
+GreenhouseZones greenhouseZones;
+ClimateLoopFn climateLoopKernel = nullptr;
+LineScanFn lineScanKernel = nullptr;
+FarmThreadPool threadPool;
+std::vector<TickAccumulator> chunkAccumulators;   // 按块下标，块划分与线程数无关
+TickAccumulator chunkTotal;                       // 归约结果，常驻复用（行列表保留容量）
+std::vector<unsigned char> sensorEvents;          // 按行，本步传感器刷新的事件标记
+uint64_t simulationSeed = 0;                      // 所有随机流的主种子
+
+// 并行循环块大小（植物块为8的倍数，保证SIMD主循环连续）
+const size_t sensorChunkSize = 256;
+const size_t plantChunkSize = 16384;
+const size_t statusChunkSize = 65536;
+const size_t soilRowChunkSize = 16;      // 土壤网格按行分块
+const double soilStepSeconds = 0.5;      // 土壤场步长（模拟时间）
+const size_t pestRowChunkSize = 16;      // 病虫害网格按行分块
+const size_t etZoneChunkSize = 256;      // 蒸散预报按区域分块
+const size_t pipeRowChunkSize = 16;      // 灌溉管网按喷头行分块
+const double psiToMetres = 0.70307;      // 1 PSI 对应的水头（m）
+const float rootZoneDepthMm = 300.0f;    // 根区土层深度：1mm 蒸散使土壤含水量下降 100/300 个百分点
+const double pestStepSeconds = 1.0;      // 病虫害传播步长（模拟时间）
+const float pestCellSize = 2.0f;         // 病虫害网格单元边长（约为相邻植株间的传播距离）
+std::vector<BezierPath> paths;   // 只有渲染使用的路径曲线
 WeatherSystem weather;
+WeatherTimeline weatherTimeline;
+WeatherFileSource weatherFile;
+SensorIngest sensorIngest;
+SensorReportStats sensorReportStats;
+SensorSampleSchedule sensorSchedule;
+const size_t sensorRingCapacity = 1 << 17;      // 读数队列容量（约两帧的满速接入量）
+const double liveSensorTimeout = 10.0;          // 超过该模拟时间没有实测值的通道恢复由模拟生成
+const char* const sensorFieldNames[SENSOR_CHANNELS] = { "temp", "hum", "soil", "ph", "n", "p", "k", "light" };
+const size_t weatherReadAhead = 256;   // 气象文件预读缓冲上限（小时）
 FarmStatus farmStatus; // 新增
-float systemTime = 0.0f;
+SimulationClock simClock;
+RenderSnapshot previousSnapshot;  // 上一模拟步结束时的状态
+RenderSnapshot currentSnapshot;   // 最新模拟步结束时的状态
+RenderSnapshot renderState;       // 按插值系数混合后供渲染使用
+float systemTime = 0.0f;          // 墙钟时间，仅用于渲染动画
 float cameraAngle = 0.0f;
 bool isInitialized = false;
-GLFWwindow* g_window = nullptr;
-bool useVAO = false;
+bool simEventLog = true; // 是否输出逐条模拟事件（无窗口高速运行时关闭）
 
 // 摄像机控制 - 优化
 glm::vec3 cameraPos = glm::vec3(15.0f, 8.0f, 15.0f);
@@ -459,6 +1855,12 @@ bool freeCamera = false;
 glm::vec2 windDirection = glm::vec2(1.0f, 0.3f);
 float windStrength = 0.4f;
 float dayNightCycle = 0.0f;
+const float dayLengthSeconds = 90.0f; // 一个模拟日（昼夜周期）的秒数
+// 各通道默认采样周期（模拟秒）：气温、湿度和光照每秒，土壤湿度每2秒，pH每模拟小时，氮磷钾每模拟日
+const float defaultSamplePeriod[SENSOR_CHANNELS] = { 1.0f, 1.0f, 2.0f, dayLengthSeconds / 24.0f,
+    dayLengthSeconds, dayLengthSeconds, dayLengthSeconds, 1.0f };
+const float cropDaysPerSimDay = 16.0f; // 作物日历压缩：每个模拟日推进的作物生长天数（积温按此累计）
+const int weatherSeasonDays = 12;      // 天气时间线长度（模拟日），约为180天的作物生长季
 
 // 光照参数
 glm::vec3 lightPos = glm::vec3(10.0f, 15.0f, 10.0f);
@@ -468,21 +1870,201 @@ glm::vec3 lightColor = glm::vec3(1.0f, 0.95f, 0.8f);
 bool showUI = true;
 bool showDetailedStats = false;
 
+// 农场规模配置 - 田地范围、种植密度、传感器和喷头间距，初始化与场景生成都按此执行
+struct FarmConfig {
+    int targetPlants;          // 目标植物数，0表示按密度和田地面积计算
+    float plantDensity;        // 每平方米植物数（默认300株/36m×36m）
+    float fieldHalfExtent;     // 种植区半边长（米），0表示按目标植物数自动计算
+    float plantSpacing;        // 植物间最小距离
+    float sensorPitch;         // 传感器网格间距
+    float nozzleSpacing;       // 喷头网格间距
+    float buildingClearance;   // 建筑周围禁种半径
+    float sensorClearance;     // 传感器周围禁种半径
+    float soilCellSize;        // 土壤网格单元边长
+
+    FarmConfig() : targetPlants(0), plantDensity(300.0f / (36.0f * 36.0f)), fieldHalfExtent(0.0f),
+        plantSpacing(1.0f), sensorPitch(7.0f), nozzleSpacing(4.0f),
+        buildingClearance(7.0f), sensorClearance(2.0f), soilCellSize(1.0f) {
+    }
+
+    float nozzleHalfExtent() const { return fieldHalfExtent + 2.0f; }   // 喷头网覆盖田地并略超出边缘
+    float groundHalfExtent() const { return fieldHalfExtent + 32.0f; }  // 地面、道路和围栏范围
+};
+FarmConfig farmConfig;
+
+// 运行模式参数（命令行）
+struct RunOptions {
+    bool headless;     // 无窗口模拟
+    float simDays;     // 无窗口模式运行的模拟天数
+    bool verbose;      // 无窗口模式下仍输出逐条事件
+    float timeWarp;    // 窗口模式初始时间加速倍数
+    int plantKernel;   // 强制植物内核级别，-1为自动检测
+    int threadCount;   // 模拟线程数，0为自动（CPU核心数）
+    bool hasSeed;      // 是否指定了随机种子（否则每次运行随机生成并打印）
+    unsigned long long seed;
+    long long hashAtStep; // 在该模拟步后打印状态哈希，-1为不打印
+    FarmConfig farm;      // 农场规模（--plants/--field/--density/--sensor-pitch/--nozzle-spacing/--soil-cell）
+    std::string cropFile; // 追加作物定义的文件（--crops），空为只用内置作物
+    std::string weatherFile; // 逐小时气象文件（--weather-file，EPW 或 CSV），空为使用生成的天气时间线
+    std::vector<std::string> ingestEndpoints; // 实测读数接入端点（--ingest udp:端口 / unix:路径，可重复）
+    std::string replayTarget;  // 回放模式（--replay udp:主机:端口 / unix:路径）：代替网关发送合成读数
+    double replayRate;         // 回放速率（读数/秒）
+    double replaySeconds;      // 回放时长（秒）
+    int replaySensors;         // 回放的传感器编号数
+    TelemetryFormat replayFormat; // 回放数据格式（--replay-format binary|text|delta）
+    double benchLineGigabytes; // 行协议解析基准的处理量（--bench-line-protocol GB），0为不运行
+    std::string convertInput;  // 转换工具（--convert 输入 输出）：增量帧文件与行协议文本互转，按输入内容判断方向
+    std::string convertOutput;
+    int frameBytes;            // 增量帧的最大字节数（--frame-bytes，默认为 LoRa 单包上限）
+    float deadband[SENSOR_CHANNELS];   // 例外上报死区（--deadband temp=0.5,hum=2,... 或 off）
+    float hysteresis[SENSOR_CHANNELS]; // 反向变化额外需要超过的回差（--hysteresis，格式同上）
+    float samplePeriod[SENSOR_CHANNELS]; // 各通道采样周期，模拟秒（--sample-period temp=1,ph=3.75,...）
+
+    RunOptions() : headless(false), simDays(1.0f), verbose(false), timeWarp(1.0f), plantKernel(-1), threadCount(0),
+        hasSeed(false), seed(0), hashAtStep(-1), replayRate(100000.0), replaySeconds(10.0), replaySensors(25),
+        replayFormat(TELEMETRY_BATCH), benchLineGigabytes(0.0), frameBytes(222) {
+        for (int c = 0; c < SENSOR_CHANNELS; c++) {
+            deadband[c] = defaultSensorDeadband[c];
+            hysteresis[c] = defaultSensorHysteresis[c];
+            samplePeriod[c] = defaultSamplePeriod[c];
+        }
+    }
+};
+RunOptions runOptions;
+
 // 函数声明
-bool initializeOpenGL();
-bool createShaderProgram();
-GLuint compileShader(GLenum type, const char* source);
-void generateDetailedFarm();
+bool parseRunOptions(int argc, char* argv[], RunOptions& options);
+bool parseChannelSettings(const std::string& spec, float* values);
+bool parsePositiveOption(const std::string& arg, const char* text, double& value);
+int runHeadlessSimulation(const RunOptions& options);
+int runSensorReplay(const RunOptions& options);
+int runLineProtocolBenchmark(const RunOptions& options);
+int runTelemetryConversion(const RunOptions& options);
+void initializeFarmSystems();
+void resolveFarmConfig(FarmConfig& config);
 void createDetailedBuildings();
 void initializeAdvancedSensorNetwork();
+void initializeCropTable(const std::string& cropFile);
+bool parseCropDefinition(const std::string& line, CropSpec& crop);
 void initializeDetailedPlants();
+void rebuildPlantBatches();
+void initializeSoilGrid();
+int findNearestSensors(float x, float z, int count, uint32_t* rows, float* distance2);
+void computeSensorWeights(float x, float z, SensorWeights& weights);
+void samplePlantMicroclimate(size_t begin, size_t end);
+void initializePestGrid();
+size_t rebuildPestGrid();
+void cullDeadPlants();
+float pestCellSusceptibility(int cell);
+void stepPestSpread(float dt);
+void sprayPestFootprints();
+std::vector<glm::vec2> samplePoissonDisk(float minX, float minZ, float maxX, float maxZ, float spacing,
+    const std::vector<ExclusionZone>& zones, PhiloxStream& rng);
+PlantKernelLevel detectPlantKernelLevel();
+void selectPlantKernel(int requestedLevel);
+template<CropHabit Habit>
+void updatePlantsScalar(PlantColumns& columns, size_t begin, size_t end,
+    const PlantKernelParams& params, PlantKernelResult& result);
+template<CropHabit Habit>
+void updatePlantsSSE2(PlantColumns& columns, size_t begin, size_t end,
+    const PlantKernelParams& params, PlantKernelResult& result);
+template<CropHabit Habit>
+FARM_TARGET_AVX2
+void updatePlantsAVX2(PlantColumns& columns, size_t begin, size_t end,
+    const PlantKernelParams& params, PlantKernelResult& result);
+void selectSoilKernel(PlantKernelLevel level);
+void stepSoilRowScalar(SoilGrid& grid, int z, const SoilStepParams& params);
+void stepSoilRowSSE2(SoilGrid& grid, int z, const SoilStepParams& params);
+void stepSoilRowAVX2(SoilGrid& grid, int z, const SoilStepParams& params);
+void stepSoilGrid(float dt, float dayFactor);
+float cropCoefficient(const CropSpec& crop, float growth);
+void initializeEtForecast();
+void forecastEtZonesScalar(EtForecast& forecast, size_t begin, size_t end);
+void forecastEtZonesSSE2(EtForecast& forecast, size_t begin, size_t end);
+void forecastEtZonesAVX2(EtForecast& forecast, size_t begin, size_t end);
+void selectEtKernel(PlantKernelLevel level);
+void refreshEtForecast();
+void initializeIrrigationSchedule();
+bool fitIrrigationSlot(const IrrigationSchedule& schedule, uint32_t valve, int t, float maxFlow);
+void placeIrrigationWindow(IrrigationSchedule& schedule, uint32_t valve, int slots, float maxFlow);
+void solveIrrigationSchedule();
+void applyIrrigationSlot(float dt);
+PipeLaw makePipeLaw(double resistance, double exponent);
+void initializePipeNetwork();
+double evaluatePipeNetwork();
+void balancePipeNetworkHead();
+void buildPipeLevels();
+void smoothPipeLevel(PipeLevel& level, int color);
+void pipeVCycle(size_t l);
+int solvePipeNetworkStep(double tolerance);
+void solvePipeNetwork();
+float saturationVapourDensity(float t);
+void initializeGreenhouseZones();
+void updateClimateLoopsScalar(ClimateLoops& loops, size_t begin, size_t end, float dt);
+void updateClimateLoopsSSE2(ClimateLoops& loops, size_t begin, size_t end, float dt);
+void updateClimateLoopsAVX2(ClimateLoops& loops, size_t begin, size_t end, float dt);
+void selectClimateKernel(PlantKernelLevel level);
+void stepGreenhouseZones(float deltaTime);
 void createBezierPaths();
+void initializeWeatherTimeline();
+void generateWeatherTimeline(size_t firstHour, int firstType);
+size_t weatherTimelineHour(double simTime);
+void applyWeatherTimeline(double simTime);
+bool openWeatherFile(const std::string& path);
+bool readWeatherRecord(WeatherFileSource& source, WeatherRecord& record, int& hour);
+void refillWeatherFile();
+void applyWeatherFile(double simTime);
+bool initializeFarmSockets();
+FarmSocket openIngestSocket(const std::string& endpoint);
+FarmSocket openReplaySocket(const std::string& target, sockaddr_storage& address, socklen_t& length);
+bool startSensorIngest(const std::vector<std::string>& endpoints);
+void stopSensorIngest();
+void runSensorIngestThread();
+size_t decodeSensorBatch(const char* data, size_t size, size_t source);
+void pushSensorSamples(const SensorSample* samples, size_t count);
+const char* findLineEndScalar(const char* begin, const char* end);
+const char* findLineEndSSE2(const char* begin, const char* end);
+FARM_TARGET_AVX2
+const char* findLineEndAVX2(const char* begin, const char* end);
+void selectLineScanKernel(PlantKernelLevel level);
+int sensorFieldChannel(const char* name, size_t length);
+bool parseTextNumber(const char*& p, const char* end, double& value);
+bool parseSensorLine(const char* p, const char* end, SensorSample& sample);
+size_t parseSensorLines(const char* data, size_t size, bool final, std::vector<SensorSample>& out, LineParseStats& stats);
+size_t formatSensorLine(char* out, size_t capacity, const SensorSample& sample, unsigned long long timestamp);
+size_t encodeSensorFrame(SensorDeltaCodec& codec, const SensorSample* samples, size_t count,
+    unsigned char* out, size_t capacity, size_t& written);
+size_t measureSensorFrame(const unsigned char* data, size_t size);
+size_t decodeSensorFrame(SensorDeltaCodec& codec, const unsigned char* data, size_t size, std::vector<SensorSample>& out);
+void drainSensorIngest();
+void stepFarmSimulation(float step);
+int advanceSimulationClock(float frameDelta);
+RenderSnapshot captureRenderSnapshot();
+RenderSnapshot interpolateRenderSnapshot(const RenderSnapshot& a, const RenderSnapshot& b, float t);
+void startSimulationThreads(int threadCount);
+void prepareChunkAccumulators(size_t count, size_t chunkSize);
+const TickAccumulator& reduceChunkAccumulators();
+uint64_t hashSimulationState();
+void printStateHash();
+void initializeSensorSchedule();
+void sampleSensorChannels();
+void updateSensorReading(size_t row, unsigned int due, const SensorTickParams& params,
+    TickAccumulator& acc, unsigned char& events);
+unsigned int reportSensorChannels(size_t row, unsigned int channels);
+void refreshSensorDisplay(size_t row);
 void updateFarmSimulation(float deltaTime);
+TickAccumulator refreshFarmStatistics();
 void updateFarmStatus(); // 新增
 void printUIInfo(); // 新增
+void printCropSummary();
+#ifndef FARM_HEADLESS
+bool initializeOpenGL();
+bool createShaderProgram();
+GLuint compileShader(GLenum type, const char* source);
+void generateDetailedFarm();
 void addDetailedCube(RenderObject& obj, glm::vec3 center, glm::vec3 size, glm::vec3 color,
     glm::vec3 normal = glm::vec3(0, 1, 0), float material = 0.0f);
-void createDetailedPlantGeometry(RenderObject& obj, const DetailedPlant& plant);
+void createDetailedPlantGeometry(RenderObject& obj, const PlantArchetype& store, size_t row);
 void createBuildingGeometry(RenderObject& obj, const Building& building);
 void addCylinder(RenderObject& obj, glm::vec3 bottom, glm::vec3 top, float radius,
     glm::vec3 color, int segments = 8, float material = 0.0f);
@@ -494,7 +2076,9 @@ void render();
 void updateCamera();
 void updateLighting();
 void checkOpenGLError(const char* operation);
+#endif
 
+#ifndef FARM_HEADLESS
 // 辅助函数
 void errorCallback(int error, const char* description) {
     std::cout << "GLFW Error " << error << ": " << description << std::endl;
@@ -566,9 +2150,16 @@ void processInput(GLFWwindow* window) {
     // 天气控制 - 修复按键
     static bool wKeyPressed = false;
     if (glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS && !wKeyPressed) {
-        weather.weatherType = (weather.weatherType + 1) % 4;
-        const char* weatherNames[] = { "Sunny", "Cloudy", "Rainy", "Stormy" };
-        std::cout << "Weather changed to: " << weatherNames[weather.weatherType] << std::endl;
+        if (weatherFile.active()) {
+            std::cout << "Weather is replayed from " << weatherFile.path << " - T has no effect" << std::endl;
+        }
+        else {
+            generateWeatherTimeline(weatherTimelineHour(simClock.simTime), (weather.weatherType + 1) % 4);
+            applyWeatherTimeline(simClock.simTime);
+            const char* weatherNames[] = { "Sunny", "Cloudy", "Rainy", "Stormy" };
+            std::cout << "Weather changed to: " << weatherNames[weather.weatherType]
+                << " (timeline regenerated from this hour)" << std::endl;
+        }
         wKeyPressed = true;
     }
     if (glfwGetKey(window, GLFW_KEY_T) == GLFW_RELEASE) {
@@ -601,6 +2192,7 @@ void processInput(GLFWwindow* window) {
     static bool f1KeyPressed = false;
     if (glfwGetKey(window, GLFW_KEY_F1) == GLFW_PRESS && !f1KeyPressed) {
         farmStatus.autoIrrigation = !farmStatus.autoIrrigation;
+        irrigationSchedule.dirty = true;
         std::cout << "Auto Irrigation: " << (farmStatus.autoIrrigation ? "ON" : "OFF") << std::endl;
         f1KeyPressed = true;
     }
@@ -667,26 +2259,31 @@ void processInput(GLFWwindow* window) {
     static bool numKeyPressed = false;
     if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS && !numKeyPressed) {
         farmStatus.irrigationIntensity = 1;
+        irrigationSchedule.dirty = true;
         std::cout << "Irrigation Intensity: Low (1/5)" << std::endl;
         numKeyPressed = true;
     }
     if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS && !numKeyPressed) {
         farmStatus.irrigationIntensity = 2;
+        irrigationSchedule.dirty = true;
         std::cout << "Irrigation Intensity: Medium-Low (2/5)" << std::endl;
         numKeyPressed = true;
     }
     if (glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS && !numKeyPressed) {
         farmStatus.irrigationIntensity = 3;
+        irrigationSchedule.dirty = true;
         std::cout << "Irrigation Intensity: Medium (3/5)" << std::endl;
         numKeyPressed = true;
     }
     if (glfwGetKey(window, GLFW_KEY_4) == GLFW_PRESS && !numKeyPressed) {
         farmStatus.irrigationIntensity = 4;
+        irrigationSchedule.dirty = true;
         std::cout << "Irrigation Intensity: Medium-High (4/5)" << std::endl;
         numKeyPressed = true;
     }
     if (glfwGetKey(window, GLFW_KEY_5) == GLFW_PRESS && !numKeyPressed) {
         farmStatus.irrigationIntensity = 5;
+        irrigationSchedule.dirty = true;
         std::cout << "Irrigation Intensity: High (5/5)" << std::endl;
         numKeyPressed = true;
     }
@@ -698,6 +2295,23 @@ void processInput(GLFWwindow* window) {
         numKeyPressed = false;
     }
 
+    // 时间加速调节 [ / ]
+    static bool warpKeyPressed = false;
+    static const float warpLevels[] = { 1.0f, 2.0f, 5.0f, 10.0f, 20.0f, 50.0f, 100.0f, 200.0f, 500.0f, 1000.0f };
+    bool warpDown = glfwGetKey(window, GLFW_KEY_LEFT_BRACKET) == GLFW_PRESS;
+    bool warpUp = glfwGetKey(window, GLFW_KEY_RIGHT_BRACKET) == GLFW_PRESS;
+    if ((warpDown || warpUp) && !warpKeyPressed) {
+        int level = 0;
+        while (level < 9 && warpLevels[level] < simClock.timeWarp) level++;
+        level = warpUp ? std::min(level + 1, 9) : std::max(level - 1, 0);
+        simClock.timeWarp = warpLevels[level];
+        std::cout << "Time Warp: " << (int)simClock.timeWarp << "x" << std::endl;
+        warpKeyPressed = true;
+    }
+    if (!warpDown && !warpUp) {
+        warpKeyPressed = false;
+    }
+
     // 种植模式切换
     static bool mKeyPressed = false;
     if (glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS && !mKeyPressed) {
@@ -755,9 +2369,186 @@ void checkOpenGLError(const char* operation) {
         std::cout << "OpenGL Error in " << operation << ": " << error << std::endl;
     }
 }
+#endif
+
+// 解析按通道的设置 "temp=0.5,hum=2"（字段名同行协议），"off" 全部置0；未列出的通道保持原值
+bool parseChannelSettings(const std::string& spec, float* values) {
+    if (spec == "off") {
+        for (int c = 0; c < SENSOR_CHANNELS; c++) values[c] = 0.0f;
+        return true;
+    }
+    std::stringstream stream(spec);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        size_t equals = item.find('=');
+        if (equals == std::string::npos) return false;
+        int channel = sensorFieldChannel(item.c_str(), equals);
+        if (channel < 0) return false;
+        values[channel] = std::max(0.0f, (float)atof(item.c_str() + equals + 1));
+    }
+    return true;
+}
+
+// 解析取正数的选项值（数量、尺寸），非数字或不为正时输出错误并返回 false
+bool parsePositiveOption(const std::string& arg, const char* text, double& value) {
+    char* end = nullptr;
+    value = strtod(text, &end);
+    if (end == text || *end != '\0' || !(value > 0.0)) {
+        std::cout << arg << " must be positive (got " << text << ")" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// 解析命令行参数
+bool parseRunOptions(int argc, char* argv[], RunOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--headless") {
+            options.headless = true;
+        }
+        else if (arg == "--days" && i + 1 < argc) {
+            options.simDays = (float)atof(argv[++i]);
+        }
+        else if (arg == "--verbose") {
+            options.verbose = true;
+        }
+        else if (arg == "--warp" && i + 1 < argc) {
+            options.timeWarp = clamp((float)atof(argv[++i]), 1.0f, 1000.0f);
+        }
+        else if (arg == "--kernel" && i + 1 < argc) {
+            std::string level = argv[++i];
+            if (level == "scalar") options.plantKernel = PLANT_KERNEL_SCALAR;
+            else if (level == "sse2") options.plantKernel = PLANT_KERNEL_SSE2;
+            else if (level == "avx2") options.plantKernel = PLANT_KERNEL_AVX2;
+            else options.plantKernel = -1;
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            options.threadCount = std::max(0, atoi(argv[++i]));
+        }
+        else if (arg == "--seed" && i + 1 < argc) {
+            options.hasSeed = true;
+            options.seed = strtoull(argv[++i], nullptr, 0);
+        }
+        else if (arg == "--hash-at" && i + 1 < argc) {
+            options.hashAtStep = atoll(argv[++i]);
+        }
+        else if ((arg == "--plants" || arg == "--field" || arg == "--density" || arg == "--sensor-pitch" ||
+            arg == "--nozzle-spacing" || arg == "--soil-cell") && i + 1 < argc) {
+            double value;
+            if (!parsePositiveOption(arg, argv[++i], value)) return false;
+            if (arg == "--plants") {
+                if (value != std::floor(value) || value > 100000000.0) {
+                    std::cout << "--plants must be a whole number of plants (got " << argv[i] << ")" << std::endl;
+                    return false;
+                }
+                options.farm.targetPlants = (int)value;
+            }
+            else if (arg == "--field") options.farm.fieldHalfExtent = (float)value * 0.5f;
+            else if (arg == "--density") options.farm.plantDensity = std::max(0.001f, (float)value);
+            else if (arg == "--sensor-pitch") options.farm.sensorPitch = std::max(1.0f, (float)value);
+            else if (arg == "--nozzle-spacing") options.farm.nozzleSpacing = std::max(0.5f, (float)value);
+            else options.farm.soilCellSize = std::max(0.1f, (float)value);
+        }
+        else if (arg == "--crops" && i + 1 < argc) {
+            options.cropFile = argv[++i];
+        }
+        else if (arg == "--weather-file" && i + 1 < argc) {
+            options.weatherFile = argv[++i];
+        }
+        else if (arg == "--ingest" && i + 1 < argc) {
+            options.ingestEndpoints.push_back(argv[++i]);
+        }
+        else if (arg == "--replay" && i + 1 < argc) {
+            options.replayTarget = argv[++i];
+        }
+        else if (arg == "--replay-rate" && i + 1 < argc) {
+            options.replayRate = std::max(1.0, atof(argv[++i]));
+        }
+        else if (arg == "--replay-seconds" && i + 1 < argc) {
+            options.replaySeconds = std::max(0.1, atof(argv[++i]));
+        }
+        else if (arg == "--replay-sensors" && i + 1 < argc) {
+            options.replaySensors = std::max(1, atoi(argv[++i]));
+        }
+        else if (arg == "--replay-format" && i + 1 < argc) {
+            std::string format = argv[++i];
+            if (format == "text") options.replayFormat = TELEMETRY_TEXT;
+            else if (format == "delta") options.replayFormat = TELEMETRY_DELTA;
+            else options.replayFormat = TELEMETRY_BATCH;
+        }
+        else if (arg == "--convert" && i + 2 < argc) {
+            options.convertInput = argv[++i];
+            options.convertOutput = argv[++i];
+        }
+        else if (arg == "--frame-bytes" && i + 1 < argc) {
+            options.frameBytes = std::min(std::max(atoi(argv[++i]), (int)(sensorFrameHeaderMax + sensorFrameRecordMax)), 65000);
+        }
+        else if ((arg == "--deadband" || arg == "--hysteresis") && i + 1 < argc) {
+            if (!parseChannelSettings(argv[++i], arg == "--deadband" ? options.deadband : options.hysteresis)) {
+                std::cout << "Invalid " << arg << " setting: " << argv[i]
+                    << " (expected off or temp=0.5,hum=2,soil=1,ph=0.05,n=2,p=2,k=2,light=50)" << std::endl;
+                return false;
+            }
+            if (arg == "--deadband" && std::string(argv[i]) == "off") {
+                for (int c = 0; c < SENSOR_CHANNELS; c++) options.hysteresis[c] = 0.0f;
+            }
+        }
+        else if (arg == "--sample-period" && i + 1 < argc) {
+            std::string spec = argv[++i];
+            if (spec == "off" || !parseChannelSettings(spec, options.samplePeriod)) {
+                std::cout << "Invalid --sample-period setting: " << spec
+                    << " (expected temp=1,hum=1,soil=2,ph=3.75,n=90,p=90,k=90,light=1 in sim seconds)" << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--bench-line-protocol") {
+            options.benchLineGigabytes = 10.0;
+            if (i + 1 < argc && argv[i + 1][0] != '-') options.benchLineGigabytes = std::max(0.001, atof(argv[++i]));
+        }
+        else {
+            std::cout << "Unknown option: " << arg << std::endl;
+            std::cout << "Usage: Project2 [--headless] [--days N] [--verbose] [--warp 1-1000]"
+                << " [--kernel auto|scalar|sse2|avx2] [--threads N] [--seed N] [--hash-at STEP]"
+                << " [--plants N] [--field METERS] [--density PLANTS_PER_M2]"
+                << " [--sensor-pitch METERS] [--nozzle-spacing METERS] [--soil-cell METERS] [--crops FILE]"
+                << " [--weather-file EPW|CSV] [--ingest udp:PORT|unix:PATH]"
+                << " [--replay udp:HOST:PORT|unix:PATH [--replay-rate N] [--replay-seconds S] [--replay-sensors N]"
+                << " [--replay-format binary|text|delta]] [--bench-line-protocol [GB]]"
+                << " [--convert IN OUT [--frame-bytes N]] [--deadband off|CH=V,...] [--hysteresis CH=V,...]"
+                << " [--sample-period CH=SECONDS,...]" << std::endl;
+            return false;
+        }
+    }
+    if (options.simDays <= 0.0f) {
+        std::cout << "--days must be positive" << std::endl;
+        return false;
+    }
+    return true;
+}
 
 // 主函数
-int main() {
+int main(int argc, char* argv[]) {
+    if (!parseRunOptions(argc, argv, runOptions)) {
+        return -1;
+    }
+#ifdef FARM_HEADLESS
+    runOptions.headless = true;
+#endif
+    if (runOptions.benchLineGigabytes > 0.0) {
+        return runLineProtocolBenchmark(runOptions);
+    }
+    if (!runOptions.convertInput.empty()) {
+        return runTelemetryConversion(runOptions);
+    }
+    if (!runOptions.replayTarget.empty()) {
+        return runSensorReplay(runOptions);
+    }
+    if (runOptions.headless) {
+        return runHeadlessSimulation(runOptions);
+    }
+
+#ifndef FARM_HEADLESS
     std::cout << "================================================" << std::endl;
     std::cout << "🚜 优化版智能农场监控系统 - DMT201 Final Project" << std::endl;
     std::cout << "基于原始脚本完整优化 - 保持所有功能" << std::endl;
@@ -836,6 +2627,7 @@ int main() {
     std::cout << "  T     - Change Weather (Sunny -> Cloudy -> Rainy -> Stormy)" << std::endl;
     std::cout << "  I     - Toggle Farm Information Display" << std::endl;
     std::cout << "  H     - Toggle Detailed Statistics" << std::endl;
+    std::cout << "  [ / ] - Slow Down / Speed Up Simulation (1x - 1000x)" << std::endl;
     std::cout << "  ESC   - Exit Program" << std::endl;
     std::cout << "" << std::endl;
     std::cout << "CAMERA CONTROLS:" << std::endl;
@@ -916,29 +2708,30 @@ int main() {
     std::cout << "  6. Different weather affects plant behavior - experiment!" << std::endl;
     std::cout << "========================================================================" << std::endl;
 
-    // 主渲染循环
-    float lastFrame = 0.0f;
+    // 主渲染循环 - 模拟按固定步长推进，渲染按帧插值
+    simClock.timeWarp = runOptions.timeWarp;
+    float lastFrame = (float)glfwGetTime();
     int frameCount = 0;
-    float lastStatusReport = 0.0f;
+    float lastStatusReport = lastFrame;
 
     while (!glfwWindowShouldClose(g_window)) {
         float currentFrame = (float)glfwGetTime();
         float deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
         systemTime = currentFrame;
-        frameCount++;
 
         // Farm status report every 6 seconds (更频繁)
         if (currentFrame - lastStatusReport > 6.0f) {
             float fps = frameCount / (currentFrame - lastStatusReport);
-            updateFarmStatus();
             if (showUI) {
                 std::cout << "Farm Status - FPS: " << (int)fps
+                    << " | Warp: " << (int)simClock.timeWarp << "x"
+                    << " | Dropped Frames: " << simClock.droppedFrames
                     << " | Weather: " << (weather.weatherType == 0 ? "Sunny" :
                         weather.weatherType == 1 ? "Cloudy" :
                         weather.weatherType == 2 ? "Rainy" : "Stormy")
-                    << " | Healthy Plants: " << farmStatus.healthyPlants << "/" << plants.size()
-                    << " | Alert Sensors: " << farmStatus.alertSensors << "/" << sensors.size()
+                    << " | Healthy Plants: " << farmStatus.healthyPlants << "/" << plantStore.size()
+                    << " | Alert Sensors: " << farmStatus.alertSensors << "/" << sensorStore.size()
                     << " | Auto Systems: " << (farmStatus.autoIrrigation ? "I" : "")
                     << (farmStatus.pestControl ? "P" : "")
                     << (farmStatus.autoFertilizer ? "F" : "")
@@ -952,21 +2745,38 @@ int main() {
         processInput(g_window);
 
         if (isInitialized) {
-            updateFarmSimulation(deltaTime);
-            render();
+            advanceSimulationClock(deltaTime);
+
+            // 积压未追平时优先保证模拟，跳过本帧渲染（有上限，避免画面冻结）
+            bool caughtUp = simClock.accumulator < simClock.fixedStep;
+            if (caughtUp || simClock.skippedFrames >= simClock.maxSkippedFrames) {
+                renderState = interpolateRenderSnapshot(previousSnapshot, currentSnapshot, simClock.alpha);
+                render();
+                glfwSwapBuffers(g_window);
+                simClock.skippedFrames = 0;
+                frameCount++;
+            }
+            else {
+                simClock.skippedFrames++;
+                simClock.droppedFrames++;
+            }
+        }
+        else {
+            glfwSwapBuffers(g_window);
         }
 
-        glfwSwapBuffers(g_window);
         glfwPollEvents();
     }
 
     // Resource cleanup
     std::cout << "Cleaning up system resources..." << std::endl;
+    stopSensorIngest();
+    threadPool.stop();
     for (auto& obj : renderObjects) obj.cleanup();
     renderObjects.clear();
-    sensors.clear();
-    plants.clear();
-    buildings.clear();
+    sensorStore.clear();
+    plantStore.clear();
+    buildingStore.clear();
     paths.clear();
 
     if (shaderProgram != 0) glDeleteProgram(shaderProgram);
@@ -975,8 +2785,179 @@ int main() {
     std::cout << "Smart Farm System shutdown complete. Thank you!" << std::endl;
     system("pause");
     return 0;
+#endif
+}
+
+// 无窗口模拟 - 不依赖OpenGL，以CPU最快速度推进与渲染循环相同的农场逻辑
+int runHeadlessSimulation(const RunOptions& options) {
+    std::cout << "================================================" << std::endl;
+    std::cout << "Smart Farm Headless Simulation" << std::endl;
+    std::cout << "   Simulated days: " << options.simDays
+        << " (" << dayLengthSeconds << " s per day)" << std::endl;
+    std::cout << "================================================" << std::endl;
+
+    simEventLog = options.verbose;
+    initializeFarmSystems();
+    isInitialized = true;
+
+    // 与窗口模式相同的固定步长，保证结果一致
+    const double totalSimSeconds = (double)options.simDays * dayLengthSeconds;
+    int reportedDay = 0;
+
+    auto wallStart = std::chrono::steady_clock::now();
+    auto lastWall = wallStart;
+    double lastWallSim = 0.0;
+
+    while (simClock.simTime < totalSimSeconds) {
+        stepFarmSimulation(simClock.fixedStep);
+        double simSeconds = simClock.simTime;
+
+        // 每个模拟日输出一次进度
+        int day = (int)(simSeconds / dayLengthSeconds);
+        if (day > reportedDay) {
+            reportedDay = day;
+            auto now = std::chrono::steady_clock::now();
+            double wall = std::chrono::duration<double>(now - lastWall).count();
+            double rate = wall > 0.0 ? (simSeconds - lastWallSim) / wall : 0.0;
+            lastWall = now;
+            lastWallSim = simSeconds;
+
+            std::cout << "Day " << day
+                << " | Healthy Plants: " << farmStatus.healthyPlants << "/" << plantStore.size()
+                << " | Alert Sensors: " << farmStatus.alertSensors << "/" << sensorStore.size()
+                << " | Harvest: " << std::fixed << std::setprecision(1) << farmStatus.harvestYield << " kg"
+                << " | Speed: " << std::setprecision(0) << rate << " sim-s/wall-s" << std::endl;
+        }
+    }
+
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    double simSeconds = simClock.simTime;
+    long long ticks = simClock.totalSteps;
+    std::cout << "================================================" << std::endl;
+    std::cout << "Headless run complete" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "   Simulated: " << simSeconds << " s (" << simSeconds / dayLengthSeconds << " days), "
+        << ticks << " ticks" << std::endl;
+    std::cout << "   Wall time: " << wallSeconds << " s" << std::endl;
+    if (wallSeconds > 0.0) {
+        std::cout << "   Throughput: " << std::setprecision(0) << simSeconds / wallSeconds
+            << " sim-s/wall-s, " << ticks / wallSeconds << " ticks/s" << std::endl;
+    }
+    if (culledPlants > 0) {
+        std::cout << "   Dead plants: " << culledPlants << " culled and replanted as seedlings" << std::endl;
+    }
+    if (etForecast.refreshCount > 0) {
+        std::cout << "   ET forecast: " << etForecast.refreshCount << " refreshes of " << etForecast.zones()
+            << " zones x " << etForecastHours << " h, " << std::setprecision(3)
+            << etForecast.refreshMillis / etForecast.refreshCount << " ms avg" << std::endl;
+    }
+    if (irrigationSchedule.solveCount > 0) {
+        std::cout << "   Irrigation schedule: " << irrigationSchedule.solveCount << " solves over "
+            << irrigationSchedule.valves() << " valves, " << std::setprecision(3)
+            << irrigationSchedule.solveMillis / irrigationSchedule.solveCount << " ms avg" << std::endl;
+    }
+    if (pipeNetwork.solves > 0) {
+        std::cout << "   Pipe network: " << pipeNetwork.solves << " solves over " << pipeNetwork.segments()
+            << " segments, " << std::setprecision(1) << (double)pipeNetwork.newtonSteps / pipeNetwork.solves
+            << " Newton / " << (double)pipeNetwork.cgIterations / pipeNetwork.solves << " CG iterations, "
+            << std::setprecision(3) << pipeNetwork.solveMillis / pipeNetwork.solves << " ms avg";
+        if (pipeNetwork.unconverged > 0) std::cout << " | " << pipeNetwork.unconverged << " did not converge";
+        std::cout << std::endl;
+    }
+    if (weatherFile.active()) {
+        std::cout << "   Weather file: " << weatherFile.recordsRead << " records streamed, " << weatherFile.rewinds
+            << " rewinds, " << weatherFile.missingValues << " missing values filled" << std::endl;
+    }
+    if (sensorSchedule.ticks > 0) {
+        const SensorSampleSchedule& q = sensorSchedule;
+        std::cout << "   Sensor sampling: " << std::fixed << std::setprecision(2) << (double)q.rowsSampled / q.ticks
+            << " sensors / " << (double)q.channelsSampled / q.ticks << " channels per tick (peak " << q.peakRows
+            << " sensors) | " << std::setprecision(4) << q.millis / q.ticks << " ms avg, " << q.peakMillis
+            << " ms peak per tick" << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+    }
+    if (sensorReportStats.sensorRefreshes > 0) {
+        const SensorReportStats& r = sensorReportStats;
+        std::cout << "   Report by exception: " << r.channelReports << "/" << r.channelSamples << " channel readings reported ("
+            << std::fixed << std::setprecision(1) << 100.0 * (r.channelSamples - r.channelReports) / std::max<uint64_t>(r.channelSamples, 1)
+            << "% within deadband), " << 100.0 * r.cleanRefreshes / r.sensorRefreshes
+            << "% of sensor refreshes clean (display not recomputed)" << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+    }
+    if (sensorIngest.active()) {
+        std::cout << "   Sensor ingest: " << sensorIngest.datagrams.load() << " datagrams, "
+            << sensorIngest.samplesReceived.load() << " readings received, " << sensorIngest.samplesApplied
+            << " applied | backpressure: " << sensorIngest.samplesDropped.load() << " dropped (ring full), peak "
+            << sensorIngest.peakBacklog << " per tick | " << sensorIngest.malformed.load() << " malformed, "
+            << sensorIngest.unknownSensors << " unknown sensors" << std::endl;
+    }
+    if (greenhouseZones.steps > 0) {
+        std::cout << "   Greenhouse climate: " << greenhouseZones.zones() << " zones x " << CLIMATE_LOOP_KINDS
+            << " PID loops, " << std::setprecision(2) << greenhouseZones.controlMillis * 1000.0 / greenhouseZones.steps
+            << " us avg per control step" << std::endl;
+    }
+    std::cout << "================================================" << std::endl;
+    // 状态统计每6秒才更新一次，结束前按最终状态重新统计（不结算施肥和产量）
+    refreshFarmStatistics();
+    printStateHash();
+    printUIInfo();
+
+    stopSensorIngest();
+    threadPool.stop();
+    sensorStore.clear();
+    plantStore.clear();
+    buildingStore.clear();
+    soilGrid = SoilGrid();
+    pestGrid = PestGrid();
+    etForecast = EtForecast();
+    irrigationSchedule = IrrigationSchedule();
+    pipeNetwork = PipeNetwork();
+    greenhouseZones = GreenhouseZones();
+    weatherTimeline = WeatherTimeline();
+    weatherFile = WeatherFileSource();
+    plantBatches.clear();
+    paths.clear();
+    return 0;
+}
+
+// 初始化农场模拟数据（建筑、传感器、植物、路径），窗口与无窗口模式共用
+void initializeFarmSystems() {
+    if (runOptions.hasSeed) {
+        simulationSeed = runOptions.seed;
+    }
+    else {
+        std::random_device rd;
+        simulationSeed = ((uint64_t)rd() << 32) | rd();
+    }
+    std::cout << "Simulation seed: " << simulationSeed << " (reproduce with --seed)" << std::endl;
+
+    farmConfig = runOptions.farm;
+    resolveFarmConfig(farmConfig);
+
+    startSimulationThreads(runOptions.threadCount);
+    initializeWeatherTimeline();
+    if (!runOptions.weatherFile.empty()) openWeatherFile(runOptions.weatherFile);
+    createDetailedBuildings();
+    initializeAdvancedSensorNetwork();
+    initializeSensorSchedule();
+    initializeSoilGrid();
+    initializeCropTable(runOptions.cropFile);
+    initializeDetailedPlants();
+    initializePestGrid();
+    createBezierPaths();
+    selectPlantKernel(runOptions.plantKernel);
+    selectSoilKernel(plantKernelLevel);
+    selectEtKernel(plantKernelLevel);
+    selectClimateKernel(plantKernelLevel);
+    selectLineScanKernel(plantKernelLevel);
+    initializeEtForecast();
+    initializePipeNetwork();
+    initializeIrrigationSchedule();
+    initializeGreenhouseZones();
+    if (!runOptions.ingestEndpoints.empty()) startSensorIngest(runOptions.ingestEndpoints);
 }
 
+#ifndef FARM_HEADLESS
 bool initializeOpenGL() {
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_MULTISAMPLE);
@@ -998,10 +2979,7 @@ bool initializeOpenGL() {
     }
 
     // 初始化农场系统（保持原有顺序）
-    createDetailedBuildings();
-    initializeAdvancedSensorNetwork();
-    initializeDetailedPlants();
-    createBezierPaths();
+    initializeFarmSystems();
     generateDetailedFarm();
 
     // 设置渲染缓冲区
@@ -1013,9 +2991,9 @@ bool initializeOpenGL() {
 
     isInitialized = true;
     std::cout << "Farm Component Statistics:" << std::endl;
-    std::cout << "   Buildings: " << buildings.size() << " units" << std::endl;
-    std::cout << "   Plants: " << plants.size() << " specimens" << std::endl;
-    std::cout << "   Sensors: " << sensors.size() << " nodes" << std::endl;
+    std::cout << "   Buildings: " << buildingStore.size() << " units" << std::endl;
+    std::cout << "   Plants: " << plantStore.size() << " specimens" << std::endl;
+    std::cout << "   Sensors: " << sensorStore.size() << " nodes" << std::endl;
     std::cout << "   Paths: " << paths.size() << " routes" << std::endl;
     std::cout << "   Render Objects: " << renderObjects.size() << " groups" << std::endl;
     return true;
@@ -1068,229 +3046,647 @@ GLuint compileShader(GLenum type, const char* source) {
     }
     return shader;
 }
+#endif
 
 // 创建详细的建筑群（保持原有功能）
 void createDetailedBuildings() {
-    buildings.clear();
+    buildingStore.clear();
 
     // 1. 主控制中心 (0,0为中心)
-    buildings.emplace_back("控制中心", glm::vec3(0.0f, 0.0f, -15.0f),
-        glm::vec3(6.0f, 4.0f, 4.0f), glm::vec3(0.6f, 0.6f, 0.7f));
+    buildingStore.add(Building("控制中心", glm::vec3(0.0f, 0.0f, -15.0f),
+        glm::vec3(6.0f, 4.0f, 4.0f), glm::vec3(0.6f, 0.6f, 0.7f)));
 
     // 2. 温室A (东侧)
-    buildings.emplace_back("温室A", glm::vec3(12.0f, 0.0f, -8.0f),
+    Building greenhouseA("温室A", glm::vec3(12.0f, 0.0f, -8.0f),
         glm::vec3(8.0f, 3.5f, 6.0f), glm::vec3(0.9f, 0.95f, 0.9f));
+    greenhouseA.greenhouse = true;
+    buildingStore.add(greenhouseA);
 
     // 3. 温室B (西侧)
-    buildings.emplace_back("温室B", glm::vec3(-12.0f, 0.0f, -8.0f),
+    Building greenhouseB("温室B", glm::vec3(-12.0f, 0.0f, -8.0f),
         glm::vec3(8.0f, 3.5f, 6.0f), glm::vec3(0.9f, 0.95f, 0.9f));
+    greenhouseB.greenhouse = true;
+    buildingStore.add(greenhouseB);
 
     // 4. 仓储中心 (南侧)
-    buildings.emplace_back("仓储中心", glm::vec3(0.0f, 0.0f, 15.0f),
-        glm::vec3(10.0f, 5.0f, 6.0f), glm::vec3(0.7f, 0.5f, 0.4f));
+    buildingStore.add(Building("仓储中心", glm::vec3(0.0f, 0.0f, 15.0f),
+        glm::vec3(10.0f, 5.0f, 6.0f), glm::vec3(0.7f, 0.5f, 0.4f)));
 
     // 5. 工具房 (东南)
-    buildings.emplace_back("工具房", glm::vec3(15.0f, 0.0f, 8.0f),
-        glm::vec3(4.0f, 3.0f, 4.0f), glm::vec3(0.6f, 0.4f, 0.3f));
+    buildingStore.add(Building("工具房", glm::vec3(15.0f, 0.0f, 8.0f),
+        glm::vec3(4.0f, 3.0f, 4.0f), glm::vec3(0.6f, 0.4f, 0.3f)));
 
     // 6. 水处理站 (西南)
-    buildings.emplace_back("水处理站", glm::vec3(-15.0f, 0.0f, 8.0f),
-        glm::vec3(5.0f, 4.0f, 5.0f), glm::vec3(0.5f, 0.7f, 0.8f));
+    buildingStore.add(Building("水处理站", glm::vec3(-15.0f, 0.0f, 8.0f),
+        glm::vec3(5.0f, 4.0f, 5.0f), glm::vec3(0.5f, 0.7f, 0.8f)));
+
+    std::cout << "Building infrastructure completed - " << buildingStore.size() << " functional buildings" << std::endl;
+}
 
-    std::cout << "Building infrastructure completed - " << buildings.size() << " functional buildings" << std::endl;
+// 补全农场配置：只给植物数时按密度推算田地大小，只给田地大小时按密度推算植物数
+void resolveFarmConfig(FarmConfig& config) {
+    if (config.fieldHalfExtent <= 0.0f) {
+        if (config.targetPlants > 0) {
+            config.fieldHalfExtent = std::max(18.0f, 0.5f * std::sqrt(config.targetPlants / config.plantDensity));
+        }
+        else {
+            config.fieldHalfExtent = 18.0f;
+        }
+    }
+    if (config.targetPlants <= 0) {
+        float side = config.fieldHalfExtent * 2.0f;
+        config.targetPlants = std::max(1, (int)(side * side * config.plantDensity + 0.5f));
+    }
+
+    std::cout << "Farm configuration: " << config.targetPlants << " plants on "
+        << config.fieldHalfExtent * 2.0f << "m x " << config.fieldHalfExtent * 2.0f << "m field"
+        << " | sensor pitch " << config.sensorPitch << "m | nozzle spacing " << config.nozzleSpacing << "m"
+        << " | soil cell " << config.soilCellSize << "m" << std::endl;
 }
 
 // 初始化高级传感器网络（修复位置到地面）
 void initializeAdvancedSensorNetwork() {
-    sensors.clear();
-
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<float> tempDis(18.0f, 32.0f);
-    std::uniform_real_distribution<float> humidDis(40.0f, 85.0f);
-    std::uniform_real_distribution<float> soilDis(25.0f, 80.0f);
-    std::uniform_real_distribution<float> lightDis(400.0f, 1200.0f);
-    std::uniform_real_distribution<float> pHDis(5.5f, 8.0f);
-    std::uniform_real_distribution<float> nutrientDis(20.0f, 80.0f);
+    sensorStore.clear();
+
+    // 传感器网格覆盖整个田地，以中心对称
+    float pitch = farmConfig.sensorPitch;
+    int gridSize = std::max(1, (int)std::round(farmConfig.fieldHalfExtent * 2.0f / pitch));
+    float gridCenter = (gridSize - 1) * 0.5f;
+    sensorStore.readings.reserve((size_t)gridSize * gridSize);
+    sensorStore.measured.reserve((size_t)gridSize * gridSize);
+    sensorStore.report.reserve((size_t)gridSize * gridSize);
+    sensorStore.display.reserve((size_t)gridSize * gridSize);
+    sensorStore.position.reserve((size_t)gridSize * gridSize);
 
     // 传感器放置在地面 - 修复高度
-    for (int i = 0; i < 5; i++) {
-        for (int j = 0; j < 5; j++) {
-            SensorData sensor;
+    for (int i = 0; i < gridSize; i++) {
+        for (int j = 0; j < gridSize; j++) {
+            PhiloxStream rng(simulationSeed, RNG_SENSOR_INIT, (uint32_t)sensorStore.size(), 0);
 
             // 传感器位置：在地面上，更好分布
-            sensor.position = glm::vec3(
-                (i - 2) * 7.0f + (j % 2) * 1.0f,   // X轴分布
-                0.3f,                               // 地面高度！
-                (j - 2) * 7.0f + (i % 2) * 1.0f    // Z轴分布
+            glm::vec3 position(
+                (i - gridCenter) * pitch + (j % 2) * 1.0f,   // X轴分布
+                0.3f,                                         // 地面高度！
+                (j - gridCenter) * pitch + (i % 2) * 1.0f    // Z轴分布
             );
+            uint32_t row = sensorStore.index.row(sensorStore.add(position));
+            SensorReadings& sensor = sensorStore.readings[row];
+            SensorDisplay& display = sensorStore.display[row];
 
-            sensor.temperature = tempDis(gen);
-            sensor.humidity = humidDis(gen);
-            sensor.soilMoisture = soilDis(gen);
-            sensor.lightLevel = lightDis(gen);
-            sensor.pH = pHDis(gen);
+            sensor.temperature = rng.uniform(18.0f, 32.0f);
+            sensor.humidity = rng.uniform(40.0f, 85.0f);
+            sensor.soilMoisture = rng.uniform(25.0f, 80.0f);
+            sensor.lightLevel = rng.uniform(400.0f, 1200.0f);
+            sensor.pH = rng.uniform(5.5f, 8.0f);
 
             // 营养数据
-            sensor.nitrogenLevel = nutrientDis(gen);
-            sensor.phosphorusLevel = nutrientDis(gen);
-            sensor.potassiumLevel = nutrientDis(gen);
-
-            // 温室区域调整
-            bool inGreenhouse = (abs(sensor.position.x) > 6.0f && abs(sensor.position.z) < 10.0f);
-            if (inGreenhouse) {
-                sensor.temperature += 4.0f;  // 更明显的温室效果
-                sensor.humidity += 15.0f;
-            }
+            sensor.nitrogenLevel = rng.uniform(20.0f, 80.0f);
+            sensor.phosphorusLevel = rng.uniform(20.0f, 80.0f);
+            sensor.potassiumLevel = rng.uniform(20.0f, 80.0f);
+            sensorStore.measured[row] = sensor;
 
             // 计算7个数据柱高度 - 增强可见性
-            sensor.dataHeight[0] = (sensor.temperature - 15.0f) / 25.0f * 3.0f; // 更高的柱子
-            sensor.dataHeight[1] = sensor.humidity / 100.0f * 3.0f;
-            sensor.dataHeight[2] = sensor.soilMoisture / 100.0f * 3.0f;
-            sensor.dataHeight[3] = (sensor.pH - 5.0f) / 3.5f * 3.0f;
-            sensor.dataHeight[4] = sensor.nitrogenLevel / 100.0f * 3.0f;
-            sensor.dataHeight[5] = sensor.phosphorusLevel / 100.0f * 3.0f;
-            sensor.dataHeight[6] = sensor.potassiumLevel / 100.0f * 3.0f;
-
-            sensor.statusColor = glm::vec3(0.2f, 1.0f, 0.3f);
-            sensors.push_back(sensor);
+            display.dataHeight[0] = (sensor.temperature - 15.0f) / 25.0f * 3.0f; // 更高的柱子
+            display.dataHeight[1] = sensor.humidity / 100.0f * 3.0f;
+            display.dataHeight[2] = sensor.soilMoisture / 100.0f * 3.0f;
+            display.dataHeight[3] = (sensor.pH - 5.0f) / 3.5f * 3.0f;
+            display.dataHeight[4] = sensor.nitrogenLevel / 100.0f * 3.0f;
+            display.dataHeight[5] = sensor.phosphorusLevel / 100.0f * 3.0f;
+            display.dataHeight[6] = sensor.potassiumLevel / 100.0f * 3.0f;
+
+            display.statusColor = glm::vec3(0.2f, 1.0f, 0.3f);
         }
     }
 
-    std::cout << "Ground-based Sensor Network Deployed - " << sensors.size() << " monitoring nodes" << std::endl;
+    std::vector<glm::vec2> sensorPoints(sensorStore.size());
+    for (size_t i = 0; i < sensorStore.size(); i++) {
+        sensorPoints[i] = glm::vec2(sensorStore.position[i].x, sensorStore.position[i].z);
+    }
+    sensorLocator.build(sensorPoints, pitch);
+
+    std::cout << "Ground-based Sensor Network Deployed - " << sensorStore.size() << " monitoring nodes" << std::endl;
 }
 
-// 初始化增强植物系统 - 修复位置对齐
-void initializeDetailedPlants() {
-    plants.clear();
-
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<float> posDis(-18.0f, 18.0f);
-    std::uniform_real_distribution<float> heightDis(0.8f, 2.5f);
-    std::uniform_real_distribution<float> healthDis(0.7f, 1.0f);
-    std::uniform_int_distribution<int> typeDis(0, 3);
-    std::uniform_real_distribution<float> phaseDis(0.0f, 6.28f);
-
-    // 生成300个精细植物实例 - 优化位置检测
-    for (int i = 0; i < 300; i++) {
-        DetailedPlant plant;
-        bool validPosition = false;
-        int attempts = 0;
-
-        // 尝试找到合适位置
-        while (!validPosition && attempts < 15) {
-            plant.position = glm::vec3(posDis(gen), 0.0f, posDis(gen));
-            validPosition = true;
-
-            // 检查与建筑物重叠 - 优化距离计算
-            for (const auto& building : buildings) {
-                float dist = glm::length(plant.position - glm::vec3(building.position.x, 0, building.position.z));
-                if (dist < 7.0f) { // 增加安全距离
-                    validPosition = false;
-                    break;
+// 查找离(x, z)最近的 count 个传感器，按距离递增写入 rows/distance2，返回找到的个数
+int findNearestSensors(float x, float z, int count, uint32_t* rows, float* distance2) {
+    int total = std::min(count, (int)sensorStore.size());
+    if (total == 0) return 0;
+
+    // 查询半径内已找够且最远者也在半径内时结果即为全局最近，否则扩大半径
+    for (float radius = farmConfig.sensorPitch; ; radius *= 2.0f) {
+        int found = 0;
+        sensorLocator.forEachNear(x, z, radius, [&](int k) {
+            float dx = sensorStore.position[k].x - x;
+            float dz = sensorStore.position[k].z - z;
+            float d2 = dx * dx + dz * dz;
+            if (found == total && !(d2 < distance2[total - 1] ||
+                (d2 == distance2[total - 1] && (uint32_t)k < rows[total - 1]))) {
+                return;
+            }
+            // 插入排序，距离相同时行号小的在前
+            int slot = found < total ? found++ : total - 1;
+            while (slot > 0 && (d2 < distance2[slot - 1] ||
+                (d2 == distance2[slot - 1] && (uint32_t)k < rows[slot - 1]))) {
+                rows[slot] = rows[slot - 1];
+                distance2[slot] = distance2[slot - 1];
+                slot--;
+            }
+            rows[slot] = (uint32_t)k;
+            distance2[slot] = d2;
+        });
+        if (found == total && distance2[total - 1] <= radius * radius) return total;
+    }
+}
+
+// 反距离平方插值权重（距离平方加0.5避免与传感器重合时发散）；不足的邻居权重为0
+void computeSensorWeights(float x, float z, SensorWeights& weights) {
+    uint32_t rows[microclimateNeighbors];
+    float distance2[microclimateNeighbors];
+    int found = findNearestSensors(x, z, microclimateNeighbors, rows, distance2);
+
+    float total = 0.0f;
+    for (int k = 0; k < microclimateNeighbors; k++) {
+        weights.sensor[k] = k < found ? rows[k] : (found > 0 ? rows[0] : 0);
+        weights.weight[k] = k < found ? 1.0f / (distance2[k] + 0.5f) : 0.0f;
+        total += weights.weight[k];
+    }
+    for (int k = 0; k < microclimateNeighbors; k++) {
+        weights.weight[k] = total > 0.0f ? weights.weight[k] / total : 0.0f;
+    }
+}
+
+// 按点集构建空间哈希（点编号即 points 下标）
+void SpatialHashGrid::build(const std::vector<glm::vec2>& points, float size) {
+    cellSize = std::max(size, 1e-3f);
+    items.clear();
+    cellStart.assign(2, 0);
+    cellsX = cellsZ = 1;
+    originX = originZ = 0.0f;
+    if (points.empty()) return;
+
+    float minX = points[0].x, maxX = points[0].x, minZ = points[0].y, maxZ = points[0].y;
+    for (const auto& p : points) {
+        minX = std::min(minX, p.x); maxX = std::max(maxX, p.x);
+        minZ = std::min(minZ, p.y); maxZ = std::max(maxZ, p.y);
+    }
+    originX = minX;
+    originZ = minZ;
+    cellsX = (int)((maxX - minX) / cellSize) + 1;
+    cellsZ = (int)((maxZ - minZ) / cellSize) + 1;
+
+    // 计数排序：先统计每格数量，再前缀和，最后填入
+    std::vector<int> cellOf(points.size());
+    cellStart.assign((size_t)cellsX * cellsZ + 1, 0);
+    for (size_t i = 0; i < points.size(); i++) {
+        cellOf[i] = cellZ(points[i].y) * cellsX + cellX(points[i].x);
+        cellStart[cellOf[i] + 1]++;
+    }
+    for (size_t c = 1; c < cellStart.size(); c++) {
+        cellStart[c] += cellStart[c - 1];
+    }
+    items.resize(points.size());
+    std::vector<int> fill(cellStart.begin(), cellStart.end() - 1);
+    for (size_t i = 0; i < points.size(); i++) {
+        items[fill[cellOf[i]]++] = (int)i;
+    }
+}
+
+// Bridson 泊松圆盘采样 - 在矩形区域内生成间距不小于 spacing 的最大点集，避开禁区。
+// 背景网格单元边长为 spacing/√2，每格最多一个点，邻域检查为常数时间；
+// 活动列表耗尽后按单元格顺序补种，被禁区隔开的区域也会被填满
+std::vector<glm::vec2> samplePoissonDisk(float minX, float minZ, float maxX, float maxZ, float spacing,
+    const std::vector<ExclusionZone>& zones, PhiloxStream& rng) {
+    const int attemptsPerPoint = 30;
+    const int attemptsPerReseed = 4;
+    std::vector<glm::vec2> samples;
+    if (maxX <= minX || maxZ <= minZ || spacing <= 0.0f) return samples;
+
+    float cell = spacing / std::sqrt(2.0f);
+    int gridW = (int)std::ceil((maxX - minX) / cell);
+    int gridH = (int)std::ceil((maxZ - minZ) / cell);
+    std::vector<int> grid((size_t)gridW * gridH, -1);
+
+    // 禁区空间哈希
+    std::vector<glm::vec2> zoneCenters;
+    float maxZoneRadius = 0.0f;
+    for (const auto& zone : zones) {
+        zoneCenters.push_back(zone.center);
+        maxZoneRadius = std::max(maxZoneRadius, zone.radius);
+    }
+    SpatialHashGrid zoneGrid;
+    zoneGrid.build(zoneCenters, std::max(maxZoneRadius, spacing));
+
+    float spacing2 = spacing * spacing;
+    auto isFree = [&](const glm::vec2& p) {
+        if (p.x < minX || p.x >= maxX || p.y < minZ || p.y >= maxZ) return false;
+        int gx = (int)((p.x - minX) / cell);
+        int gz = (int)((p.y - minZ) / cell);
+        for (int z = std::max(0, gz - 2); z <= std::min(gridH - 1, gz + 2); z++) {
+            for (int x = std::max(0, gx - 2); x <= std::min(gridW - 1, gx + 2); x++) {
+                int other = grid[(size_t)z * gridW + x];
+                if (other >= 0) {
+                    glm::vec2 d = samples[other] - p;
+                    if (d.x * d.x + d.y * d.y < spacing2) return false;
                 }
             }
+        }
+        bool blocked = false;
+        zoneGrid.forEachNear(p.x, p.y, maxZoneRadius, [&](int z) {
+            glm::vec2 d = zones[z].center - p;
+            if (d.x * d.x + d.y * d.y < zones[z].radius * zones[z].radius) blocked = true;
+        });
+        return !blocked;
+    };
 
-            // 检查与传感器重叠
-            if (validPosition) {
-                for (const auto& sensor : sensors) {
-                    float dist = glm::length(plant.position - glm::vec3(sensor.position.x, 0, sensor.position.z));
-                    if (dist < 2.0f) { // 增加传感器周围空间
-                        validPosition = false;
-                        break;
-                    }
+    std::vector<int> active;
+    auto addSample = [&](const glm::vec2& p) {
+        int gx = std::min(gridW - 1, (int)((p.x - minX) / cell));
+        int gz = std::min(gridH - 1, (int)((p.y - minZ) / cell));
+        grid[(size_t)gz * gridW + gx] = (int)samples.size();
+        active.push_back((int)samples.size());
+        samples.push_back(p);
+    };
+
+    size_t reseedCursor = 0;
+    while (true) {
+        // 从活动点周围的环形区域 [spacing, 2*spacing) 生成候选
+        while (!active.empty()) {
+            size_t slot = rng.below((uint32_t)active.size());
+            glm::vec2 center = samples[active[slot]];
+            bool placed = false;
+            for (int k = 0; k < attemptsPerPoint && !placed; k++) {
+                float angle = rng.uniform(0.0f, 6.2831853f);
+                float radius = spacing * std::sqrt(rng.uniform(1.0f, 4.0f)); // 环内按面积均匀
+                glm::vec2 candidate = center + radius * glm::vec2(std::cos(angle), std::sin(angle));
+                if (isFree(candidate)) {
+                    addSample(candidate);
+                    placed = true;
                 }
             }
+            if (!placed) {
+                active[slot] = active.back();
+                active.pop_back();
+            }
+        }
 
-            // 检查与其他植物重叠
-            if (validPosition) {
-                for (const auto& otherPlant : plants) {
-                    float dist = glm::length(plant.position - otherPlant.position);
-                    if (dist < 1.0f) { // 植物间最小距离
-                        validPosition = false;
-                        break;
+        // 补种：找到下一个空单元格，尝试在格内随机落点
+        bool reseeded = false;
+        while (reseedCursor < grid.size() && !reseeded) {
+            if (grid[reseedCursor] < 0) {
+                float cx = minX + (reseedCursor % gridW) * cell;
+                float cz = minZ + (reseedCursor / gridW) * cell;
+                for (int k = 0; k < attemptsPerReseed && !reseeded; k++) {
+                    glm::vec2 candidate(cx + rng.uniform(0.0f, cell), cz + rng.uniform(0.0f, cell));
+                    if (isFree(candidate)) {
+                        addSample(candidate);
+                        reseeded = true;
                     }
                 }
             }
-
-            attempts++;
+            reseedCursor++;
         }
+        if (!reseeded) break;
+    }
+    return samples;
+}
 
-        if (!validPosition) continue; // 如果找不到合适位置，跳过这个植物
-
-        plant.plantType = typeDis(gen);
-        plant.healthFactor = healthDis(gen);
-        plant.windPhase = phaseDis(gen);
-        plant.growthStage = 0.6f + healthDis(gen) * 0.4f;
-
-        // 根据植物类型设置参数
-        switch (plant.plantType) {
-        case 0: // 玉米
-            plant.height = heightDis(gen) * 1.2f;
-            plant.stemRadius = 0.04f;
-            plant.leafCount = 12 + (i % 4);  // 增加叶片数量
-            plant.leafSize = 0.25f;
-            plant.stemColor = glm::vec3(0.4f, 0.6f, 0.2f);
-            plant.leafColor = glm::vec3(0.2f, 0.8f, 0.1f);
-            plant.hasFlowers = plant.growthStage > 0.8f;
-            break;
+// 初始化土壤网格：单元格归属最近的传感器（控制区），初始含水量和氮素取该传感器的初始读数；
+// 喷头网格与 generateDetailedFarm 中的布局相同，每个喷头按高斯分布向周围单元格喷洒
+void initializeSoilGrid() {
+    SoilGrid& grid = soilGrid;
+    float extent = farmConfig.fieldHalfExtent;
+    grid.cellSize = farmConfig.soilCellSize;
+    grid.width = grid.height = std::max(1, (int)std::ceil(extent * 2.0f / grid.cellSize - 0.001f));
+    grid.originX = grid.originZ = -extent;
+
+    size_t cells = grid.cells();
+    grid.moisture.assign(cells, 0.0f);
+    grid.moistureNext.assign(cells, 0.0f);
+    grid.nitrogen.assign(cells, 0.0f);
+    grid.nitrogenNext.assign(cells, 0.0f);
+    grid.zone.assign(cells, 0);
+    grid.zoneWater.assign(sensorStore.size(), 0.0f);
+    grid.zoneNitrogen.assign(sensorStore.size(), 0.0f);
+
+    threadPool.parallelFor(grid.height, soilRowChunkSize, [&](size_t begin, size_t end, int) {
+        for (size_t z = begin; z < end; z++) {
+            float cz = grid.originZ + (z + 0.5f) * grid.cellSize;
+            for (int x = 0; x < grid.width; x++) {
+                float cx = grid.originX + (x + 0.5f) * grid.cellSize;
+                uint32_t nearest = 0;
+                float distance2 = 0.0f;
+                findNearestSensors(cx, cz, 1, &nearest, &distance2);
+                size_t cell = z * grid.width + x;
+                grid.zone[cell] = nearest;
+                grid.moisture[cell] = sensorStore.readings[nearest].soilMoisture;
+                grid.nitrogen[cell] = sensorStore.readings[nearest].nitrogenLevel;
+            }
+        }
+    });
+
+    // 喷头覆盖：σ取半个喷头间距，按间距归一化后网格内部的覆盖系数约为1
+    float spacing = farmConfig.nozzleSpacing;
+    float nozzleExtent = farmConfig.nozzleHalfExtent();
+    int nozzleSteps = (int)(nozzleExtent * 2.0f / spacing + 0.001f);
+    float sigma = 0.5f * spacing;
+    float norm = spacing / (std::sqrt(2.0f * 3.14159f) * sigma);
+    grid.coverageX.assign(grid.width, 0.0f);
+    for (int x = 0; x < grid.width; x++) {
+        float c = grid.originX + (x + 0.5f) * grid.cellSize;
+        int k0 = std::max(0, (int)std::ceil((c - 3.0f * sigma + nozzleExtent) / spacing));
+        int k1 = std::min(nozzleSteps, (int)std::floor((c + 3.0f * sigma + nozzleExtent) / spacing));
+        float sum = 0.0f;
+        for (int k = k0; k <= k1; k++) {
+            float d = c - (-nozzleExtent + k * spacing);
+            sum += std::exp(-d * d / (2.0f * sigma * sigma));
+        }
+        grid.coverageX[x] = sum * norm;
+    }
+    grid.coverageZ = grid.coverageX;
 
-        case 1: // 小麦
-            plant.height = heightDis(gen) * 0.6f;
-            plant.stemRadius = 0.02f;
-            plant.leafCount = 8 + (i % 3);
-            plant.leafSize = 0.15f;
-            plant.stemColor = glm::vec3(0.6f, 0.7f, 0.3f);
-            plant.leafColor = glm::vec3(0.3f, 0.7f, 0.2f);
-            plant.hasFlowers = plant.growthStage > 0.7f;
-            break;
+    std::cout << "Soil grid: " << grid.width << " x " << grid.height << " cells ("
+        << grid.cellSize << "m) | " << (nozzleSteps + 1) * (nozzleSteps + 1) << " nozzles in "
+        << sensorStore.size() << " irrigation zones" << std::endl;
+}
 
-        case 2: // 番茄
-            plant.height = heightDis(gen) * 0.8f;
-            plant.stemRadius = 0.03f;
-            plant.leafCount = 15 + (i % 4);  // 增加叶片数量
-            plant.leafSize = 0.2f;
-            plant.stemColor = glm::vec3(0.3f, 0.5f, 0.2f);
-            plant.leafColor = glm::vec3(0.2f, 0.6f, 0.1f);
-            plant.hasFlowers = plant.growthStage > 0.6f;
-            plant.hasFruits = plant.growthStage > 0.8f;
-            break;
+// 解析一行作物定义："名称 [like=已有作物] 键=值 ..."，未给出的参数沿用 like 作物或默认值
+bool parseCropDefinition(const std::string& line, CropSpec& crop) {
+    std::istringstream in(line);
+    std::string token;
+    if (!(in >> crop.name)) return false;
+    while (in >> token) {
+        size_t eq = token.find('=');
+        if (eq == std::string::npos) return false;
+        std::string key = token.substr(0, eq);
+        std::string value = token.substr(eq + 1);
+        float number = (float)atof(value.c_str());
+        if (key == "like") {
+            std::string name = crop.name;
+            auto it = std::find_if(cropTable.begin(), cropTable.end(),
+                [&value](const CropSpec& c) { return c.name == value; });
+            if (it == cropTable.end()) return false;
+            crop = *it;
+            crop.name = name;
+        }
+        else if (key == "habit") {
+            if (value == "leafy") crop.habit = CROP_LEAFY;
+            else if (value == "flowering") crop.habit = CROP_FLOWERING;
+            else if (value == "fruiting") crop.habit = CROP_FRUITING;
+            else return false;
+        }
+        else if (key == "leaf-style") {
+            if (value == "blade") crop.leafStyle = LEAF_BLADE;
+            else if (value == "narrow") crop.leafStyle = LEAF_NARROW;
+            else if (value == "compound") crop.leafStyle = LEAF_COMPOUND;
+            else if (value == "round") crop.leafStyle = LEAF_ROUND;
+            else return false;
+        }
+        else if (key == "stem-color" || key == "leaf-color") {
+            glm::vec3 color;
+            std::replace(value.begin(), value.end(), ',', ' ');
+            std::istringstream rgb(value);
+            if (!(rgb >> color.r >> color.g >> color.b)) return false;
+            (key == "stem-color" ? crop.stemColor : crop.leafColor) = color;
+        }
+        else if (key == "base") crop.baseTemperature = number;
+        else if (key == "upper") crop.upperTemperature = number;
+        else if (key == "gdd") crop.gddToMaturity = std::max(1.0f, number);
+        else if (key == "flower") crop.flowerStage = number;
+        else if (key == "fruit") crop.fruitStage = number;
+        else if (key == "optimal") crop.optimalTemperature = number;
+        else if (key == "tolerance") crop.temperatureTolerance = std::max(0.0f, number);
+        else if (key == "min-moisture") crop.minMoisture = number;
+        else if (key == "max-moisture") crop.maxMoisture = number;
+        else if (key == "min-humidity") crop.minHumidity = number;
+        else if (key == "height") crop.heightScale = std::max(0.05f, number);
+        else if (key == "stem") crop.stemRadius = std::max(0.001f, number);
+        else if (key == "leaves") crop.leafCount = clamp(atoi(value.c_str()), 1, maxLeavesPerPlant);
+        else if (key == "leaf-spread") crop.leafCountSpread = clamp(atoi(value.c_str()), 1, maxLeavesPerPlant);
+        else if (key == "leaf-size") crop.leafSize = std::max(0.01f, number);
+        else if (key == "petals") crop.petalCount = clamp(atoi(value.c_str()), 3, 12);
+        else if (key == "kc-ini") crop.kcInitial = std::max(0.0f, number);
+        else if (key == "kc-mid") crop.kcMid = std::max(0.0f, number);
+        else if (key == "kc-end") crop.kcEnd = std::max(0.0f, number);
+        else return false;
+    }
+    return true;
+}
 
-        case 3: // 菠菜
-            plant.height = heightDis(gen) * 0.4f;
-            plant.stemRadius = 0.015f;
-            plant.leafCount = 20 + (i % 5);  // 增加叶片数量
-            plant.leafSize = 0.18f;
-            plant.stemColor = glm::vec3(0.2f, 0.4f, 0.1f);
-            plant.leafColor = glm::vec3(0.1f, 0.5f, 0.1f);
-            break;
+// 作物参数表：内置四种作物（积温为°C·天，按 cropDaysPerSimDay 压缩到模拟日），
+// cropFile 非空时逐行追加自定义作物（# 开头为注释）
+void initializeCropTable(const std::string& cropFile) {
+    cropTable.clear();
+
+    CropSpec corn;
+    corn.name = "corn";
+    corn.habit = CROP_FLOWERING;
+    corn.baseTemperature = 10.0f;
+    corn.upperTemperature = 30.0f;
+    corn.gddToMaturity = 1400.0f;
+    corn.flowerStage = 0.8f;
+    corn.optimalTemperature = 25.0f;
+    corn.temperatureTolerance = 7.0f;
+    corn.heightScale = 1.2f;
+    corn.stemRadius = 0.04f;
+    corn.leafCount = 12;
+    corn.leafCountSpread = 4;
+    corn.leafSize = 0.25f;
+    corn.stemColor = glm::vec3(0.4f, 0.6f, 0.2f);
+    corn.leafColor = glm::vec3(0.2f, 0.8f, 0.1f);
+    corn.leafStyle = LEAF_BLADE;
+    corn.kcInitial = 0.3f;
+    corn.kcMid = 1.2f;
+    corn.kcEnd = 0.6f;
+    cropTable.push_back(corn);
+
+    CropSpec wheat;
+    wheat.name = "wheat";
+    wheat.habit = CROP_FLOWERING;
+    wheat.baseTemperature = 0.0f;
+    wheat.upperTemperature = 26.0f;
+    wheat.gddToMaturity = 1600.0f;
+    wheat.flowerStage = 0.7f;
+    wheat.optimalTemperature = 20.0f;
+    wheat.temperatureTolerance = 7.0f;
+    wheat.minMoisture = 25.0f;
+    wheat.maxMoisture = 80.0f;
+    wheat.minHumidity = 30.0f;
+    wheat.heightScale = 0.6f;
+    wheat.stemRadius = 0.02f;
+    wheat.leafCount = 8;
+    wheat.leafCountSpread = 3;
+    wheat.leafSize = 0.15f;
+    wheat.stemColor = glm::vec3(0.6f, 0.7f, 0.3f);
+    wheat.leafColor = glm::vec3(0.3f, 0.7f, 0.2f);
+    wheat.leafStyle = LEAF_NARROW;
+    wheat.kcInitial = 0.3f;
+    wheat.kcMid = 1.15f;
+    wheat.kcEnd = 0.4f;
+    cropTable.push_back(wheat);
+
+    CropSpec tomato;
+    tomato.name = "tomato";
+    tomato.habit = CROP_FRUITING;
+    tomato.baseTemperature = 10.0f;
+    tomato.upperTemperature = 32.0f;
+    tomato.gddToMaturity = 1200.0f;
+    tomato.flowerStage = 0.6f;
+    tomato.fruitStage = 0.8f;
+    tomato.optimalTemperature = 24.0f;
+    tomato.temperatureTolerance = 6.0f;
+    tomato.minMoisture = 35.0f;
+    tomato.minHumidity = 40.0f;
+    tomato.heightScale = 0.8f;
+    tomato.stemRadius = 0.03f;
+    tomato.leafCount = 15;
+    tomato.leafCountSpread = 4;
+    tomato.leafSize = 0.2f;
+    tomato.stemColor = glm::vec3(0.3f, 0.5f, 0.2f);
+    tomato.leafColor = glm::vec3(0.2f, 0.6f, 0.1f);
+    tomato.leafStyle = LEAF_COMPOUND;
+    tomato.petalCount = 5;
+    tomato.kcInitial = 0.6f;
+    tomato.kcMid = 1.15f;
+    tomato.kcEnd = 0.8f;
+    cropTable.push_back(tomato);
+
+    CropSpec spinach;
+    spinach.name = "spinach";
+    spinach.habit = CROP_LEAFY;
+    spinach.baseTemperature = 2.0f;
+    spinach.upperTemperature = 24.0f;
+    spinach.gddToMaturity = 700.0f;
+    spinach.optimalTemperature = 18.0f;
+    spinach.temperatureTolerance = 8.0f;
+    spinach.minMoisture = 35.0f;
+    spinach.heightScale = 0.4f;
+    spinach.stemRadius = 0.015f;
+    spinach.leafCount = 20;
+    spinach.leafCountSpread = 5;
+    spinach.leafSize = 0.18f;
+    spinach.stemColor = glm::vec3(0.2f, 0.4f, 0.1f);
+    spinach.leafColor = glm::vec3(0.1f, 0.5f, 0.1f);
+    spinach.leafStyle = LEAF_ROUND;
+    spinach.kcInitial = 0.7f;
+    spinach.kcMid = 1.0f;
+    spinach.kcEnd = 0.95f;
+    cropTable.push_back(spinach);
+
+    if (!cropFile.empty()) {
+        std::ifstream in(cropFile);
+        if (!in) {
+            std::cout << "WARNING: cannot open crop file " << cropFile << ", using built-in crops only" << std::endl;
         }
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(in, line)) {
+            lineNumber++;
+            size_t first = line.find_first_not_of(" \t\r");
+            if (first == std::string::npos || line[first] == '#') continue;
+            CropSpec crop;
+            if (cropTable.size() >= 255) {
+                std::cout << "WARNING: crop table full, ignoring " << cropFile << ":" << lineNumber << std::endl;
+                break;
+            }
+            if (!parseCropDefinition(line, crop)) {
+                std::cout << "WARNING: invalid crop definition at " << cropFile << ":" << lineNumber << std::endl;
+                continue;
+            }
+            cropTable.push_back(crop);
+        }
+    }
 
-        // 生成详细的叶片位置数据
-        plant.leafPositions.clear();
-        plant.leafSizes.clear();
-        plant.branchPositions.clear();
+    std::cout << "Crop table:";
+    for (const auto& crop : cropTable) {
+        std::cout << " " << crop.name << " (" << crop.gddToMaturity << " GDD, base " << crop.baseTemperature << "C)";
+    }
+    std::cout << std::endl;
+}
 
-        for (int j = 0; j < plant.leafCount; j++) {
-            float heightRatio = (float)(j + 1) / (plant.leafCount + 1);
-            float angle = j * 137.5f * 3.14159f / 180.0f; // 黄金角度螺旋
+// 初始化增强植物系统 - 修复位置对齐
+void initializeDetailedPlants() {
+    plantStore.clear();
 
-            glm::vec3 leafPos = plant.position + glm::vec3(
-                cos(angle) * plant.leafSize * (1.0f + heightRatio * 0.5f),
-                plant.height * heightRatio * plant.growthStage,
-                sin(angle) * plant.leafSize * (1.0f + heightRatio * 0.5f)
-            );
+    const int targetPlants = farmConfig.targetPlants;
+    const float plantSpacing = farmConfig.plantSpacing;            // 植物间最小距离
+    const float buildingClearance = farmConfig.buildingClearance;  // 建筑周围安全距离
+    const float sensorClearance = farmConfig.sensorClearance;      // 传感器周围空间
+    const float extent = farmConfig.fieldHalfExtent;
+
+    std::vector<ExclusionZone> zones;
+    for (const auto& position : buildingStore.position) {
+        zones.emplace_back(glm::vec2(position.x, position.z), buildingClearance);
+    }
+    for (const auto& position : sensorStore.position) {
+        zones.emplace_back(glm::vec2(position.x, position.z), sensorClearance);
+    }
 
-            plant.leafPositions.push_back(leafPos);
-            plant.leafSizes.push_back(plant.leafSize * (0.7f + heightRatio * 0.5f) * plant.healthFactor);
+    // 泊松圆盘采样得到田地可容纳的全部位置，再随机选出目标数量（保持间距且分布均匀）
+    PhiloxStream placementRng(simulationSeed, RNG_PLANT_PLACEMENT, 0, 0);
+    std::vector<glm::vec2> sites = samplePoissonDisk(-extent, -extent, extent, extent, plantSpacing, zones, placementRng);
+    if ((int)sites.size() < targetPlants) {
+        std::cout << "WARNING: field fits only " << sites.size() << " of " << targetPlants
+            << " requested plants at " << plantSpacing << "m spacing" << std::endl;
+    }
+    else {
+        for (int i = 0; i < targetPlants; i++) {
+            size_t pick = i + placementRng.below((uint32_t)(sites.size() - i));
+            std::swap(sites[i], sites[pick]);
         }
+        sites.resize(targetPlants);
+    }
+    // 按行排序，相邻植物在内存中也相邻
+    std::sort(sites.begin(), sites.end(), [plantSpacing](const glm::vec2& a, const glm::vec2& b) {
+        int rowA = (int)std::floor(a.y / plantSpacing), rowB = (int)std::floor(b.y / plantSpacing);
+        return rowA != rowB ? rowA < rowB : a.x < b.x;
+    });
+
+    // 先确定每个位置的作物，再按作物稳定排序（同一作物内仍按行排列）：
+    // 植物内核按作物批次处理，热循环里没有逐株的类型分支
+    const uint32_t cropCount = (uint32_t)cropTable.size();
+    std::vector<uint32_t> siteCrop(sites.size());
+    std::vector<size_t> cropStart(cropCount + 1, 0);
+    for (size_t i = 0; i < sites.size(); i++) {
+        PhiloxStream rng(simulationSeed, RNG_PLANT_INIT, (uint32_t)i, 0);
+        siteCrop[i] = rng.below(cropCount);
+        cropStart[siteCrop[i] + 1]++;
+    }
+    for (uint32_t c = 0; c < cropCount; c++) {
+        cropStart[c + 1] += cropStart[c];
+    }
+    std::vector<uint32_t> order(sites.size());
+    for (size_t i = 0; i < sites.size(); i++) {
+        order[cropStart[siteCrop[i]]++] = (uint32_t)i;
+    }
+
+    plantStore.reserve(sites.size());
+    for (uint32_t i : order) {
+        DetailedPlant plant;
+        plant.position = glm::vec3(sites[i].x, 0.0f, sites[i].y);
+
+        // 随机流按位置编号，与排序后的行号无关
+        PhiloxStream rng(simulationSeed, RNG_PLANT_INIT, i, 0);
+        plant.plantType = (int)rng.below(cropCount);
+        plant.healthFactor = rng.uniform(0.7f, 1.0f);
+        plant.windPhase = rng.uniform(0.0f, 6.28f);
+        plant.growthStage = 0.6f + rng.uniform(0.7f, 1.0f) * 0.4f;
+
+        // 形态和物候取自作物参数表
+        const CropSpec& crop = cropTable[plant.plantType];
+        plant.height = rng.uniform(0.8f, 2.5f) * crop.heightScale;
+        plant.stemRadius = crop.stemRadius;
+        plant.leafCount = crop.leafCount + (int)(i % (uint32_t)crop.leafCountSpread);
+        plant.leafSize = crop.leafSize;
+        plant.stemColor = crop.stemColor;
+        plant.leafColor = crop.leafColor;
+        plant.hasFlowers = crop.habit != CROP_LEAFY && plant.growthStage > crop.flowerStage;
+        plant.hasFruits = crop.habit == CROP_FRUITING && plant.growthStage > crop.fruitStage;
 
         // 根系扩展
         plant.rootSpread = plant.leafSize * 1.5f * plant.healthFactor;
 
         // 随机疾病和虫害
-        if (gen() % 100 < 5) { // 5%概率
+        if (rng.below(100) < 5) { // 5%概率
             plant.isPestInfected = true;
             plant.healthFactor *= 0.7f;
         }
@@ -1300,41 +3696,748 @@ void initializeDetailedPlants() {
         plant.leafColor *= healthEffect;
         plant.stemColor *= healthEffect;
 
-        plants.push_back(plant);
+        plantStore.add(plant);
     }
 
-    std::cout << "Advanced plant ecosystem established - " << plants.size() << " multi-type crops (position optimized)" << std::endl;
+    std::cout << "Advanced plant ecosystem established - " << plantStore.size() << " plants of "
+        << cropCount << " crop type(s) (position optimized, crop-sorted)" << std::endl;
 }
 
-// 创建贝塞尔曲线路径
-void createBezierPaths() {
-    paths.clear();
+// 把连续的同作物行切成不超过一个植物块的批次（初始化后植物按作物排序，通常每种作物只有一段）
+void rebuildPlantBatches() {
+    plantBatches.clear();
+    const std::vector<unsigned char>& type = plantStore.shape.plantType;
+    size_t begin = 0;
+    while (begin < type.size()) {
+        size_t runEnd = begin + 1;
+        while (runEnd < type.size() && type[runEnd] == type[begin]) runEnd++;
+        for (size_t b = begin; b < runEnd; b += plantChunkSize) {
+            plantBatches.emplace_back(type[begin], b, std::min(b + plantChunkSize, runEnd));
+        }
+        begin = runEnd;
+    }
+    plantBatchesStale = false;
+}
 
-    // 主要道路系统 - 连接各建筑的曲线道路
-    BezierPath mainRoad;
-    mainRoad.controlPoints = {
-        glm::vec3(-20.0f, 0.1f, -20.0f),  // 起点
-        glm::vec3(-5.0f, 0.1f, -25.0f),   // 控制点1
-        glm::vec3(5.0f, 0.1f, -25.0f),    // 控制点2
-        glm::vec3(20.0f, 0.1f, -20.0f)    // 终点
-    };
-    mainRoad.pathColor = glm::vec3(0.4f, 0.4f, 0.4f); // 灰色道路
-    mainRoad.pathWidth = 0.8f;
-    mainRoad.segments = 30;
-    paths.push_back(mainRoad);
+// 预留各列容量
+void PlantArchetype::reserve(size_t count) {
+    sim.healthFactor.reserve(count);
+    sim.growthStage.reserve(count);
+    sim.leafColorR.reserve(count);
+    sim.leafColorG.reserve(count);
+    sim.pestInfected.reserve(count);
+    sim.hasFlowers.reserve(count);
+    sim.hasFruits.reserve(count);
+    sim.localTemperature.reserve(count);
+    sim.localHumidity.reserve(count);
+    sim.localMoisture.reserve(count);
+    sim.witherSeconds.reserve(count);
+    site.sensorWeights.reserve(count);
+    site.soilCell.reserve(count);
+    shape.position.reserve(count);
+    shape.height.reserve(count);
+    shape.stemRadius.reserve(count);
+    shape.leafSize.reserve(count);
+    shape.rootSpread.reserve(count);
+    shape.windPhase.reserve(count);
+    shape.leafColorB.reserve(count);
+    shape.stemColor.reserve(count);
+    shape.leafCount.reserve(count);
+    shape.plantType.reserve(count);
+}
 
-    // 灌溉主管道 - 弯曲的水管系统
-    BezierPath irrigation;
-    irrigation.controlPoints = {
-        glm::vec3(-15.0f, 0.05f, 8.0f),   // 从水处理站开始
-        glm::vec3(-5.0f, 0.05f, 12.0f),   // 控制点1
-        glm::vec3(5.0f, 0.05f, 12.0f),    // 控制点2
-        glm::vec3(15.0f, 0.05f, 8.0f)     // 到工具房
-    };
-    irrigation.pathColor = glm::vec3(0.2f, 0.6f, 0.8f); // 蓝色管道
-    irrigation.pathWidth = 0.3f;
-    irrigation.segments = 25;
-    paths.push_back(irrigation);
+// 把植物生成记录拆分写入各列
+EntityHandle PlantArchetype::add(const DetailedPlant& plant) {
+    sim.healthFactor.push_back(plant.healthFactor);
+    sim.growthStage.push_back(plant.growthStage);
+    sim.leafColorR.push_back(plant.leafColor.r);
+    sim.leafColorG.push_back(plant.leafColor.g);
+    sim.pestInfected.push_back(plant.isPestInfected ? 1 : 0);
+    sim.hasFlowers.push_back(plant.hasFlowers ? 1 : 0);
+    sim.hasFruits.push_back(plant.hasFruits ? 1 : 0);
+    sim.localTemperature.push_back(22.0f);
+    sim.localHumidity.push_back(60.0f);
+    sim.localMoisture.push_back(45.0f);
+    sim.witherSeconds.push_back(0.0f);
+
+    // 小气候采样表（传感器网络和土壤网格先于植物初始化）
+    SensorWeights weights;
+    computeSensorWeights(plant.position.x, plant.position.z, weights);
+    site.sensorWeights.push_back(weights);
+    site.soilCell.push_back((uint32_t)soilGrid.cellAt(plant.position.x, plant.position.z));
+    microclimateStale = true;
+
+    shape.position.push_back(plant.position);
+    shape.height.push_back(plant.height);
+    shape.stemRadius.push_back(plant.stemRadius);
+    shape.leafSize.push_back(plant.leafSize);
+    shape.rootSpread.push_back(plant.rootSpread);
+    shape.windPhase.push_back(plant.windPhase);
+    shape.leafColorB.push_back(plant.leafColor.b);
+    shape.stemColor.push_back(plant.stemColor);
+    shape.leafCount.push_back((unsigned char)std::min(plant.leafCount, maxLeavesPerPlant));
+    shape.plantType.push_back((unsigned char)plant.plantType);
+    plantBatchesStale = true;
+    pestGrid.bucketsStale = true;
+    return index.add();
+}
+
+// 收获后原地重新种植：生长内核已在同一步内把该行重置为幼苗（并继续结算本步的健康和物候），
+// 这里只换代，旧句柄不再有效
+EntityHandle PlantArchetype::replant(size_t row) {
+    return index.renew(row);
+}
+
+// 删除植物，末行补位
+bool PlantArchetype::remove(EntityHandle handle) {
+    uint32_t row = index.remove(handle);
+    if (row == 0xFFFFFFFFu) return false;
+    swapRemoveRow(sim.healthFactor, row);
+    swapRemoveRow(sim.growthStage, row);
+    swapRemoveRow(sim.leafColorR, row);
+    swapRemoveRow(sim.leafColorG, row);
+    swapRemoveRow(sim.pestInfected, row);
+    swapRemoveRow(sim.hasFlowers, row);
+    swapRemoveRow(sim.hasFruits, row);
+    swapRemoveRow(sim.localTemperature, row);
+    swapRemoveRow(sim.localHumidity, row);
+    swapRemoveRow(sim.localMoisture, row);
+    swapRemoveRow(sim.witherSeconds, row);
+    swapRemoveRow(site.sensorWeights, row);
+    swapRemoveRow(site.soilCell, row);
+    swapRemoveRow(shape.position, row);
+    swapRemoveRow(shape.height, row);
+    swapRemoveRow(shape.stemRadius, row);
+    swapRemoveRow(shape.leafSize, row);
+    swapRemoveRow(shape.rootSpread, row);
+    swapRemoveRow(shape.windPhase, row);
+    swapRemoveRow(shape.leafColorB, row);
+    swapRemoveRow(shape.stemColor, row);
+    swapRemoveRow(shape.leafCount, row);
+    swapRemoveRow(shape.plantType, row);
+    plantBatchesStale = true;
+    pestGrid.bucketsStale = true;
+    return true;
+}
+
+void PlantArchetype::clear() {
+    index.clear();
+    sim = PlantColumns();
+    site = PlantSiteColumns();
+    shape = PlantShapeColumns();
+    plantBatchesStale = true;
+}
+
+// 检测CPU支持的最高植物内核级别
+PlantKernelLevel detectPlantKernelLevel() {
+#ifdef FARM_X86
+#if defined(_MSC_VER)
+    int info[4] = { 0, 0, 0, 0 };
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    bool avx2 = false;
+    if (maxLeaf >= 7 && osxsave && avx) {
+        // 操作系统需保存YMM寄存器状态
+        unsigned long long xcr0 = _xgetbv(0);
+        if ((xcr0 & 0x6) == 0x6) {
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & (1 << 5)) != 0;
+        }
+    }
+    return avx2 ? PLANT_KERNEL_AVX2 : PLANT_KERNEL_SSE2;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return PLANT_KERNEL_AVX2;
+    return PLANT_KERNEL_SSE2;
+#endif
+#else
+    return PLANT_KERNEL_SCALAR;
+#endif
+}
+
+// 选择植物内核（requestedLevel < 0 时自动检测，强制级别不会超过CPU支持的级别）
+void selectPlantKernel(int requestedLevel) {
+    PlantKernelLevel supported = detectPlantKernelLevel();
+    PlantKernelLevel level = supported;
+    if (requestedLevel >= 0 && requestedLevel < (int)supported) {
+        level = (PlantKernelLevel)requestedLevel;
+    }
+
+    plantKernelLevel = level;
+    const char* names[] = { "Scalar", "SSE2 (4 plants/op)", "AVX2 (8 plants/op)" };
+    switch (level) {
+    case PLANT_KERNEL_AVX2:
+        plantKernels[CROP_LEAFY] = updatePlantsAVX2<CROP_LEAFY>;
+        plantKernels[CROP_FLOWERING] = updatePlantsAVX2<CROP_FLOWERING>;
+        plantKernels[CROP_FRUITING] = updatePlantsAVX2<CROP_FRUITING>;
+        break;
+    case PLANT_KERNEL_SSE2:
+        plantKernels[CROP_LEAFY] = updatePlantsSSE2<CROP_LEAFY>;
+        plantKernels[CROP_FLOWERING] = updatePlantsSSE2<CROP_FLOWERING>;
+        plantKernels[CROP_FRUITING] = updatePlantsSSE2<CROP_FRUITING>;
+        break;
+    default:
+        plantKernels[CROP_LEAFY] = updatePlantsScalar<CROP_LEAFY>;
+        plantKernels[CROP_FLOWERING] = updatePlantsScalar<CROP_FLOWERING>;
+        plantKernels[CROP_FRUITING] = updatePlantsScalar<CROP_FRUITING>;
+        break;
+    }
+    std::cout << "Plant growth kernel: " << names[level] << std::endl;
+}
+
+// 填入作物相关的内核参数：积温增量 = 有效积温 × 本tick折合的作物天数 / 成熟积温
+void PlantKernelParams::setCrop(const CropSpec& crop, float deltaTime) {
+    gddScale = deltaTime / dayLengthSeconds * cropDaysPerSimDay / crop.gddToMaturity;
+    baseTemperature = crop.baseTemperature;
+    upperTemperature = crop.upperTemperature;
+    flowerStage = crop.habit != CROP_LEAFY ? crop.flowerStage : 2.0f;
+    fruitStage = crop.habit == CROP_FRUITING ? crop.fruitStage : 2.0f;
+    optimalTemperature = crop.optimalTemperature;
+    temperatureTolerance = crop.temperatureTolerance;
+    minMoisture = crop.minMoisture;
+    maxMoisture = crop.maxMoisture;
+    minHumidity = crop.minHumidity;
+}
+
+// 植物生长与健康内核 - 标量版本（也是SIMD版本的尾部处理和参考实现）。
+// 一次只处理同一作物的一批植物，Habit 在编译期去掉不开花/不结果作物的物候判断
+template<CropHabit Habit>
+void updatePlantsScalar(PlantColumns& columns, size_t begin, size_t end,
+    const PlantKernelParams& params, PlantKernelResult& result) {
+    float* health = columns.healthFactor.data();
+    float* growth = columns.growthStage.data();
+    for (size_t i = begin; i < end; i++) {
+        float h = health[i];
+        float g = growth[i];
+
+        // 施肥
+        h = std::min(1.0f, h + params.fertilizerHealth);
+        g = std::min(1.0f, g + params.fertilizerGrowth);
+
+        // 夜间照明
+        g += params.nightGrowth;
+
+        // 自动收获并重新种植
+        if (g > params.harvestGrowthMin && h > 0.75f) {
+            g = 0.2f;
+            h = 0.8f;
+            result.harvested++;
+            result.harvestedRows.push_back((uint32_t)i);
+        }
+
+        // 气候控制
+        h = std::min(1.0f, h + params.climateHealth);
+
+        // 小气候适宜度：局部温度、土壤水分、湿度超出适宜范围时减缓生长并压低健康上限
+        float tempStress = std::max(std::fabs(columns.localTemperature[i] - params.optimalTemperature) -
+            params.temperatureTolerance, 0.0f) * 0.1f;
+        float dryStress = std::max(params.minMoisture - columns.localMoisture[i], 0.0f) * 0.03f;
+        float wetStress = std::max(columns.localMoisture[i] - params.maxMoisture, 0.0f) * 0.03f;
+        float airStress = std::max(params.minHumidity - columns.localHumidity[i], 0.0f) * 0.02f;
+        float suitability = std::max(1.0f - (((tempStress + dryStress) + wetStress) + airStress), 0.0f);
+
+        h = clamp(h * params.weatherEffect, 0.4f, 1.0f);
+        // 不适宜的小气候和病虫害压低健康上限
+        float healthCap = 0.5f + 0.5f * suitability;
+        if (columns.pestInfected[i]) healthCap = std::min(healthCap, params.pestHealthCap);
+        h = std::min(h, healthCap);
+        // 积温驱动发育：上下限温度之间的有效温度，受健康和小气候胁迫折减
+        float thermalTime = std::max(std::min(columns.localTemperature[i], params.upperTemperature) -
+            params.baseTemperature, 0.0f);
+        g = clamp(g + params.gddScale * thermalTime * h * suitability, 0.0f, 1.0f);
+
+        // 根据健康度和生长阶段调整叶色
+        float healthEffect = h * g;
+        columns.leafColorR[i] = 0.1f + (1.0f - healthEffect) * 0.2f;
+        columns.leafColorG[i] = 0.3f + healthEffect * 0.5f;
+
+        // 开花结果
+        columns.hasFlowers[i] = (Habit != CROP_LEAFY && g > params.flowerStage) ? 1 : 0;
+        columns.hasFruits[i] = (Habit == CROP_FRUITING && g > params.fruitStage && h > 0.7f) ? 1 : 0;
+
+        health[i] = h;
+        growth[i] = g;
+    }
+}
+
+// 非零64位字中最低位的序号
+inline int lowestSetBit64(uint64_t bits) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    if (_BitScanForward(&index, (unsigned long)bits)) return (int)index;
+    _BitScanForward(&index, (unsigned long)(bits >> 32));
+    return (int)index + 32;
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+#ifdef FARM_X86
+// 非零位掩码中最低位的序号
+inline int lowestSetBit(int bits) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, (unsigned long)bits);
+    return (int)index;
+#else
+    return __builtin_ctz((unsigned)bits);
+#endif
+}
+
+// 将8位比较掩码展开为8个0/1字节（第k位写入第k个字节，小端）。
+// 高低4位分别相乘：8位一起乘时第0位和第7位的部分积会进位到第1个字节
+inline unsigned long long expandMaskToBytes(int bits) {
+    unsigned long long low = ((unsigned long long)(bits & 0xF) * 0x00204081ULL) & 0x01010101ULL;
+    unsigned long long high = ((unsigned long long)((bits >> 4) & 0xF) * 0x00204081ULL) & 0x01010101ULL;
+    return low | (high << 32);
+}
+
+// 植物内核 - SSE2版本，每条指令处理4株
+template<CropHabit Habit>
+void updatePlantsSSE2(PlantColumns& columns, size_t begin, size_t end,
+    const PlantKernelParams& params, PlantKernelResult& result) {
+    float* health = columns.healthFactor.data();
+    float* growth = columns.growthStage.data();
+    float* leafR = columns.leafColorR.data();
+    float* leafG = columns.leafColorG.data();
+    const unsigned char* infected = columns.pestInfected.data();
+    unsigned char* flowers = columns.hasFlowers.data();
+    unsigned char* fruits = columns.hasFruits.data();
+
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 minHealth = _mm_set1_ps(0.4f);
+    const __m128 harvestHealth = _mm_set1_ps(0.75f);
+    const __m128 fruitHealth = _mm_set1_ps(0.7f);
+    const __m128 replantGrowth = _mm_set1_ps(0.2f);
+    const __m128 replantHealth = _mm_set1_ps(0.8f);
+    const __m128 pestHealthCap = _mm_set1_ps(params.pestHealthCap);
+    const __m128 fertHealth = _mm_set1_ps(params.fertilizerHealth);
+    const __m128 fertGrowth = _mm_set1_ps(params.fertilizerGrowth);
+    const __m128 nightGrowth = _mm_set1_ps(params.nightGrowth);
+    const __m128 climateHealth = _mm_set1_ps(params.climateHealth);
+    const __m128 harvestGrowth = _mm_set1_ps(params.harvestGrowthMin);
+    const __m128 weatherEffect = _mm_set1_ps(params.weatherEffect);
+    const __m128 gddScale = _mm_set1_ps(params.gddScale);
+    const __m128 baseTemperature = _mm_set1_ps(params.baseTemperature);
+    const __m128 upperTemperature = _mm_set1_ps(params.upperTemperature);
+    const __m128 flowerStage = _mm_set1_ps(params.flowerStage);
+    const __m128 fruitStage = _mm_set1_ps(params.fruitStage);
+    const __m128 redBase = _mm_set1_ps(0.1f);
+    const __m128 redScale = _mm_set1_ps(0.2f);
+    const __m128 greenBase = _mm_set1_ps(0.3f);
+    const __m128 greenScale = _mm_set1_ps(0.5f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 optimalTemperature = _mm_set1_ps(params.optimalTemperature);
+    const __m128 temperatureTolerance = _mm_set1_ps(params.temperatureTolerance);
+    const __m128 minMoisture = _mm_set1_ps(params.minMoisture);
+    const __m128 maxMoisture = _mm_set1_ps(params.maxMoisture);
+    const __m128 minHumidity = _mm_set1_ps(params.minHumidity);
+    const __m128 tempScale = _mm_set1_ps(0.1f);
+    const __m128 moistureScale = _mm_set1_ps(0.03f);
+    const __m128 humidityScale = _mm_set1_ps(0.02f);
+    const float* localTemperature = columns.localTemperature.data();
+    const float* localHumidity = columns.localHumidity.data();
+    const float* localMoisture = columns.localMoisture.data();
+
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 h = _mm_loadu_ps(health + i);
+        __m128 g = _mm_loadu_ps(growth + i);
+
+        // 感染标记扩展为浮点掩码
+        int infectedBits = (infected[i] ? 1 : 0) | (infected[i + 1] ? 2 : 0) |
+            (infected[i + 2] ? 4 : 0) | (infected[i + 3] ? 8 : 0);
+        __m128i infectedLanes = _mm_set_epi32(-(infectedBits >> 3 & 1), -(infectedBits >> 2 & 1),
+            -(infectedBits >> 1 & 1), -(infectedBits & 1));
+        __m128 infectedMask = _mm_castsi128_ps(infectedLanes);
+
+        h = _mm_min_ps(one, _mm_add_ps(h, fertHealth));
+        g = _mm_min_ps(one, _mm_add_ps(g, fertGrowth));
+        g = _mm_add_ps(g, nightGrowth);
+
+        __m128 harvest = _mm_and_ps(_mm_cmpgt_ps(g, harvestGrowth), _mm_cmpgt_ps(h, harvestHealth));
+        g = _mm_or_ps(_mm_and_ps(harvest, replantGrowth), _mm_andnot_ps(harvest, g));
+        h = _mm_or_ps(_mm_and_ps(harvest, replantHealth), _mm_andnot_ps(harvest, h));
+        for (int bits = _mm_movemask_ps(harvest); bits != 0; bits &= bits - 1) {
+            result.harvested++;
+            result.harvestedRows.push_back((uint32_t)(i + lowestSetBit(bits)));
+        }
+
+        h = _mm_min_ps(one, _mm_add_ps(h, climateHealth));
+
+        __m128 temperature = _mm_loadu_ps(localTemperature + i);
+        __m128 moisture = _mm_loadu_ps(localMoisture + i);
+        __m128 tempStress = _mm_mul_ps(_mm_max_ps(_mm_sub_ps(
+            _mm_andnot_ps(signMask, _mm_sub_ps(temperature, optimalTemperature)), temperatureTolerance), zero), tempScale);
+        __m128 dryStress = _mm_mul_ps(_mm_max_ps(_mm_sub_ps(minMoisture, moisture), zero), moistureScale);
+        __m128 wetStress = _mm_mul_ps(_mm_max_ps(_mm_sub_ps(moisture, maxMoisture), zero), moistureScale);
+        __m128 airStress = _mm_mul_ps(_mm_max_ps(_mm_sub_ps(minHumidity, _mm_loadu_ps(localHumidity + i)), zero), humidityScale);
+        __m128 suitability = _mm_max_ps(_mm_sub_ps(one,
+            _mm_add_ps(_mm_add_ps(_mm_add_ps(tempStress, dryStress), wetStress), airStress)), zero);
+
+        h = _mm_min_ps(_mm_max_ps(_mm_mul_ps(h, weatherEffect), minHealth), one);
+        __m128 healthCap = _mm_add_ps(half, _mm_mul_ps(half, suitability));
+        healthCap = _mm_min_ps(healthCap, _mm_or_ps(_mm_and_ps(infectedMask, pestHealthCap), _mm_andnot_ps(infectedMask, one)));
+        h = _mm_min_ps(h, healthCap);
+        __m128 thermalTime = _mm_max_ps(_mm_sub_ps(_mm_min_ps(temperature, upperTemperature), baseTemperature), zero);
+        g = _mm_min_ps(_mm_max_ps(_mm_add_ps(g,
+            _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(gddScale, thermalTime), h), suitability)), zero), one);
+
+        __m128 healthEffect = _mm_mul_ps(h, g);
+        _mm_storeu_ps(leafR + i, _mm_add_ps(redBase, _mm_mul_ps(_mm_sub_ps(one, healthEffect), redScale)));
+        _mm_storeu_ps(leafG + i, _mm_add_ps(greenBase, _mm_mul_ps(healthEffect, greenScale)));
+
+        int flowerBits = Habit != CROP_LEAFY ? _mm_movemask_ps(_mm_cmpgt_ps(g, flowerStage)) : 0;
+        int fruitBits = Habit == CROP_FRUITING ? _mm_movemask_ps(_mm_and_ps(_mm_cmpgt_ps(g, fruitStage),
+            _mm_cmpgt_ps(h, fruitHealth))) : 0;
+        unsigned long long flowerBytes = expandMaskToBytes(flowerBits);
+        unsigned long long fruitBytes = expandMaskToBytes(fruitBits);
+        memcpy(flowers + i, &flowerBytes, 4);
+        memcpy(fruits + i, &fruitBytes, 4);
+
+        _mm_storeu_ps(health + i, h);
+        _mm_storeu_ps(growth + i, g);
+    }
+
+    updatePlantsScalar<Habit>(columns, i, end, params, result);
+}
+
+// 植物内核 - AVX2版本，每条指令处理8株
+template<CropHabit Habit>
+FARM_TARGET_AVX2
+void updatePlantsAVX2(PlantColumns& columns, size_t begin, size_t end,
+    const PlantKernelParams& params, PlantKernelResult& result) {
+    float* health = columns.healthFactor.data();
+    float* growth = columns.growthStage.data();
+    float* leafR = columns.leafColorR.data();
+    float* leafG = columns.leafColorG.data();
+    const unsigned char* infected = columns.pestInfected.data();
+    unsigned char* flowers = columns.hasFlowers.data();
+    unsigned char* fruits = columns.hasFruits.data();
+
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 minHealth = _mm256_set1_ps(0.4f);
+    const __m256 harvestHealth = _mm256_set1_ps(0.75f);
+    const __m256 fruitHealth = _mm256_set1_ps(0.7f);
+    const __m256 replantGrowth = _mm256_set1_ps(0.2f);
+    const __m256 replantHealth = _mm256_set1_ps(0.8f);
+    const __m256 pestHealthCap = _mm256_set1_ps(params.pestHealthCap);
+    const __m256 fertHealth = _mm256_set1_ps(params.fertilizerHealth);
+    const __m256 fertGrowth = _mm256_set1_ps(params.fertilizerGrowth);
+    const __m256 nightGrowth = _mm256_set1_ps(params.nightGrowth);
+    const __m256 climateHealth = _mm256_set1_ps(params.climateHealth);
+    const __m256 harvestGrowth = _mm256_set1_ps(params.harvestGrowthMin);
+    const __m256 weatherEffect = _mm256_set1_ps(params.weatherEffect);
+    const __m256 gddScale = _mm256_set1_ps(params.gddScale);
+    const __m256 baseTemperature = _mm256_set1_ps(params.baseTemperature);
+    const __m256 upperTemperature = _mm256_set1_ps(params.upperTemperature);
+    const __m256 flowerStage = _mm256_set1_ps(params.flowerStage);
+    const __m256 fruitStage = _mm256_set1_ps(params.fruitStage);
+    const __m256 redBase = _mm256_set1_ps(0.1f);
+    const __m256 redScale = _mm256_set1_ps(0.2f);
+    const __m256 greenBase = _mm256_set1_ps(0.3f);
+    const __m256 greenScale = _mm256_set1_ps(0.5f);
+    const __m256i zeroInt = _mm256_setzero_si256();
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    const __m256 optimalTemperature = _mm256_set1_ps(params.optimalTemperature);
+    const __m256 temperatureTolerance = _mm256_set1_ps(params.temperatureTolerance);
+    const __m256 minMoisture = _mm256_set1_ps(params.minMoisture);
+    const __m256 maxMoisture = _mm256_set1_ps(params.maxMoisture);
+    const __m256 minHumidity = _mm256_set1_ps(params.minHumidity);
+    const __m256 tempScale = _mm256_set1_ps(0.1f);
+    const __m256 moistureScale = _mm256_set1_ps(0.03f);
+    const __m256 humidityScale = _mm256_set1_ps(0.02f);
+    const float* localTemperature = columns.localTemperature.data();
+    const float* localHumidity = columns.localHumidity.data();
+    const float* localMoisture = columns.localMoisture.data();
+
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 h = _mm256_loadu_ps(health + i);
+        __m256 g = _mm256_loadu_ps(growth + i);
+
+        // 8个字节的感染标记扩展为32位掩码
+        __m256i infected32 = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(infected + i)));
+        __m256 infectedMask = _mm256_castsi256_ps(_mm256_cmpgt_epi32(infected32, zeroInt));
+
+        h = _mm256_min_ps(one, _mm256_add_ps(h, fertHealth));
+        g = _mm256_min_ps(one, _mm256_add_ps(g, fertGrowth));
+        g = _mm256_add_ps(g, nightGrowth);
+
+        __m256 harvest = _mm256_and_ps(_mm256_cmp_ps(g, harvestGrowth, _CMP_GT_OQ),
+            _mm256_cmp_ps(h, harvestHealth, _CMP_GT_OQ));
+        g = _mm256_blendv_ps(g, replantGrowth, harvest);
+        h = _mm256_blendv_ps(h, replantHealth, harvest);
+        for (int bits = _mm256_movemask_ps(harvest); bits != 0; bits &= bits - 1) {
+            result.harvested++;
+            result.harvestedRows.push_back((uint32_t)(i + lowestSetBit(bits)));
+        }
+
+        h = _mm256_min_ps(one, _mm256_add_ps(h, climateHealth));
+
+        __m256 temperature = _mm256_loadu_ps(localTemperature + i);
+        __m256 moisture = _mm256_loadu_ps(localMoisture + i);
+        __m256 tempStress = _mm256_mul_ps(_mm256_max_ps(_mm256_sub_ps(
+            _mm256_andnot_ps(signMask, _mm256_sub_ps(temperature, optimalTemperature)), temperatureTolerance), zero), tempScale);
+        __m256 dryStress = _mm256_mul_ps(_mm256_max_ps(_mm256_sub_ps(minMoisture, moisture), zero), moistureScale);
+        __m256 wetStress = _mm256_mul_ps(_mm256_max_ps(_mm256_sub_ps(moisture, maxMoisture), zero), moistureScale);
+        __m256 airStress = _mm256_mul_ps(_mm256_max_ps(_mm256_sub_ps(minHumidity, _mm256_loadu_ps(localHumidity + i)), zero), humidityScale);
+        __m256 suitability = _mm256_max_ps(_mm256_sub_ps(one,
+            _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(tempStress, dryStress), wetStress), airStress)), zero);
+
+        h = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(h, weatherEffect), minHealth), one);
+        __m256 healthCap = _mm256_add_ps(half, _mm256_mul_ps(half, suitability));
+        healthCap = _mm256_min_ps(healthCap, _mm256_blendv_ps(one, pestHealthCap, infectedMask));
+        h = _mm256_min_ps(h, healthCap);
+        __m256 thermalTime = _mm256_max_ps(_mm256_sub_ps(_mm256_min_ps(temperature, upperTemperature), baseTemperature), zero);
+        g = _mm256_min_ps(_mm256_max_ps(_mm256_add_ps(g,
+            _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(gddScale, thermalTime), h), suitability)), zero), one);
+
+        __m256 healthEffect = _mm256_mul_ps(h, g);
+        _mm256_storeu_ps(leafR + i, _mm256_add_ps(redBase, _mm256_mul_ps(_mm256_sub_ps(one, healthEffect), redScale)));
+        _mm256_storeu_ps(leafG + i, _mm256_add_ps(greenBase, _mm256_mul_ps(healthEffect, greenScale)));
+
+        int flowerBits = Habit != CROP_LEAFY ? _mm256_movemask_ps(_mm256_cmp_ps(g, flowerStage, _CMP_GT_OQ)) : 0;
+        int fruitBits = Habit == CROP_FRUITING ? _mm256_movemask_ps(_mm256_and_ps(
+            _mm256_cmp_ps(g, fruitStage, _CMP_GT_OQ),
+            _mm256_cmp_ps(h, fruitHealth, _CMP_GT_OQ))) : 0;
+        unsigned long long flowerBytes = expandMaskToBytes(flowerBits);
+        unsigned long long fruitBytes = expandMaskToBytes(fruitBits);
+        memcpy(flowers + i, &flowerBytes, 8);
+        memcpy(fruits + i, &fruitBytes, 8);
+
+        _mm256_storeu_ps(health + i, h);
+        _mm256_storeu_ps(growth + i, g);
+    }
+
+    updatePlantsScalar<Habit>(columns, i, end, params, result);
+}
+#else
+// 非x86平台只有标量内核
+template<CropHabit Habit>
+void updatePlantsSSE2(PlantColumns& columns, size_t begin, size_t end,
+    const PlantKernelParams& params, PlantKernelResult& result) {
+    updatePlantsScalar<Habit>(columns, begin, end, params, result);
+}
+
+template<CropHabit Habit>
+void updatePlantsAVX2(PlantColumns& columns, size_t begin, size_t end,
+    const PlantKernelParams& params, PlantKernelResult& result) {
+    updatePlantsScalar<Habit>(columns, begin, end, params, result);
+}
+#endif
+
+// 单个土壤单元更新：五点模板扩散 + 喷灌/降雨入渗 - 蒸发 - 超出田间持水量的渗漏，
+// 氮素随水施入、横向扩散并随渗漏淋洗。SIMD版本按完全相同的运算顺序计算，结果逐位一致
+inline void stepSoilCell(const SoilRowView& row, int x, int left, int right, const SoilStepParams& params) {
+    float coverage = row.coverageX[x] * row.coverageZ;
+    uint32_t zone = row.zone[x];
+
+    float m = row.moisture[x];
+    float lap = ((row.moisture[left] + row.moisture[right]) + (row.moistureUp[x] + row.moistureDown[x])) - m * 4.0f;
+    float m1 = m + params.diffusion * lap;
+    m1 = (m1 + coverage * params.zoneWater[zone]) + params.rainfall;
+    m1 = m1 - m * params.evaporation;
+    float drain = std::max(m1 - params.fieldCapacity, 0.0f) * params.drainFraction;
+    m1 = std::min(std::max(m1 - drain, 0.0f), 100.0f);
+
+    float n = row.nitrogen[x];
+    float lapN = ((row.nitrogen[left] + row.nitrogen[right]) + (row.nitrogenUp[x] + row.nitrogenDown[x])) - n * 4.0f;
+    float n1 = n + params.nutrientDiffusion * lapN;
+    n1 = n1 + coverage * params.zoneNitrogen[zone];
+    n1 = n1 - n * (drain * params.leachRate);
+    n1 = std::min(std::max(n1, 0.0f), 100.0f);
+
+    row.moistureOut[x] = m1;
+    row.nitrogenOut[x] = n1;
+}
+
+// 土壤行内核 - 标量版本（也是SIMD版本的边界列处理和参考实现）
+void stepSoilRowScalar(SoilGrid& grid, int z, const SoilStepParams& params) {
+    SoilRowView row(grid, z, params.dt);
+    for (int x = 0; x < row.width; x++) {
+        stepSoilCell(row, x, std::max(x - 1, 0), std::min(x + 1, row.width - 1), params);
+    }
+}
+
+#ifdef FARM_X86
+// 土壤行内核 - SSE2版本，内部列每条指令处理4个单元格，两端列走标量
+void stepSoilRowSSE2(SoilGrid& grid, int z, const SoilStepParams& params) {
+    SoilRowView row(grid, z, params.dt);
+    int width = row.width;
+    if (width < 3) {
+        stepSoilRowScalar(grid, z, params);
+        return;
+    }
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 four = _mm_set1_ps(4.0f);
+    const __m128 hundred = _mm_set1_ps(100.0f);
+    const __m128 diffusion = _mm_set1_ps(params.diffusion);
+    const __m128 nutrientDiffusion = _mm_set1_ps(params.nutrientDiffusion);
+    const __m128 rainfall = _mm_set1_ps(params.rainfall);
+    const __m128 evaporation = _mm_set1_ps(params.evaporation);
+    const __m128 fieldCapacity = _mm_set1_ps(params.fieldCapacity);
+    const __m128 drainFraction = _mm_set1_ps(params.drainFraction);
+    const __m128 leachRate = _mm_set1_ps(params.leachRate);
+    const __m128 coverageZ = _mm_set1_ps(row.coverageZ);
+
+    stepSoilCell(row, 0, 0, 1, params);
+    int x = 1;
+    for (; x + 4 <= width - 1; x += 4) {
+        __m128 coverage = _mm_mul_ps(_mm_loadu_ps(row.coverageX + x), coverageZ);
+        // 控制区阀门表没有SSE2收集指令，逐个取出
+        const uint32_t* zone = row.zone + x;
+        __m128 water = _mm_set_ps(params.zoneWater[zone[3]], params.zoneWater[zone[2]],
+            params.zoneWater[zone[1]], params.zoneWater[zone[0]]);
+        __m128 fertigation = _mm_set_ps(params.zoneNitrogen[zone[3]], params.zoneNitrogen[zone[2]],
+            params.zoneNitrogen[zone[1]], params.zoneNitrogen[zone[0]]);
+
+        __m128 m = _mm_loadu_ps(row.moisture + x);
+        __m128 lap = _mm_sub_ps(_mm_add_ps(
+            _mm_add_ps(_mm_loadu_ps(row.moisture + x - 1), _mm_loadu_ps(row.moisture + x + 1)),
+            _mm_add_ps(_mm_loadu_ps(row.moistureUp + x), _mm_loadu_ps(row.moistureDown + x))),
+            _mm_mul_ps(m, four));
+        __m128 m1 = _mm_add_ps(m, _mm_mul_ps(diffusion, lap));
+        m1 = _mm_add_ps(_mm_add_ps(m1, _mm_mul_ps(coverage, water)), rainfall);
+        m1 = _mm_sub_ps(m1, _mm_mul_ps(m, evaporation));
+        __m128 drain = _mm_mul_ps(_mm_max_ps(_mm_sub_ps(m1, fieldCapacity), zero), drainFraction);
+        m1 = _mm_min_ps(_mm_max_ps(_mm_sub_ps(m1, drain), zero), hundred);
+
+        __m128 n = _mm_loadu_ps(row.nitrogen + x);
+        __m128 lapN = _mm_sub_ps(_mm_add_ps(
+            _mm_add_ps(_mm_loadu_ps(row.nitrogen + x - 1), _mm_loadu_ps(row.nitrogen + x + 1)),
+            _mm_add_ps(_mm_loadu_ps(row.nitrogenUp + x), _mm_loadu_ps(row.nitrogenDown + x))),
+            _mm_mul_ps(n, four));
+        __m128 n1 = _mm_add_ps(n, _mm_mul_ps(nutrientDiffusion, lapN));
+        n1 = _mm_add_ps(n1, _mm_mul_ps(coverage, fertigation));
+        n1 = _mm_sub_ps(n1, _mm_mul_ps(n, _mm_mul_ps(drain, leachRate)));
+        n1 = _mm_min_ps(_mm_max_ps(n1, zero), hundred);
+
+        _mm_storeu_ps(row.moistureOut + x, m1);
+        _mm_storeu_ps(row.nitrogenOut + x, n1);
+    }
+    for (; x < width; x++) {
+        stepSoilCell(row, x, x - 1, std::min(x + 1, width - 1), params);
+    }
+}
+
+// 土壤行内核 - AVX2版本，内部列每条指令处理8个单元格，控制区阀门表用收集指令读取
+FARM_TARGET_AVX2
+void stepSoilRowAVX2(SoilGrid& grid, int z, const SoilStepParams& params) {
+    SoilRowView row(grid, z, params.dt);
+    int width = row.width;
+    if (width < 3) {
+        stepSoilRowScalar(grid, z, params);
+        return;
+    }
+
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 four = _mm256_set1_ps(4.0f);
+    const __m256 hundred = _mm256_set1_ps(100.0f);
+    const __m256 diffusion = _mm256_set1_ps(params.diffusion);
+    const __m256 nutrientDiffusion = _mm256_set1_ps(params.nutrientDiffusion);
+    const __m256 rainfall = _mm256_set1_ps(params.rainfall);
+    const __m256 evaporation = _mm256_set1_ps(params.evaporation);
+    const __m256 fieldCapacity = _mm256_set1_ps(params.fieldCapacity);
+    const __m256 drainFraction = _mm256_set1_ps(params.drainFraction);
+    const __m256 leachRate = _mm256_set1_ps(params.leachRate);
+    const __m256 coverageZ = _mm256_set1_ps(row.coverageZ);
+
+    stepSoilCell(row, 0, 0, 1, params);
+    int x = 1;
+    for (; x + 8 <= width - 1; x += 8) {
+        __m256 coverage = _mm256_mul_ps(_mm256_loadu_ps(row.coverageX + x), coverageZ);
+        __m256i zone = _mm256_loadu_si256((const __m256i*)(row.zone + x));
+        __m256 water = _mm256_i32gather_ps(params.zoneWater, zone, 4);
+        __m256 fertigation = _mm256_i32gather_ps(params.zoneNitrogen, zone, 4);
+
+        __m256 m = _mm256_loadu_ps(row.moisture + x);
+        __m256 lap = _mm256_sub_ps(_mm256_add_ps(
+            _mm256_add_ps(_mm256_loadu_ps(row.moisture + x - 1), _mm256_loadu_ps(row.moisture + x + 1)),
+            _mm256_add_ps(_mm256_loadu_ps(row.moistureUp + x), _mm256_loadu_ps(row.moistureDown + x))),
+            _mm256_mul_ps(m, four));
+        __m256 m1 = _mm256_add_ps(m, _mm256_mul_ps(diffusion, lap));
+        m1 = _mm256_add_ps(_mm256_add_ps(m1, _mm256_mul_ps(coverage, water)), rainfall);
+        m1 = _mm256_sub_ps(m1, _mm256_mul_ps(m, evaporation));
+        __m256 drain = _mm256_mul_ps(_mm256_max_ps(_mm256_sub_ps(m1, fieldCapacity), zero), drainFraction);
+        m1 = _mm256_min_ps(_mm256_max_ps(_mm256_sub_ps(m1, drain), zero), hundred);
+
+        __m256 n = _mm256_loadu_ps(row.nitrogen + x);
+        __m256 lapN = _mm256_sub_ps(_mm256_add_ps(
+            _mm256_add_ps(_mm256_loadu_ps(row.nitrogen + x - 1), _mm256_loadu_ps(row.nitrogen + x + 1)),
+            _mm256_add_ps(_mm256_loadu_ps(row.nitrogenUp + x), _mm256_loadu_ps(row.nitrogenDown + x))),
+            _mm256_mul_ps(n, four));
+        __m256 n1 = _mm256_add_ps(n, _mm256_mul_ps(nutrientDiffusion, lapN));
+        n1 = _mm256_add_ps(n1, _mm256_mul_ps(coverage, fertigation));
+        n1 = _mm256_sub_ps(n1, _mm256_mul_ps(n, _mm256_mul_ps(drain, leachRate)));
+        n1 = _mm256_min_ps(_mm256_max_ps(n1, zero), hundred);
+
+        _mm256_storeu_ps(row.moistureOut + x, m1);
+        _mm256_storeu_ps(row.nitrogenOut + x, n1);
+    }
+    for (; x < width; x++) {
+        stepSoilCell(row, x, x - 1, std::min(x + 1, width - 1), params);
+    }
+}
+#else
+// 非x86平台只有标量内核
+void stepSoilRowSSE2(SoilGrid& grid, int z, const SoilStepParams& params) {
+    stepSoilRowScalar(grid, z, params);
+}
+
+void stepSoilRowAVX2(SoilGrid& grid, int z, const SoilStepParams& params) {
+    stepSoilRowScalar(grid, z, params);
+}
+#endif
+
+// 土壤内核与植物内核使用同一指令集级别
+void selectSoilKernel(PlantKernelLevel level) {
+    const char* names[] = { "Scalar", "SSE2 (4 cells/op)", "AVX2 (8 cells/op)" };
+    switch (level) {
+    case PLANT_KERNEL_AVX2: soilRowKernel = stepSoilRowAVX2; break;
+    case PLANT_KERNEL_SSE2: soilRowKernel = stepSoilRowSSE2; break;
+    default: soilRowKernel = stepSoilRowScalar; break;
+    }
+    std::cout << "Soil stencil kernel: " << names[level] << std::endl;
+}
+
+// 创建贝塞尔曲线路径
+void createBezierPaths() {
+    paths.clear();
+
+    // 主要道路系统 - 连接各建筑的曲线道路
+    BezierPath mainRoad;
+    mainRoad.controlPoints = {
+        glm::vec3(-20.0f, 0.1f, -20.0f),  // 起点
+        glm::vec3(-5.0f, 0.1f, -25.0f),   // 控制点1
+        glm::vec3(5.0f, 0.1f, -25.0f),    // 控制点2
+        glm::vec3(20.0f, 0.1f, -20.0f)    // 终点
+    };
+    mainRoad.pathColor = glm::vec3(0.4f, 0.4f, 0.4f); // 灰色道路
+    mainRoad.pathWidth = 0.8f;
+    mainRoad.segments = 30;
+    paths.push_back(mainRoad);
+
+    // 灌溉主管道 - 弯曲的水管系统
+    BezierPath irrigation;
+    irrigation.controlPoints = {
+        glm::vec3(-15.0f, 0.05f, 8.0f),   // 从水处理站开始
+        glm::vec3(-5.0f, 0.05f, 12.0f),   // 控制点1
+        glm::vec3(5.0f, 0.05f, 12.0f),    // 控制点2
+        glm::vec3(15.0f, 0.05f, 8.0f)     // 到工具房
+    };
+    irrigation.pathColor = glm::vec3(0.2f, 0.6f, 0.8f); // 蓝色管道
+    irrigation.pathWidth = 0.3f;
+    irrigation.segments = 25;
+    paths.push_back(irrigation);
 
     // 温室连接路径
     BezierPath greenhouseConnection;
@@ -1352,381 +4455,3674 @@ void createBezierPaths() {
     std::cout << "Bezier curve path system created - " << paths.size() << " intelligent routes" << std::endl;
 }
 
-// 更新农场模拟 - 优化
-void updateFarmSimulation(float deltaTime) {
-    // 动态天气系统更新 - 修复
-    static float weatherTimer = 0.0f;
-    weatherTimer += deltaTime;
+// 启动线程池（threadCount为0时使用全部CPU核心）
+void FarmThreadPool::start(int threadCount) {
+    stop();
+    if (threadCount <= 0) {
+        threadCount = (int)std::thread::hardware_concurrency();
+    }
+    threadCount = std::max(1, threadCount);
+
+    queues.clear();
+    for (int i = 0; i < threadCount; i++) {
+        queues.emplace_back(new WorkQueue());
+    }
+
+    running = true;
+    jobGeneration = 0;
+    for (int i = 1; i < threadCount; i++) {
+        threads.emplace_back(&FarmThreadPool::workerLoop, this, i);
+    }
+}
+
+// 停止并回收所有工作线程
+void FarmThreadPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        running = false;
+    }
+    jobReady.notify_all();
+    for (auto& thread : threads) {
+        if (thread.joinable()) thread.join();
+    }
+    threads.clear();
+}
+
+// 将 [0, count) 按 chunkSize 拆块并行执行，返回时所有块都已完成
+void FarmThreadPool::parallelFor(size_t count, size_t chunkSize, const RangeFn& fn) {
+    if (count == 0) return;
+    chunkSize = std::max<size_t>(1, chunkSize);
+
+    // 没有工作线程时在调用线程按顺序执行各块（块划分保持一致，归约结果不随线程数变化）
+    if (threads.empty() || count <= chunkSize) {
+        for (size_t begin = 0; begin < count; begin += chunkSize) {
+            fn(begin, std::min(count, begin + chunkSize), 0);
+        }
+        return;
+    }
+
+    // 先发布任务再投放块：工作线程取到块之后一定能看到当前任务
+    currentJob = &fn;
+    size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+    pendingChunks = chunkCount;
+    int workers = workerCount();
+    for (size_t c = 0; c < chunkCount; c++) {
+        Chunk chunk;
+        chunk.begin = c * chunkSize;
+        chunk.end = std::min(count, chunk.begin + chunkSize);
+        WorkQueue& queue = *queues[c % workers];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.chunks.push_back(chunk);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        jobGeneration++;
+    }
+    jobReady.notify_all();
+
+    runChunks(0);
+
+    std::unique_lock<std::mutex> lock(jobMutex);
+    jobDone.wait(lock, [this] { return pendingChunks.load() == 0 && busyWorkers == 0; });
+    currentJob = nullptr;
+}
+
+// 从自己的队列尾部取块
+bool FarmThreadPool::popLocal(int worker, Chunk& chunk) {
+    WorkQueue& queue = *queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.chunks.empty()) return false;
+    chunk = queue.chunks.back();
+    queue.chunks.pop_back();
+    return true;
+}
+
+// 从其它线程队列头部窃取块
+bool FarmThreadPool::steal(int worker, Chunk& chunk) {
+    int workers = workerCount();
+    for (int offset = 1; offset < workers; offset++) {
+        WorkQueue& queue = *queues[(worker + offset) % workers];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.chunks.empty()) {
+            chunk = queue.chunks.front();
+            queue.chunks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+// 持续处理块直到所有队列为空
+void FarmThreadPool::runChunks(int worker) {
+    Chunk chunk;
+    while (popLocal(worker, chunk) || steal(worker, chunk)) {
+        (*currentJob)(chunk.begin, chunk.end, worker);
+        if (pendingChunks.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            jobDone.notify_all();
+        }
+    }
+}
+
+// 工作线程主循环：等待新任务，参与执行，然后继续休眠
+void FarmThreadPool::workerLoop(int worker) {
+    unsigned long long seenGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            jobReady.wait(lock, [&] { return !running || jobGeneration != seenGeneration; });
+            if (!running) return;
+            seenGeneration = jobGeneration;
+            busyWorkers++;
+        }
+
+        runChunks(worker);
+
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            busyWorkers--;
+        }
+        jobDone.notify_all();
+    }
+}
+
+// 启动模拟线程池
+void startSimulationThreads(int threadCount) {
+    threadPool.start(threadCount);
+    std::cout << "Simulation thread pool: " << threadPool.workerCount() << " worker(s)" << std::endl;
+}
+
+// 为一次并行循环准备按块划分的累加器
+void prepareChunkAccumulators(size_t count, size_t chunkSize) {
+    size_t chunks = (count + chunkSize - 1) / chunkSize;
+    if (chunkAccumulators.size() < chunks) {
+        chunkAccumulators.resize(chunks);
+    }
+    for (auto& acc : chunkAccumulators) {
+        acc.reset();
+    }
+}
+
+// 按块顺序归约累加器（与线程数和调度顺序无关）。结果写入常驻的 chunkTotal，
+// 下一次归约前有效
+const TickAccumulator& reduceChunkAccumulators() {
+    chunkTotal.reset();
+    for (const auto& acc : chunkAccumulators) {
+        chunkTotal.add(acc);
+    }
+    return chunkTotal;
+}
+
+// FNV-1a 64位哈希
+inline void hashBytes(uint64_t& hash, const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+}
+
+template<typename T>
+inline void hashValue(uint64_t& hash, const T& value) {
+    hashBytes(hash, &value, sizeof(T));
+}
+
+template<typename T>
+inline void hashColumn(uint64_t& hash, const std::vector<T>& column) {
+    if (!column.empty()) hashBytes(hash, column.data(), column.size() * sizeof(T));
+}
+
+// 模拟状态哈希 - 相同种子、相同步数下应完全一致，用于回归检查
+uint64_t hashSimulationState() {
+    uint64_t hash = 14695981039346656037ull;
+    hashValue(hash, simClock.totalSteps);
+    hashValue(hash, simClock.simTime);
+
+    hashColumn(hash, plantStore.sim.healthFactor);
+    hashColumn(hash, plantStore.sim.growthStage);
+    hashColumn(hash, plantStore.sim.leafColorR);
+    hashColumn(hash, plantStore.sim.leafColorG);
+    hashColumn(hash, plantStore.sim.pestInfected);
+    hashColumn(hash, plantStore.sim.hasFlowers);
+    hashColumn(hash, plantStore.sim.hasFruits);
+    hashColumn(hash, soilGrid.moisture);
+    hashColumn(hash, soilGrid.nitrogen);
+    hashColumn(hash, etForecast.demand72);
+    hashColumn(hash, greenhouseZones.airTemperature);
+    hashColumn(hash, greenhouseZones.vapourDensity);
+    hashColumn(hash, greenhouseZones.loops.integral);
+
+    for (const auto& sensor : sensorStore.measured) {
+        hashValue(hash, sensor.temperature);
+        hashValue(hash, sensor.humidity);
+        hashValue(hash, sensor.soilMoisture);
+        hashValue(hash, sensor.lightLevel);
+        hashValue(hash, sensor.pH);
+        hashValue(hash, sensor.nitrogenLevel);
+        hashValue(hash, sensor.phosphorusLevel);
+        hashValue(hash, sensor.potassiumLevel);
+    }
+    for (const auto& sensor : sensorStore.readings) {
+        hashValue(hash, sensor.temperature);
+        hashValue(hash, sensor.humidity);
+        hashValue(hash, sensor.soilMoisture);
+        hashValue(hash, sensor.lightLevel);
+        hashValue(hash, sensor.pH);
+        hashValue(hash, sensor.nitrogenLevel);
+        hashValue(hash, sensor.phosphorusLevel);
+        hashValue(hash, sensor.potassiumLevel);
+    }
+
+    hashValue(hash, weather.temperature);
+    hashValue(hash, weather.humidity);
+    hashValue(hash, weather.windSpeed);
+    hashValue(hash, weather.weatherType);
+
+    hashValue(hash, farmStatus.healthyPlants);
+    hashValue(hash, farmStatus.sickPlants);
+    hashValue(hash, farmStatus.alertSensors);
+    hashValue(hash, farmStatus.waterUsage);
+    hashValue(hash, farmStatus.powerConsumption);
+    hashValue(hash, farmStatus.fertilizerLevel);
+    hashValue(hash, farmStatus.harvestYield);
+    hashValue(hash, farmStatus.waterTankLevel);
+    hashValue(hash, farmStatus.activeNozzles);
+    return hash;
+}
+
+// 打印状态哈希
+void printStateHash() {
+    std::cout << "State hash @ step " << simClock.totalSteps << ": 0x"
+        << std::hex << std::setw(16) << std::setfill('0') << hashSimulationState()
+        << std::dec << std::setfill(' ') << std::endl;
+}
+
+// 推进一个固定模拟步：农场模拟 + 定期状态统计（窗口与无窗口模式共用）
+void stepFarmSimulation(float step) {
+    simClock.simTime += step;
+    simClock.totalSteps++;
+
+    updateFarmSimulation(step);
+
+    // 每6秒模拟时间统计一次农场状态
+    if (simClock.simTime - simClock.lastStatusUpdate > 6.0) {
+        simClock.lastStatusUpdate = simClock.simTime;
+        updateFarmStatus();
+    }
+
+    if (simClock.totalSteps == runOptions.hashAtStep) {
+        printStateHash();
+    }
+}
+
+// 按帧时间累积并以固定步长追赶模拟，返回本帧执行的步数
+int advanceSimulationClock(float frameDelta) {
+    // 卡顿时只计入有限的时间，积压分多帧追赶而不是一次大步长
+    frameDelta = clamp(frameDelta, 0.0f, simClock.maxFrameDelta);
+    simClock.accumulator += (double)frameDelta * simClock.timeWarp;
+
+    int steps = 0;
+    while (simClock.accumulator >= simClock.fixedStep && steps < simClock.maxStepsPerFrame) {
+        previousSnapshot = currentSnapshot;
+        stepFarmSimulation(simClock.fixedStep);
+        currentSnapshot = captureRenderSnapshot();
+        simClock.accumulator -= simClock.fixedStep;
+        steps++;
+    }
+
+    // 积压超过连续跳帧能追回的上限时丢弃多余时间（相当于降低实际加速倍数）
+    double maxBacklog = (double)simClock.fixedStep * simClock.maxStepsPerFrame * (simClock.maxSkippedFrames + 1);
+    if (simClock.accumulator > maxBacklog) {
+        simClock.accumulator = maxBacklog;
+    }
+
+    simClock.alpha = clamp((float)(simClock.accumulator / simClock.fixedStep), 0.0f, 1.0f);
+    return steps;
+}
+
+// 记录当前模拟状态中渲染需要的部分
+RenderSnapshot captureRenderSnapshot() {
+    RenderSnapshot snapshot;
+    snapshot.lightPos = lightPos;
+    snapshot.lightColor = lightColor;
+    snapshot.windDirection = windDirection;
+    snapshot.windStrength = windStrength;
+    snapshot.cloudCoverage = weather.cloudCoverage;
+    snapshot.precipitation = weather.precipitation;
+    snapshot.fogDensity = weather.fogDensity;
+    snapshot.fogColor = weather.fogColor;
+    return snapshot;
+}
+
+// 在两个模拟步之间插值，使渲染平滑
+RenderSnapshot interpolateRenderSnapshot(const RenderSnapshot& a, const RenderSnapshot& b, float t) {
+    RenderSnapshot result;
+    result.lightPos = glm::mix(a.lightPos, b.lightPos, t);
+    result.lightColor = glm::mix(a.lightColor, b.lightColor, t);
+    result.windDirection = glm::mix(a.windDirection, b.windDirection, t);
+    if (glm::length(result.windDirection) > 0.001f) {
+        result.windDirection = glm::normalize(result.windDirection);
+    }
+    result.windStrength = a.windStrength + (b.windStrength - a.windStrength) * t;
+    result.cloudCoverage = a.cloudCoverage + (b.cloudCoverage - a.cloudCoverage) * t;
+    result.precipitation = a.precipitation + (b.precipitation - a.precipitation) * t;
+    result.fogDensity = a.fogDensity + (b.fogDensity - a.fogDensity) * t;
+    result.fogColor = glm::mix(a.fogColor, b.fogColor, t);
+    return result;
+}
+
+// 刷新单个传感器本步到期的通道（可在任意工作线程执行，只写本传感器和本块的累加器）：
+// 先更新探头测量值，再经死区过滤发布为上报值
+void updateSensorReading(size_t row, unsigned int due, const SensorTickParams& params,
+    TickAccumulator& acc, unsigned char& events) {
+    SensorReadings& sensor = sensorStore.measured[row];
+    const float* drift = sensorSchedule.drift;
+    const float* relax = sensorSchedule.relax;
+
+    // 每个传感器每一步一条独立随机流
+    PhiloxStream rng(simulationSeed, RNG_SENSOR_TICK, (uint32_t)row, (uint64_t)simClock.totalSteps);
+    float dayFactor = params.dayFactor;
+
+    // 近期收到实测值的通道保留实测值，不再由模拟生成
+    unsigned int live = 0;
+    if (!sensorIngest.liveChannels.empty() && simClock.simTime - sensorIngest.liveTime[row] < liveSensorTimeout) {
+        live = sensorIngest.liveChannels[row];
+    }
+    unsigned int simulate = due & ~live;
+    bool simulateTemperature = (simulate & (1u << SENSOR_CHANNEL_TEMPERATURE)) != 0;
+    bool simulateHumidity = (simulate & (1u << SENSOR_CHANNEL_HUMIDITY)) != 0;
+
+    int32_t house = greenhouseZones.sensorZone[row];
+    if (house >= 0) {
+        // 温室内传感器读取所在温室区的空气状态（含测量噪声）
+        if (simulateTemperature) {
+            sensor.temperature = greenhouseZones.airTemperature[house] + rng.uniform(-1.0f, 1.0f) * 0.3f;
+        }
+        if (simulateHumidity) {
+            sensor.humidity = clamp(greenhouseZones.humidity[house] + rng.uniform(-1.0f, 1.0f) * 1.0f, 0.0f, 100.0f);
+        }
+    }
+    else {
+        // 露天传感器向天气基准值（已含昼夜和降雨影响）回归，叠加局地波动
+        if (simulateTemperature) {
+            sensor.temperature += relax[SENSOR_CHANNEL_TEMPERATURE] * (params.outdoorTemperature - sensor.temperature) +
+                rng.uniform(-1.0f, 1.0f) * 0.8f * drift[SENSOR_CHANNEL_TEMPERATURE];
+            sensor.temperature = clamp(sensor.temperature, 12.0f, 40.0f);
+        }
+        if (simulateHumidity) {
+            sensor.humidity += relax[SENSOR_CHANNEL_HUMIDITY] * (params.outdoorHumidity - sensor.humidity) +
+                rng.uniform(-1.0f, 1.0f) * 2.0f * drift[SENSOR_CHANNEL_HUMIDITY];
+            sensor.humidity = clamp(sensor.humidity, 25.0f, 95.0f);
+        }
+    }
+
+    // 土壤湿度和氮素读取所在单元格的土壤网格值（含测量噪声）
+    size_t soilCell = soilGrid.cellAt(sensorStore.position[row].x, sensorStore.position[row].z);
+    if (simulate & (1u << SENSOR_CHANNEL_SOIL_MOISTURE)) {
+        sensor.soilMoisture = clamp(soilGrid.moisture[soilCell] + rng.uniform(-1.0f, 1.0f) * 0.5f, 0.0f, 100.0f);
+    }
+    if (simulate & (1u << SENSOR_CHANNEL_NITROGEN)) {
+        sensor.nitrogenLevel = clamp(soilGrid.nitrogen[soilCell] + rng.uniform(-1.0f, 1.0f) * 1.0f, 0.0f, 100.0f);
+    }
+
+    // 施肥系统：氮随灌溉水施入土壤网格，磷钾直接补充（随土壤湿度采样检查）
+    if (due & (1u << SENSOR_CHANNEL_SOIL_MOISTURE)) {
+        float fertigationRate = 0.0f;
+        if (params.applyFertilizer) {
+            bool needsFertilizer = sensor.nitrogenLevel < 60.0f ||
+                sensor.phosphorusLevel < 60.0f ||
+                sensor.potassiumLevel < 60.0f;
+            if (needsFertilizer) {
+                fertigationRate = 4.0f;
+                sensor.phosphorusLevel += 6.0f;
+                sensor.potassiumLevel += 7.0f;
+                acc.fertilizerUsed += 0.5f;
+                events |= SENSOR_EVENT_FERTILIZED;
+            }
+        }
+        soilGrid.zoneNitrogen[row] = fertigationRate;
+    }
+
+    // pH值缓慢变化
+    if (simulate & (1u << SENSOR_CHANNEL_PH)) {
+        sensor.pH += rng.uniform(-1.0f, 1.0f) * 0.1f * drift[SENSOR_CHANNEL_PH];
+        sensor.pH = clamp(sensor.pH, 5.0f, 8.5f);
+    }
+
+    // 营养元素变化（氮由土壤网格计算）
+    if (simulate & (1u << SENSOR_CHANNEL_PHOSPHORUS)) {
+        sensor.phosphorusLevel += rng.uniform(-1.0f, 1.0f) * 1.5f * drift[SENSOR_CHANNEL_PHOSPHORUS];
+        sensor.phosphorusLevel = clamp(sensor.phosphorusLevel, 10.0f, 90.0f);
+    }
+    if (simulate & (1u << SENSOR_CHANNEL_POTASSIUM)) {
+        sensor.potassiumLevel += rng.uniform(-1.0f, 1.0f) * 2.0f * drift[SENSOR_CHANNEL_POTASSIUM];
+        sensor.potassiumLevel = clamp(sensor.potassiumLevel, 10.0f, 90.0f);
+    }
+
+    // 光照强度
+    if (simulate & (1u << SENSOR_CHANNEL_LIGHT)) {
+        sensor.lightLevel = 200.0f + dayFactor * 1000.0f + rng.uniform(-1.0f, 1.0f) * 100.0f;
+        sensor.lightLevel = clamp(sensor.lightLevel, 100.0f, 1400.0f);
+    }
+
+    // 没有通道超出死区的传感器保持干净，跳过数据柱和状态灯重算
+    unsigned int changed = reportSensorChannels(row, due);
+    acc.channelSamples += countChannels(due);
+    acc.channelReports += countChannels(changed);
+    acc.reportedChannels |= changed;
+    if (sensorStore.report[row].dirty == 0) {
+        acc.cleanSensors++;
+        return;
+    }
+    refreshSensorDisplay(row);
+}
+
+// 按死区和回差把测量值发布为上报值，返回上报值变化的通道（影响显示的记入脏标记）。
+// 与上次上报同方向的变化超过死区即上报，反向变化还需再超过回差，噪声在上报值附近抖动时不反复上报
+unsigned int reportSensorChannels(size_t row, unsigned int channels) {
+    const SensorReadings& measured = sensorStore.measured[row];
+    SensorReadings& reported = sensorStore.readings[row];
+    SensorReportState& state = sensorStore.report[row];
+    unsigned int changed = 0;
+    for (int c = 0; c < SENSOR_CHANNELS; c++) {
+        if (!(channels >> c & 1)) continue;
+        float delta = measured.*sensorChannelField[c] - reported.*sensorChannelField[c];
+        if (delta == 0.0f) continue;
+        signed char direction = delta > 0.0f ? 1 : -1;
+        float threshold = runOptions.deadband[c];
+        if (state.trend[c] != 0 && state.trend[c] != direction) threshold += runOptions.hysteresis[c];
+        if (std::fabs(delta) <= threshold) continue;
+        reported.*sensorChannelField[c] = measured.*sensorChannelField[c];
+        state.trend[c] = direction;
+        changed |= 1u << c;
+    }
+    state.dirty |= (unsigned char)(changed & sensorDisplayChannels);
+    return changed;
+}
+
+// 按上报值重算数据柱和状态灯，清除脏标记
+void refreshSensorDisplay(size_t row) {
+    const SensorReadings& sensor = sensorStore.readings[row];
+    SensorDisplay& display = sensorStore.display[row];
+    sensorStore.report[row].dirty = 0;
+
+    // 更新7个可视化数据柱
+    display.dataHeight[0] = (sensor.temperature - 10.0f) / 35.0f * 2.5f;
+    display.dataHeight[1] = sensor.humidity / 100.0f * 2.5f;
+    display.dataHeight[2] = sensor.soilMoisture / 100.0f * 2.5f;
+    display.dataHeight[3] = (sensor.pH - 4.5f) / 4.5f * 2.5f;
+    display.dataHeight[4] = sensor.nitrogenLevel / 100.0f * 2.5f;
+    display.dataHeight[5] = sensor.phosphorusLevel / 100.0f * 2.5f;
+    display.dataHeight[6] = sensor.potassiumLevel / 100.0f * 2.5f;
+
+    // 状态指示灯逻辑
+    bool tempAlert = (sensor.temperature > 35.0f || sensor.temperature < 15.0f);
+    bool humidAlert = (sensor.humidity < 30.0f);
+    bool soilAlert = (sensor.soilMoisture < 25.0f);
+    bool pHAlert = (sensor.pH < 5.8f || sensor.pH > 7.8f);
+    bool nutrientAlert = (sensor.nitrogenLevel < 30.0f || sensor.phosphorusLevel < 20.0f);
+
+    if (tempAlert || humidAlert || soilAlert || pHAlert || nutrientAlert) {
+        display.statusColor = glm::vec3(1.0f, 0.2f, 0.2f); // 红色警告
+    }
+    else if (sensor.temperature > 32.0f || sensor.humidity < 40.0f || sensor.soilMoisture < 35.0f) {
+        display.statusColor = glm::vec3(1.0f, 0.8f, 0.0f); // 黄色注意
+    }
+    else {
+        display.statusColor = glm::vec3(0.2f, 1.0f, 0.3f); // 绿色正常
+    }
+}
+
+// 生成整个季节的天气时间线（种子决定，与线程数无关）
+void initializeWeatherTimeline() {
+    size_t hours = (size_t)weatherSeasonDays * 24;
+    WeatherTimeline& w = weatherTimeline;
+    w.type.resize(hours);
+    w.temperature.resize(hours);
+    w.humidity.resize(hours);
+    w.cloudCoverage.resize(hours);
+    w.precipitation.resize(hours);
+    w.windStrength.resize(hours);
+    w.fogDensity.resize(hours);
+    generateWeatherTimeline(0, weather.weatherType);
+    applyWeatherTimeline(simClock.simTime);
+
+    int typeHours[4] = { 0, 0, 0, 0 };
+    for (size_t h = 0; h < hours; h++) typeHours[w.type[h]]++;
+    std::cout << "Weather timeline: " << weatherSeasonDays << " days x 24 h | sunny " << typeHours[0]
+        << " h, cloudy " << typeHours[1] << " h, rainy " << typeHours[2] << " h, stormy " << typeHours[3] << " h" << std::endl;
+}
+
+// 从 firstHour 起（该小时天气类型为 firstType）重新生成到季节末。每小时一条独立随机流，
+// 改写某一小时之后的天气不影响之前已生成的部分
+void generateWeatherTimeline(size_t firstHour, int firstType) {
+    // 每小时转移概率（行：当前天气，列：下一小时天气）
+    static const float transition[4][4] = {
+        { 0.920f, 0.070f, 0.008f, 0.002f },
+        { 0.100f, 0.800f, 0.080f, 0.020f },
+        { 0.020f, 0.150f, 0.780f, 0.050f },
+        { 0.000f, 0.100f, 0.350f, 0.550f }
+    };
+    // 各天气类型：气温偏移、气温日较差的一半、基准湿度、云量、降水、风力
+    static const float temperatureOffset[4] = { 0.0f, -1.0f, -2.5f, -4.0f };
+    static const float temperatureSwing[4] = { 7.0f, 4.0f, 2.0f, 2.0f };
+    static const float humidityBase[4] = { 58.0f, 70.0f, 88.0f, 93.0f };
+    static const float cloudBase[4] = { 0.1f, 0.5f, 0.8f, 0.95f };
+    static const float precipitationBase[4] = { 0.0f, 0.0f, 0.6f, 0.85f };
+    static const float windBase[4] = { 0.3f, 0.5f, 0.7f, 1.5f };
+
+    WeatherTimeline& w = weatherTimeline;
+    const size_t hours = w.hours();
+    for (size_t h = firstHour; h < hours; h++) {
+        PhiloxStream rng(simulationSeed, RNG_WEATHER, 0, (uint64_t)h);
+        int type = firstType;
+        float draw = rng.uniform(0.0f, 1.0f);
+        if (h > firstHour) {
+            const float* row = transition[w.type[h - 1]];
+            float cumulative = 0.0f;
+            type = 3;
+            for (int k = 0; k < 4; k++) {
+                cumulative += row[k];
+                if (draw < cumulative) {
+                    type = k;
+                    break;
+                }
+            }
+        }
+
+        // 季节均值：生长季首尾 14°C，中期 26°C；日变化最高气温滞后正午2小时
+        float season = (float)h / hours;
+        float seasonal = std::cos(season * 2.0f * 3.14159f);
+        float diurnal = std::sin(((float)(h % 24) - 2.0f) / 24.0f * 2.0f * 3.14159f);
+        w.type[h] = (unsigned char)type;
+        w.temperature[h] = 20.0f - 6.0f * seasonal + temperatureOffset[type] + temperatureSwing[type] * diurnal +
+            rng.uniform(-0.5f, 0.5f);
+        w.humidity[h] = clamp(humidityBase[type] + 4.0f * seasonal - 2.0f * temperatureSwing[type] * diurnal +
+            rng.uniform(-2.0f, 2.0f), 20.0f, 100.0f);
+        w.cloudCoverage[h] = clamp(cloudBase[type] + rng.uniform(-0.08f, 0.08f), 0.0f, 1.0f);
+        w.precipitation[h] = type >= 2 ? clamp(precipitationBase[type] + rng.uniform(-0.15f, 0.15f), 0.0f, 1.0f) : 0.0f;
+        w.windStrength[h] = clamp(windBase[type] * (1.0f + rng.uniform(-0.3f, 0.3f)), 0.1f, 2.5f);
+        w.fogDensity[h] = weatherFogDensity[type] * (1.0f + 0.5f * std::max(-diurnal, 0.0f));   // 夜间和清晨雾更浓
+    }
+}
+
+// 模拟时间所在的时间线小时（已按季节长度取模）
+size_t weatherTimelineHour(double simTime) {
+    return (size_t)(simTime / (dayLengthSeconds / 24.0)) % weatherTimeline.hours();
+}
+
+// 在相邻两个整点之间插值出当前天气
+void applyWeatherTimeline(double simTime) {
+    const WeatherTimeline& w = weatherTimeline;
+    double position = simTime / (dayLengthSeconds / 24.0);
+    double whole = std::floor(position);
+    float t = (float)(position - whole);
+    size_t a = (size_t)whole % w.hours();
+    size_t b = (a + 1) % w.hours();
+    auto lerp = [t](float from, float to) { return from + (to - from) * t; };
+
+    weather.weatherType = w.type[a];
+    weather.temperature = lerp(w.temperature[a], w.temperature[b]);
+    weather.humidity = lerp(w.humidity[a], w.humidity[b]);
+    weather.cloudCoverage = lerp(w.cloudCoverage[a], w.cloudCoverage[b]);
+    weather.precipitation = lerp(w.precipitation[a], w.precipitation[b]);
+    weather.fogDensity = lerp(w.fogDensity[a], w.fogDensity[b]);
+    weather.fogColor = glm::mix(weatherFogColors[w.type[a]], weatherFogColors[w.type[b]], t);
+    windStrength = lerp(w.windStrength[a], w.windStrength[b]);
+    weather.windSpeed = 1.0f + 2.0f * windStrength;   // 2米高风速（m/s）
+}
+
+// 打开气象文件：EPW 跳过8行文件头、按固定列取字段；CSV 按表头列名识别字段（气温必需）。
+// 有小时列时跳到第一条 06:00 的记录，与模拟起点（昼夜系数上升过零）对齐
+bool openWeatherFile(const std::string& path) {
+    WeatherFileSource& src = weatherFile;
+    src = WeatherFileSource();
+    src.file.open(path, std::ios::binary);
+    if (!src.file) {
+        std::cout << "WARNING: cannot open weather file " << path << ", using generated weather" << std::endl;
+        src.file.close();
+        return false;
+    }
+    src.path = path;
+
+    std::string line;
+    std::getline(src.file, line);
+    src.epw = line.compare(0, 8, "LOCATION") == 0;
+    if (src.epw) {
+        for (int i = 1; i < 8; i++) std::getline(src.file, line);
+        src.column[WEATHER_FIELD_TEMPERATURE] = 6;
+        src.column[WEATHER_FIELD_HUMIDITY] = 8;
+        src.column[WEATHER_FIELD_CLOUD] = 22;
+        src.column[WEATHER_FIELD_PRECIPITATION] = 33;
+        src.column[WEATHER_FIELD_WIND] = 21;
+        src.column[WEATHER_FIELD_HOUR] = 3;
+    }
+    else {
+        std::stringstream header(line);
+        std::string name;
+        for (int col = 0; std::getline(header, name, ','); col++) {
+            std::transform(name.begin(), name.end(), name.begin(), [](char c) { return (char)std::tolower((unsigned char)c); });
+            int field = -1;
+            if (name.find("dew") != std::string::npos || name.find("dir") != std::string::npos) field = -1;
+            else if (name.find("temp") != std::string::npos) field = WEATHER_FIELD_TEMPERATURE;
+            else if (name.find("hum") != std::string::npos || name.find("rh") == 0) field = WEATHER_FIELD_HUMIDITY;
+            else if (name.find("cloud") != std::string::npos || name.find("sky") != std::string::npos) field = WEATHER_FIELD_CLOUD;
+            else if (name.find("precip") != std::string::npos || name.find("rain") != std::string::npos) field = WEATHER_FIELD_PRECIPITATION;
+            else if (name.find("wind") != std::string::npos) field = WEATHER_FIELD_WIND;
+            else if (name.find("hour") != std::string::npos) field = WEATHER_FIELD_HOUR;
+            if (field >= 0 && src.column[field] < 0) src.column[field] = col;
+        }
+        if (src.column[WEATHER_FIELD_TEMPERATURE] < 0) {
+            std::cout << "WARNING: weather file " << path << " has no temperature column, using generated weather" << std::endl;
+            src.file.close();
+            return false;
+        }
+    }
+
+    std::streampos start = src.file.tellg();
+    if (src.column[WEATHER_FIELD_HOUR] >= 0) {
+        WeatherRecord record;
+        int hour = -1;
+        for (int skipped = 0; skipped < 24; skipped++) {
+            std::streampos at = src.file.tellg();
+            if (!readWeatherRecord(src, record, hour)) break;
+            if (hour == 6) {
+                start = at;
+                break;
+            }
+        }
+    }
+    src.dataStart = start;
+    src.file.clear();
+    src.file.seekg(start);
+    src.last = WeatherRecord();
+    src.missingValues = 0;
+    refillWeatherFile();
+    if (src.buffer.size() < 2) {
+        std::cout << "WARNING: weather file " << path << " has no hourly records, using generated weather" << std::endl;
+        src.file.close();
+        return false;
+    }
+    applyWeatherFile(simClock.simTime);
+    std::cout << "Weather file: " << path << " (" << (src.epw ? "EPW" : "CSV") << "), read-ahead "
+        << weatherReadAhead << " h" << std::endl;
+    return true;
+}
+
+// 读取下一条数据记录（跳过空行）。按逗号逐列扫描，只转换需要的列；缺列、非数字和 EPW 缺测标记
+// （99.9 / 999 / 99）沿用上一条记录的值。文件结束返回 false
+bool readWeatherRecord(WeatherFileSource& src, WeatherRecord& record, int& hour) {
+    static const float missingAt[WEATHER_FIELDS] = { 99.9f, 999.0f, 99.0f, 999.0f, 999.0f, 1e9f };
+    std::string line;
+    while (std::getline(src.file, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+        float value[WEATHER_FIELDS];
+        bool present[WEATHER_FIELDS] = { false, false, false, false, false, false };
+        const char* cursor = line.c_str();
+        for (int col = 0; ; col++) {
+            for (int f = 0; f < WEATHER_FIELDS; f++) {
+                if (src.column[f] != col) continue;
+                char* end;
+                value[f] = strtof(cursor, &end);
+                present[f] = end != cursor && !(src.epw && value[f] >= missingAt[f]);
+            }
+            const char* comma = strchr(cursor, ',');
+            if (!comma) break;
+            cursor = comma + 1;
+        }
+
+        record = src.last;
+        for (int f = 0; f < WEATHER_FIELD_HOUR; f++) {
+            if (src.column[f] >= 0 && !present[f]) src.missingValues++;
+        }
+        if (present[WEATHER_FIELD_TEMPERATURE]) record.temperature = value[WEATHER_FIELD_TEMPERATURE];
+        if (present[WEATHER_FIELD_HUMIDITY]) record.humidity = clamp(value[WEATHER_FIELD_HUMIDITY], 0.0f, 100.0f);
+        if (present[WEATHER_FIELD_CLOUD]) {
+            // EPW 为十分制；CSV 大于1时按百分比
+            float cloud = value[WEATHER_FIELD_CLOUD];
+            cloud = src.epw ? cloud * 0.1f : (cloud > 1.0f ? cloud * 0.01f : cloud);
+            record.cloudCoverage = clamp(cloud, 0.0f, 1.0f);
+        }
+        if (present[WEATHER_FIELD_PRECIPITATION]) record.precipitation = std::max(value[WEATHER_FIELD_PRECIPITATION], 0.0f);
+        if (present[WEATHER_FIELD_WIND]) record.windSpeed = std::max(value[WEATHER_FIELD_WIND], 0.0f);
+        hour = present[WEATHER_FIELD_HOUR] ? (int)value[WEATHER_FIELD_HOUR] : -1;
+        src.last = record;
+        return true;
+    }
+    return false;
+}
+
+// 把预读缓冲补满；读到文件末尾时回到第一条数据记录
+void refillWeatherFile() {
+    WeatherFileSource& src = weatherFile;
+    WeatherRecord record;
+    int hour;
+    bool rewound = false;
+    while (src.buffer.size() < weatherReadAhead) {
+        if (readWeatherRecord(src, record, hour)) {
+            src.buffer.push_back(record);
+            src.recordsRead++;
+            rewound = false;
+            continue;
+        }
+        if (rewound) break;   // 回到开头后仍读不到记录
+        src.file.clear();
+        src.file.seekg(src.dataStart);
+        src.rewinds++;
+        rewound = true;
+    }
+}
+
+// 丢弃已过去的小时，在当前小时和下一小时的记录之间插值，写入与天气时间线相同的天气字段。
+// 天气类型由小时初的降水、云量和风速判定
+void applyWeatherFile(double simTime) {
+    WeatherFileSource& src = weatherFile;
+    double position = simTime / (dayLengthSeconds / 24.0);
+    double whole = std::floor(position);
+    size_t hour = (size_t)whole;
+    while (src.bufferHour < hour) {
+        if (src.buffer.size() <= weatherReadAhead / 2) refillWeatherFile();
+        src.buffer.pop_front();
+        src.bufferHour++;
+    }
+    if (src.buffer.size() <= weatherReadAhead / 2) refillWeatherFile();
+
+    float t = (float)(position - whole);
+    const WeatherRecord& a = src.buffer[0];
+    const WeatherRecord& b = src.buffer[1];
+    auto lerp = [t](float from, float to) { return from + (to - from) * t; };
+
+    int type = 0;
+    if (a.precipitation >= 4.0f || (a.precipitation >= 0.5f && a.windSpeed >= 10.0f)) type = 3;
+    else if (a.precipitation >= 0.2f) type = 2;
+    else if (a.cloudCoverage >= 0.6f) type = 1;
+
+    weather.weatherType = type;
+    weather.temperature = lerp(a.temperature, b.temperature);
+    weather.humidity = lerp(a.humidity, b.humidity);
+    weather.cloudCoverage = lerp(a.cloudCoverage, b.cloudCoverage);
+    weather.precipitation = clamp(lerp(a.precipitation, b.precipitation) * 0.25f, 0.0f, 1.0f);   // 4 mm/h 为最大强度
+    weather.windSpeed = lerp(a.windSpeed, b.windSpeed);
+    weather.fogDensity = weatherFogDensity[type] * (1.0f + std::max(weather.humidity - 90.0f, 0.0f) * 0.1f);
+    weather.fogColor = weatherFogColors[type];
+    windStrength = clamp((weather.windSpeed - 1.0f) * 0.5f, 0.1f, 2.5f);
+}
+
+// Windows 需要先初始化 Winsock
+bool initializeFarmSockets() {
+#ifdef _WIN32
+    static bool started = false;
+    if (!started) {
+        WSADATA data;
+        started = WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }
+    return started;
+#else
+    return true;
+#endif
+}
+
+// 打开接入端点："udp:端口"（监听所有地址）或 "unix:路径"（数据报套接字，Windows 不支持）
+FarmSocket openIngestSocket(const std::string& endpoint) {
+    if (endpoint.compare(0, 4, "udp:") == 0) {
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons((unsigned short)atoi(endpoint.c_str() + 4));
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        FarmSocket s = socket(AF_INET, SOCK_DGRAM, 0);
+        if (s == invalidFarmSocket) return s;
+        int bufferSize = 8 << 20;   // 接收缓冲吸收 I/O 线程被调度出去时的突发
+        setsockopt(s, SOL_SOCKET, SO_RCVBUF, (const char*)&bufferSize, sizeof(bufferSize));
+        if (bind(s, (const sockaddr*)&address, sizeof(address)) != 0) {
+            closeFarmSocket(s);
+            return invalidFarmSocket;
+        }
+        setFarmSocketNonBlocking(s);
+        return s;
+    }
+#ifndef _WIN32
+    if (endpoint.compare(0, 5, "unix:") == 0) {
+        std::string path = endpoint.substr(5);
+        sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        if (path.empty() || path.size() >= sizeof(address.sun_path)) return invalidFarmSocket;
+        address.sun_family = AF_UNIX;
+        memcpy(address.sun_path, path.c_str(), path.size());
+        FarmSocket s = socket(AF_UNIX, SOCK_DGRAM, 0);
+        if (s == invalidFarmSocket) return s;
+        unlink(path.c_str());
+        int bufferSize = 8 << 20;
+        setsockopt(s, SOL_SOCKET, SO_RCVBUF, (const char*)&bufferSize, sizeof(bufferSize));
+        if (bind(s, (const sockaddr*)&address, sizeof(address)) != 0) {
+            closeFarmSocket(s);
+            return invalidFarmSocket;
+        }
+        setFarmSocketNonBlocking(s);
+        sensorIngest.unixPaths.push_back(path);
+        return s;
+    }
+#endif
+    return invalidFarmSocket;
+}
+
+// 回放目标："udp:主机:端口" 或 "unix:路径"
+FarmSocket openReplaySocket(const std::string& target, sockaddr_storage& address, socklen_t& length) {
+    memset(&address, 0, sizeof(address));
+    if (target.compare(0, 4, "udp:") == 0) {
+        size_t colon = target.rfind(':');
+        std::string host = colon > 4 ? target.substr(4, colon - 4) : "127.0.0.1";
+        sockaddr_in* in = (sockaddr_in*)&address;
+        in->sin_family = AF_INET;
+        in->sin_port = htons((unsigned short)atoi(target.c_str() + colon + 1));
+        if (inet_pton(AF_INET, host.c_str(), &in->sin_addr) != 1) return invalidFarmSocket;
+        length = sizeof(sockaddr_in);
+        return socket(AF_INET, SOCK_DGRAM, 0);
+    }
+#ifndef _WIN32
+    if (target.compare(0, 5, "unix:") == 0) {
+        std::string path = target.substr(5);
+        sockaddr_un* un = (sockaddr_un*)&address;
+        if (path.empty() || path.size() >= sizeof(un->sun_path)) return invalidFarmSocket;
+        un->sun_family = AF_UNIX;
+        memcpy(un->sun_path, path.c_str(), path.size());
+        length = sizeof(sockaddr_un);
+        return socket(AF_UNIX, SOCK_DGRAM, 0);
+    }
+#endif
+    return invalidFarmSocket;
+}
+
+// 打开全部接入端点并启动 I/O 线程；一个端点都打不开时不启动
+bool startSensorIngest(const std::vector<std::string>& endpoints) {
+    SensorIngest& ingest = sensorIngest;
+    if (!initializeFarmSockets()) {
+        std::cout << "WARNING: socket library unavailable, sensor ingest disabled" << std::endl;
+        return false;
+    }
+    for (const std::string& endpoint : endpoints) {
+        FarmSocket s = openIngestSocket(endpoint);
+        if (s == invalidFarmSocket) {
+            std::cout << "WARNING: cannot listen on " << endpoint << std::endl;
+            continue;
+        }
+        ingest.sockets.push_back(s);
+        std::cout << "Sensor ingest listening on " << endpoint << std::endl;
+    }
+    if (ingest.sockets.empty()) return false;
+
+    ingest.ring.reset(sensorRingCapacity);
+    ingest.frameDecoders.assign(ingest.sockets.size(), SensorDeltaCodec());
+    for (SensorDeltaCodec& decoder : ingest.frameDecoders) {
+        decoder.idLimit = (uint32_t)sensorStore.index.rowOfId.size();
+    }
+    ingest.liveChannels.assign(sensorStore.size(), 0);
+    ingest.liveTime.assign(sensorStore.size(), -1e30);
+    ingest.running = true;
+    ingest.thread = std::thread(runSensorIngestThread);
+    return true;
+}
+
+void stopSensorIngest() {
+    SensorIngest& ingest = sensorIngest;
+    ingest.running = false;
+    if (ingest.thread.joinable()) ingest.thread.join();
+    for (FarmSocket s : ingest.sockets) closeFarmSocket(s);
+    ingest.sockets.clear();
+#ifndef _WIN32
+    for (const std::string& path : ingest.unixPaths) unlink(path.c_str());
+#endif
+    ingest.unixPaths.clear();
+}
+
+// I/O 线程：等待任一套接字可读，把每个套接字中已到达的数据报全部读出并解码
+void runSensorIngestThread() {
+    SensorIngest& ingest = sensorIngest;
+    std::vector<pollfd> fds(ingest.sockets.size());
+    for (size_t i = 0; i < fds.size(); i++) {
+        fds[i].fd = ingest.sockets[i];
+        fds[i].events = POLLIN;
+    }
+    std::vector<char> buffer(65536);
+    while (ingest.running.load(std::memory_order_relaxed)) {
+        if (pollFarmSockets(fds.data(), fds.size(), 50) <= 0) continue;
+        for (size_t i = 0; i < fds.size(); i++) {
+            if (!(fds[i].revents & POLLIN)) continue;
+            for (;;) {
+                int received = (int)recv(fds[i].fd, buffer.data(), (int)buffer.size(), 0);
+                if (received <= 0) break;
+                ingest.datagrams.fetch_add(1, std::memory_order_relaxed);
+                decodeSensorBatch(buffer.data(), (size_t)received, i);
+            }
+        }
+    }
+}
+
+// 解码一个数据报并逐条放入队列，返回读数条数（格式错误返回0）。按开头魔数区分批量帧和增量帧
+// （增量帧按来源套接字分别解码，一个数据报可含多帧），其余按行协议文本解析（数据报内只含完整的行）
+size_t decodeSensorBatch(const char* data, size_t size, size_t source) {
+    SensorIngest& ingest = sensorIngest;
+    uint32_t magic = 0;
+    uint16_t count;
+    if (size >= 4) memcpy(&magic, data, 4);
+    if ((magic & sensorFrameMagicMask) == (sensorFrameMagic & sensorFrameMagicMask)) {
+        SensorDeltaCodec& decoder = ingest.frameDecoders[source];
+        ingest.textSamples.clear();
+        for (size_t offset = 0; offset < size;) {
+            size_t used = decodeSensorFrame(decoder, (const unsigned char*)data + offset, size - offset, ingest.textSamples);
+            if (used == 0) {
+                ingest.malformed.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+            offset += used;
+        }
+        pushSensorSamples(ingest.textSamples.data(), ingest.textSamples.size());
+        return ingest.textSamples.size();
+    }
+    if (magic != sensorBatchMagic) {
+        LineParseStats stats;
+        ingest.textSamples.clear();
+        parseSensorLines(data, size, true, ingest.textSamples, stats);
+        if (stats.malformed > 0) ingest.malformed.fetch_add(stats.malformed, std::memory_order_relaxed);
+        pushSensorSamples(ingest.textSamples.data(), ingest.textSamples.size());
+        return ingest.textSamples.size();
+    }
+    if (size < sensorBatchHeaderSize) {
+        ingest.malformed.fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+    memcpy(&count, data + 4, 2);
+    if (size != sensorBatchHeaderSize + (size_t)count * sizeof(SensorSample)) {
+        ingest.malformed.fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+    // 记录按40字节紧密排列，可直接当作数组读取（memcpy 避免未对齐访问）
+    SensorSample samples[64];
+    for (size_t i = 0; i < count; i += 64) {
+        size_t n = std::min((size_t)count - i, (size_t)64);
+        memcpy(samples, data + sensorBatchHeaderSize + i * sizeof(SensorSample), n * sizeof(SensorSample));
+        pushSensorSamples(samples, n);
+    }
+    return count;
+}
+
+// 放入读数队列，队列满时计入丢弃数
+void pushSensorSamples(const SensorSample* samples, size_t count) {
+    SensorIngest& ingest = sensorIngest;
+    uint64_t dropped = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!ingest.ring.push(samples[i])) dropped++;
+    }
+    ingest.samplesReceived.fetch_add(count, std::memory_order_relaxed);
+    if (dropped > 0) ingest.samplesDropped.fetch_add(dropped, std::memory_order_relaxed);
+}
+
+// 换行符扫描内核 - 标量版本（也是SIMD版本的尾部处理和参考实现）
+const char* findLineEndScalar(const char* p, const char* end) {
+    while (p < end && *p != '\n') p++;
+    return p;
+}
+
+#ifdef FARM_X86
+// 换行符扫描内核 - SSE2版本，每次比较16字节
+const char* findLineEndSSE2(const char* p, const char* end) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; p + 16 <= end; p += 16) {
+        int bits = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), newline));
+        if (bits != 0) return p + lowestSetBit(bits);
+    }
+    return findLineEndScalar(p, end);
+}
+
+// 换行符扫描内核 - AVX2版本，每次比较32字节
+FARM_TARGET_AVX2
+const char* findLineEndAVX2(const char* p, const char* end) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    for (; p + 32 <= end; p += 32) {
+        int bits = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)p), newline));
+        if (bits != 0) return p + lowestSetBit(bits);
+    }
+    return findLineEndSSE2(p, end);
+}
+#else
+// 非x86平台只有标量内核
+const char* findLineEndSSE2(const char* p, const char* end) {
+    return findLineEndScalar(p, end);
+}
+
+const char* findLineEndAVX2(const char* p, const char* end) {
+    return findLineEndScalar(p, end);
+}
+#endif
+
+// 换行符扫描内核与植物内核使用同一指令集级别
+void selectLineScanKernel(PlantKernelLevel level) {
+    const char* names[] = { "Scalar", "SSE2 (16 bytes/op)", "AVX2 (32 bytes/op)" };
+    switch (level) {
+    case PLANT_KERNEL_AVX2: lineScanKernel = findLineEndAVX2; break;
+    case PLANT_KERNEL_SSE2: lineScanKernel = findLineEndSSE2; break;
+    default: lineScanKernel = findLineEndScalar; break;
+    }
+    std::cout << "Line protocol scan kernel: " << names[level] << std::endl;
+}
+
+// 行协议字段名对应的通道，不识别的字段返回 -1（网关可能附带电量等其他字段）
+int sensorFieldChannel(const char* name, size_t length) {
+    TextSlice field(name, name + length);
+    switch (length > 0 ? name[0] : 0) {
+    case 't':
+        if (field.is("temp", 4) || field.is("temperature", 11)) return SENSOR_CHANNEL_TEMPERATURE;
+        break;
+    case 'h':
+        if (field.is("hum", 3) || field.is("humidity", 8)) return SENSOR_CHANNEL_HUMIDITY;
+        break;
+    case 's':
+        if (field.is("soil", 4) || field.is("soil_moisture", 13)) return SENSOR_CHANNEL_SOIL_MOISTURE;
+        break;
+    case 'm':
+        if (field.is("moisture", 8)) return SENSOR_CHANNEL_SOIL_MOISTURE;
+        break;
+    case 'p':
+        if (field.is("ph", 2)) return SENSOR_CHANNEL_PH;
+        if (field.is("p", 1) || field.is("phosphorus", 10)) return SENSOR_CHANNEL_PHOSPHORUS;
+        break;
+    case 'P':
+        if (field.is("pH", 2)) return SENSOR_CHANNEL_PH;
+        break;
+    case 'n':
+        if (field.is("n", 1) || field.is("nitrogen", 8)) return SENSOR_CHANNEL_NITROGEN;
+        break;
+    case 'k':
+        if (field.is("k", 1)) return SENSOR_CHANNEL_POTASSIUM;
+        break;
+    case 'l':
+        if (field.is("light", 5) || field.is("lux", 3)) return SENSOR_CHANNEL_LIGHT;
+        break;
+    }
+    if (field.is("potassium", 9)) return SENSOR_CHANNEL_POTASSIUM;
+    return -1;
+}
+
+// 解析十进制数（可带符号、小数和指数），p 前进到数字之后。超过18位的有效数字只计入数量级
+bool parseTextNumber(const char*& p, const char* end, double& value) {
+    static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    const uint64_t mantissaLimit = 100000000000000000ULL;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    bool digits = false;
+    for (; p < end && (unsigned)(*p - '0') < 10; p++) {
+        if (mantissa < mantissaLimit) mantissa = mantissa * 10 + (unsigned)(*p - '0');
+        else exponent++;
+        digits = true;
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && (unsigned)(*p - '0') < 10; p++) {
+            if (mantissa < mantissaLimit) {
+                mantissa = mantissa * 10 + (unsigned)(*p - '0');
+                exponent--;
+            }
+            digits = true;
+        }
+    }
+    if (!digits) return false;
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        bool negativeExponent = false;
+        if (p < end && (*p == '-' || *p == '+')) {
+            negativeExponent = *p == '-';
+            p++;
+        }
+        if (p >= end || (unsigned)(*p - '0') >= 10) return false;
+        int e = 0;
+        for (; p < end && (unsigned)(*p - '0') < 10; p++) {
+            if (e < 10000) e = e * 10 + (*p - '0');
+        }
+        exponent += negativeExponent ? -e : e;
+    }
+
+    double v = (double)mantissa;
+    if (exponent < 0) v = exponent >= -22 ? v / powers[-exponent] : v * std::pow(10.0, exponent);
+    else if (exponent > 0) v = exponent <= 22 ? v * powers[exponent] : v * std::pow(10.0, exponent);
+    value = negative ? -v : v;
+    return true;
+}
+
+// 解析一行 "测量名,id=17[,标签=值...] temp=23.4,hum=61,...[ 时间戳]"（不含换行符），不分配内存。
+// 必须有 id 标签；只写入可识别字段（sample.channels 标记），字符串和布尔字段跳过；返回 false 为格式错误
+bool parseSensorLine(const char* p, const char* end, SensorSample& sample) {
+    sample.channels = 0;
+    bool hasId = false;
+
+    // 测量名和标签
+    while (p < end && *p != ',' && *p != ' ') p++;
+    while (p < end && *p == ',') {
+        const char* key = ++p;
+        while (p < end && *p != '=' && *p != ',' && *p != ' ') p++;
+        if (p >= end || *p != '=') return false;
+        TextSlice tag(key, p);
+        const char* value = ++p;
+        while (p < end && *p != ',' && *p != ' ') p++;
+        if (tag.is("id", 2)) {
+            if (value == p || p - value > 10) return false;
+            uint64_t id = 0;
+            for (const char* c = value; c < p; c++) {
+                if ((unsigned)(*c - '0') >= 10) return false;
+                id = id * 10 + (unsigned)(*c - '0');
+            }
+            if (id >= 0xFFFFFFFFu) return false;
+            sample.sensorId = (uint32_t)id;
+            hasId = true;
+        }
+    }
+    if (!hasId || p >= end) return false;
+
+    // 字段
+    do {
+        const char* key = ++p;
+        while (p < end && *p != '=' && *p != ',' && *p != ' ') p++;
+        if (p >= end || *p != '=' || p == key) return false;
+        int channel = sensorFieldChannel(key, (size_t)(p - key));
+        p++;
+        if (p < end && *p == '"') {
+            for (p++; p < end && *p != '"'; p++) {
+                if (*p == '\\') p++;
+            }
+            if (p >= end) return false;
+            p++;
+        }
+        else if (channel >= 0) {
+            double value;
+            if (!parseTextNumber(p, end, value)) return false;
+            if (p < end && (*p == 'i' || *p == 'u')) p++;   // 整数字段后缀
+            sample.value[channel] = (float)value;
+            sample.channels |= 1u << channel;
+        }
+        else {
+            while (p < end && *p != ',' && *p != ' ') p++;
+        }
+        if (p < end && *p != ',' && *p != ' ') return false;
+    } while (p < end && *p == ',');
+
+    // 可选时间戳（纳秒整数）：只校验格式，读数按到达时间生效
+    if (p < end) {
+        const char* timestamp = ++p;
+        if (p < end && *p == '-') p++;
+        while (p < end && (unsigned)(*p - '0') < 10) p++;
+        if (p != end || p == timestamp) return false;
+    }
+    return true;
+}
+
+// 解析缓冲区中的全部行，含可识别字段的读数追加到 out（调用方清空并复用其容量，逐行不分配内存）。
+// final 为 false 时末尾不完整的行留给下一次调用；返回已消费的字节数
+size_t parseSensorLines(const char* data, size_t size, bool final, std::vector<SensorSample>& out, LineParseStats& stats) {
+    const char* p = data;
+    const char* end = data + size;
+    SensorSample sample;
+    while (p < end) {
+        const char* lineEnd = lineScanKernel(p, end);
+        if (lineEnd == end && !final) break;
+        const char* last = lineEnd;
+        if (last > p && last[-1] == '\r') last--;
+        if (last > p && *p != '#') {
+            stats.lines++;
+            if (!parseSensorLine(p, last, sample)) stats.malformed++;
+            else if (sample.channels != 0) out.push_back(sample);
+        }
+        p = lineEnd == end ? end : lineEnd + 1;
+    }
+    stats.bytes += (uint64_t)(p - data);
+    return (size_t)(p - data);
+}
+
+// 把一条读数格式化为一行行协议文本（含换行符），返回写入的字节数，空间不足返回0。
+// 数值取能精确还原 float 的最短形式；timestamp 为0时省略时间戳
+size_t formatSensorLine(char* out, size_t capacity, const SensorSample& sample, unsigned long long timestamp) {
+    int n = snprintf(out, capacity, "sensor,id=%u", sample.sensorId);
+    char separator = ' ';
+    for (int c = 0; c < SENSOR_CHANNELS && n > 0 && (size_t)n < capacity; c++) {
+        if (!(sample.channels >> c & 1)) continue;
+        char number[32];
+        snprintf(number, sizeof(number), "%.6g", sample.value[c]);
+        if (strtof(number, nullptr) != sample.value[c]) snprintf(number, sizeof(number), "%.9g", sample.value[c]);
+        n += snprintf(out + n, capacity - n, "%c%s=%s", separator, sensorFieldNames[c], number);
+        separator = ',';
+    }
+    if (n > 0 && (size_t)n < capacity) {
+        n += timestamp != 0 ? snprintf(out + n, capacity - n, " %llu\n", timestamp) : snprintf(out + n, capacity - n, "\n");
+    }
+    return n > 0 && (size_t)n < capacity ? (size_t)n : 0;
+}
+
+// 模拟线程：取出队列中的全部读数，写入对应传感器的有效通道（非有限值忽略）
+void drainSensorIngest() {
+    SensorIngest& ingest = sensorIngest;
+    const EntityIndex& index = sensorStore.index;
+    const uint32_t channelMask = (1u << SENSOR_CHANNELS) - 1;
+    SensorSample sample;
+    size_t drained = 0;
+    unsigned int reported = 0;
+    while (drained < ingest.ring.capacity() && ingest.ring.pop(sample)) {
+        drained++;
+        if (sample.sensorId >= index.rowOfId.size() || index.rowOfId[sample.sensorId] == 0xFFFFFFFFu) {
+            ingest.unknownSensors++;
+            continue;
+        }
+        uint32_t row = index.rowOfId[sample.sensorId];
+        SensorReadings& sensor = sensorStore.measured[row];
+        uint32_t mask = 0;
+        for (int c = 0; c < SENSOR_CHANNELS; c++) {
+            if ((sample.channels >> c & 1) && std::isfinite(sample.value[c])) {
+                sensor.*sensorChannelField[c] = sample.value[c];
+                mask |= 1u << c;
+            }
+        }
+        if (simClock.simTime - ingest.liveTime[row] >= liveSensorTimeout) ingest.liveChannels[row] = 0;
+        ingest.liveChannels[row] |= (unsigned char)(mask & channelMask);
+        ingest.liveTime[row] = simClock.simTime;
+        ingest.samplesApplied++;
+
+        // 实测值同样经死区过滤，只有上报值变化的传感器重算显示
+        unsigned int changed = reportSensorChannels(row, mask);
+        sensorReportStats.channelSamples += countChannels(mask);
+        sensorReportStats.channelReports += countChannels(changed);
+        sensorReportStats.sensorRefreshes++;
+        reported |= changed;
+        if (sensorStore.report[row].dirty != 0) refreshSensorDisplay(row);
+        else sensorReportStats.cleanRefreshes++;
+    }
+    if (reported != 0) microclimateStale = true;
+    if (reported & (1u << SENSOR_CHANNEL_SOIL_MOISTURE)) irrigationSchedule.dirty = true;
+    ingest.peakBacklog = std::max(ingest.peakBacklog, drained);
+}
+
+inline uint64_t zigzagEncode(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+inline int64_t zigzagDecode(uint64_t v) { return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+inline size_t writeVarint(unsigned char* out, uint64_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        out[n++] = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    out[n++] = (unsigned char)v;
+    return n;
+}
+
+// 读取 varint，越界或超过10字节返回 false
+inline bool readVarint(const unsigned char*& p, const unsigned char* end, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        unsigned char byte = *p++;
+        v |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+// 把读数依次编码进一帧，直到读数用完或剩余空间放不下一条最长记录；返回消费的读数条数，
+// written 为帧字节数。编号超出 idLimit 的读数跳过（计入 rejectedIds），非有限值的通道不发送，
+// 没有任何有效通道的读数不写记录
+size_t encodeSensorFrame(SensorDeltaCodec& codec, const SensorSample* samples, size_t count,
+    unsigned char* out, size_t capacity, size_t& written) {
+    bool keyFrame = codec.keyInterval > 0 && codec.sequence % codec.keyInterval == 0;
+    size_t n = 0;
+    memcpy(out, &sensorFrameMagic, 4);
+    n += 4;
+    n += writeVarint(out + n, codec.sequence);
+    size_t countOffset = n;
+    n += 2;
+
+    uint32_t previousId = 0;
+    uint16_t records = 0;
+    size_t consumed = 0;
+    for (; consumed < count && records < 0xFFFF && n + sensorFrameRecordMax <= capacity; consumed++) {
+        const SensorSample& sample = samples[consumed];
+        uint32_t id = sample.sensorId;
+        if (id >= codec.idLimit) {
+            codec.rejectedIds++;
+            continue;
+        }
+        codec.track(id);
+        unsigned char known = codec.known[id];
+        int32_t* last = &codec.last[(size_t)id * SENSOR_CHANNELS];
+
+        unsigned char present = 0;
+        int32_t quantized[SENSOR_CHANNELS];
+        for (int c = 0; c < SENSOR_CHANNELS; c++) {
+            if (!(sample.channels >> c & 1) || !std::isfinite(sample.value[c])) continue;
+            double q = std::round(sample.value[c] / sensorChannelResolution[c]);
+            quantized[c] = (int32_t)std::min(std::max(q, -2147483647.0), 2147483647.0);
+            present |= (unsigned char)(1u << c);
+        }
+        if (present == 0) continue;
+        // 出现尚无基准的通道时整条发送绝对值，否则解码端无法还原该通道
+        bool absolute = keyFrame || (present & ~known) != 0;
+        unsigned char mask = 0;
+        for (int c = 0; c < SENSOR_CHANNELS; c++) {
+            if (present >> c & 1) {
+                if (absolute || quantized[c] != last[c]) mask |= (unsigned char)(1u << c);
+            }
+            else if (absolute && (known >> c & 1)) {
+                // 全量记录还需带上已知但本条未测的通道，使解码端重建完整基准
+                quantized[c] = last[c];
+                mask |= (unsigned char)(1u << c);
+            }
+        }
+        unsigned char baseline = absolute ? mask : known;
+        bool partial = present != baseline;
+
+        n += writeVarint(out + n, zigzagEncode((int64_t)id - (int64_t)previousId) << 2 | (partial ? 2 : 0) | (absolute ? 1 : 0));
+        out[n++] = mask;
+        if (partial) out[n++] = present;
+        for (int c = 0; c < SENSOR_CHANNELS; c++) {
+            if (!(mask >> c & 1)) continue;
+            int64_t base = absolute ? 0 : last[c];
+            n += writeVarint(out + n, zigzagEncode((int64_t)quantized[c] - base));
+            last[c] = quantized[c];
+            codec.channelValues++;
+        }
+        codec.known[id] = baseline;
+        previousId = id;
+        records++;
+    }
+    memcpy(out + countOffset, &records, 2);
+    codec.sequence++;
+    codec.frames++;
+    codec.records += records;
+    written = n;
+    return consumed;
+}
+
+// 校验一帧的结构（不改变编解码状态），返回帧字节数，格式错误或不完整返回0
+size_t measureSensorFrame(const unsigned char* data, size_t size) {
+    const unsigned char* p = data;
+    const unsigned char* end = data + size;
+    uint32_t magic;
+    uint64_t sequence, head, value;
+    uint16_t records;
+    if (size < 4) return 0;
+    memcpy(&magic, p, 4);
+    p += 4;
+    if (magic != sensorFrameMagic || !readVarint(p, end, sequence) || end - p < 2) return 0;
+    memcpy(&records, p, 2);
+    p += 2;
+    uint32_t previousId = 0;
+    for (uint16_t r = 0; r < records; r++) {
+        if (!readVarint(p, end, head) || end - p < ((head & 2) ? 2 : 1)) return 0;
+        int64_t id = (int64_t)previousId + zigzagDecode(head >> 2);
+        if (id < 0 || id >= (int64_t)sensorFrameMaxId) return 0;
+        unsigned char mask = *p++;
+        if (head & 2) p++;
+        for (int c = 0; c < SENSOR_CHANNELS; c++) {
+            if ((mask >> c & 1) && !readVarint(p, end, value)) return 0;
+        }
+        previousId = (uint32_t)id;
+    }
+    return (size_t)(p - data);
+}
+
+// 解码一帧，每条记录输出一个读数（只含本条实测且能还原的通道）；返回帧字节数，格式错误或不完整返回0（状态不变）。
+// 帧序号不连续时清空全部基准（之后的增量值在下一条绝对值记录前丢弃）；编号超出 idLimit 的记录跳过
+size_t decodeSensorFrame(SensorDeltaCodec& codec, const unsigned char* data, size_t size, std::vector<SensorSample>& out) {
+    size_t frameSize = measureSensorFrame(data, size);
+    if (frameSize == 0) return 0;
+    const unsigned char* p = data + 4;
+    const unsigned char* end = data + frameSize;
+    uint64_t sequence;
+    uint16_t records;
+    readVarint(p, end, sequence);
+    memcpy(&records, p, 2);
+    p += 2;
+
+    if (codec.started && (uint32_t)sequence != codec.sequence) {
+        std::fill(codec.known.begin(), codec.known.end(), (unsigned char)0);
+        codec.resyncs++;
+    }
+    uint32_t previousId = 0;
+    SensorSample sample;
+    for (uint16_t r = 0; r < records; r++) {
+        uint64_t head, value;
+        readVarint(p, end, head);
+        uint32_t id = (uint32_t)((int64_t)previousId + zigzagDecode(head >> 2));
+        bool absolute = (head & 1) != 0;
+        unsigned char mask = *p++;
+        unsigned char present = (head & 2) ? *p++ : 0;
+        previousId = id;
+        if (id >= codec.idLimit) {
+            for (int c = 0; c < SENSOR_CHANNELS; c++) {
+                if (mask >> c & 1) readVarint(p, end, value);
+            }
+            codec.rejectedIds++;
+            continue;
+        }
+        codec.track(id);
+        unsigned char known = absolute ? 0 : codec.known[id];
+        int32_t* last = &codec.last[(size_t)id * SENSOR_CHANNELS];
+        for (int c = 0; c < SENSOR_CHANNELS; c++) {
+            if (!(mask >> c & 1)) continue;
+            readVarint(p, end, value);
+            if (absolute) {
+                last[c] = (int32_t)zigzagDecode(value);
+                known |= (unsigned char)(1u << c);
+            }
+            else if (known >> c & 1) {
+                last[c] = (int32_t)(last[c] + zigzagDecode(value));
+            }
+            else {
+                codec.orphanValues++;
+            }
+        }
+        codec.known[id] = known;
+        present = (head & 2) ? (unsigned char)(present & known) : known;
+        if (present == 0) continue;
+
+        sample.sensorId = id;
+        sample.channels = present;
+        for (int c = 0; c < SENSOR_CHANNELS; c++) {
+            sample.value[c] = (present >> c & 1) ? (float)(last[c] * sensorChannelResolution[c]) : 0.0f;
+        }
+        out.push_back(sample);
+        codec.records++;
+    }
+    codec.started = true;
+    codec.sequence = (uint32_t)sequence + 1;
+    codec.frames++;
+    return frameSize;
+}
+
+// 回放进程：代替田间网关，按给定速率向接入端点发送合成读数的批量数据报
+// （传感器编号循环，各通道随机游走），结束时输出实际发送速率
+int runSensorReplay(const RunOptions& options) {
+    if (!initializeFarmSockets()) return -1;
+    sockaddr_storage address;
+    socklen_t length = 0;
+    FarmSocket s = openReplaySocket(options.replayTarget, address, length);
+    if (s == invalidFarmSocket) {
+        std::cout << "Cannot open replay target " << options.replayTarget << std::endl;
+        return -1;
+    }
+
+    const int sensors = options.replaySensors;
+    PhiloxStream rng(options.hasSeed ? options.seed : 1, RNG_SENSOR_REPLAY, 0, 0);
+    static const float initial[SENSOR_CHANNELS] = { 24.0f, 60.0f, 45.0f, 6.8f, 50.0f, 40.0f, 45.0f, 700.0f };
+    static const float step[SENSOR_CHANNELS] = { 0.2f, 1.0f, 0.5f, 0.02f, 0.5f, 0.5f, 0.5f, 20.0f };
+    static const float lowest[SENSOR_CHANNELS] = { 5.0f, 10.0f, 0.0f, 4.5f, 0.0f, 0.0f, 0.0f, 0.0f };
+    static const float highest[SENSOR_CHANNELS] = { 45.0f, 100.0f, 100.0f, 9.0f, 100.0f, 100.0f, 100.0f, 1500.0f };
+    std::vector<SensorSample> state(sensors);
+    for (int i = 0; i < sensors; i++) {
+        state[i].sensorId = (uint32_t)i;
+        state[i].channels = (1u << SENSOR_CHANNELS) - 1;
+        for (int c = 0; c < SENSOR_CHANNELS; c++) state[i].value[c] = initial[c];
+    }
+
+    std::vector<char> datagram(std::max(sensorBatchHeaderSize + sensorBatchMaxSamples * sizeof(SensorSample), sensorTextDatagramMax));
+    std::vector<SensorSample> batch(sensorBatchMaxSamples);
+    SensorDeltaCodec encoder;
+    uint16_t reserved = 0;
+    const char* formatNames[] = { "binary batches", "line protocol", "delta frames" };
+
+    std::cout << "Replaying " << sensors << " sensors to " << options.replayTarget << " at "
+        << options.replayRate << " readings/s for " << options.replaySeconds << " s ("
+        << formatNames[options.replayFormat] << ")" << std::endl;
+    auto start = std::chrono::steady_clock::now();
+    uint64_t sent = 0, delivered = 0, datagrams = 0, sendErrors = 0, bytesSent = 0;
+    int next = 0;
+    double elapsed = 0.0;
+    while (elapsed < options.replaySeconds) {
+        for (SensorSample& sample : batch) {
+            SensorSample& sensor = state[next];
+            for (int c = 0; c < SENSOR_CHANNELS; c++) {
+                sensor.value[c] = clamp(sensor.value[c] + rng.uniform(-1.0f, 1.0f) * step[c], lowest[c], highest[c]);
+            }
+            sample = sensor;
+            next = (next + 1) % sensors;
+        }
+
+        // 二进制批量帧一个数据报装完；文本和增量帧装到数据报上限为止，剩余的放入下一个数据报
+        unsigned long long timestamp = (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        for (size_t done = 0; done < batch.size();) {
+            size_t bytes = 0, count = 0;
+            switch (options.replayFormat) {
+            case TELEMETRY_TEXT:
+                while (done + count < batch.size()) {
+                    size_t written = formatSensorLine(datagram.data() + bytes, sensorTextDatagramMax - bytes, batch[done + count], timestamp);
+                    if (written == 0) break;
+                    bytes += written;
+                    count++;
+                }
+                break;
+            case TELEMETRY_DELTA:
+                count = encodeSensorFrame(encoder, batch.data() + done, batch.size() - done,
+                    (unsigned char*)datagram.data(), sensorTextDatagramMax, bytes);
+                break;
+            default: {
+                count = batch.size() - done;
+                uint16_t header = (uint16_t)count;
+                memcpy(datagram.data(), &sensorBatchMagic, 4);
+                memcpy(datagram.data() + 4, &header, 2);
+                memcpy(datagram.data() + 6, &reserved, 2);
+                memcpy(datagram.data() + sensorBatchHeaderSize, batch.data() + done, count * sizeof(SensorSample));
+                bytes = sensorBatchHeaderSize + count * sizeof(SensorSample);
+                break;
+            }
+            }
+            if (sendto(s, datagram.data(), (int)bytes, 0, (const sockaddr*)&address, length) < 0) sendErrors++;
+            else {
+                datagrams++;
+                delivered += count;
+                bytesSent += bytes;
+            }
+            done += count;
+            sent += count;
+        }
+
+        // 按目标速率节流：领先于计划时休眠
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double ahead = sent / options.replayRate - elapsed;
+        if (ahead > 0.0) {
+            std::this_thread::sleep_for(std::chrono::duration<double>(ahead));
+            elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+    closeFarmSocket(s);
+    std::cout << "Replay complete: " << delivered << " readings in " << datagrams
+        << " datagrams (" << sendErrors << " send errors), " << std::fixed << std::setprecision(0)
+        << delivered / elapsed << " readings/s, " << std::setprecision(1)
+        << (delivered > 0 ? (double)bytesSent / delivered : 0.0) << " bytes/reading" << std::endl;
+    return 0;
+}
+
+// 转换工具：输入以增量帧魔数开头时把增量帧文件（帧依次拼接）转为行协议文本（不含时间戳），
+// 否则把行协议文本转为增量帧文件（每帧不超过 --frame-bytes）。按1MB分块流式处理，
+// 输出读数数、压缩比和编解码本身的吞吐量（不含文件读写和文本格式化/解析）
+int runTelemetryConversion(const RunOptions& options) {
+    std::ifstream input(options.convertInput.c_str(), std::ios::binary);
+    if (!input) {
+        std::cout << "Cannot open " << options.convertInput << std::endl;
+        return -1;
+    }
+    std::ofstream output(options.convertOutput.c_str(), std::ios::binary);
+    if (!output) {
+        std::cout << "Cannot create " << options.convertOutput << std::endl;
+        return -1;
+    }
+    selectLineScanKernel(detectPlantKernelLevel());
+
+    std::vector<char> buffer(1u << 20);
+    size_t filled = 0;
+    uint64_t bytesIn = 0;
+    input.read(buffer.data(), 4);
+    filled = (size_t)input.gcount();
+    bytesIn = filled;
+    uint32_t magic = 0;
+    if (filled == 4) memcpy(&magic, buffer.data(), 4);
+    const bool toText = (magic & sensorFrameMagicMask) == (sensorFrameMagic & sensorFrameMagicMask);
+
+    SensorDeltaCodec codec;
+    LineParseStats stats;
+    std::vector<SensorSample> samples;
+    std::vector<unsigned char> encoded;
+    std::vector<char> text;
+    uint64_t readings = 0, bytesOut = 0;
+    double codecSeconds = 0.0;
+    bool ok = true;
+    char line[512];
+    for (;;) {
+        input.read(buffer.data() + filled, buffer.size() - filled);
+        size_t got = (size_t)input.gcount();
+        filled += got;
+        bytesIn += got;
+        bool final = !input;
+        samples.clear();
+        size_t used = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        if (toText) {
+            // 增量帧长度可变：解码到不完整的帧为止，读到文件末尾仍不完整则为格式错误
+            while (used < filled) {
+                size_t frame = decodeSensorFrame(codec, (const unsigned char*)buffer.data() + used, filled - used, samples);
+                if (frame == 0) break;
+                used += frame;
+            }
+        }
+        else {
+            used = parseSensorLines(buffer.data(), filled, final, samples, stats);
+            start = std::chrono::steady_clock::now();
+            encoded.resize(samples.size() * sensorFrameRecordMax + (samples.size() + 1) * sensorFrameHeaderMax);
+            size_t bytes = 0;
+            for (size_t done = 0; done < samples.size();) {
+                size_t written;
+                done += encodeSensorFrame(codec, samples.data() + done, samples.size() - done,
+                    encoded.data() + bytes, (size_t)options.frameBytes, written);
+                bytes += written;
+            }
+            encoded.resize(bytes);
+        }
+        codecSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (toText) {
+            text.clear();
+            for (const SensorSample& sample : samples) {
+                size_t n = formatSensorLine(line, sizeof(line), sample, 0);
+                text.insert(text.end(), line, line + n);
+            }
+            output.write(text.data(), (std::streamsize)text.size());
+            bytesOut += text.size();
+        }
+        else {
+            output.write((const char*)encoded.data(), (std::streamsize)encoded.size());
+            bytesOut += encoded.size();
+        }
+        readings = codec.records;   // 实际编码或解码出的记录（跳过的读数不计）
+
+        memmove(buffer.data(), buffer.data() + used, filled - used);
+        filled -= used;
+        if (final) {
+            ok = filled == 0;
+            break;
+        }
+        if (used == 0 && filled == buffer.size()) {
+            ok = false;
+            break;
+        }
+    }
+
+    uint64_t frameBytes = toText ? bytesIn : bytesOut;
+    uint64_t textBytes = toText ? bytesOut : bytesIn;
+    std::cout << (toText ? "Decoded " : "Encoded ") << readings << " readings: " << bytesIn << " -> " << bytesOut
+        << " bytes (" << std::fixed << std::setprecision(1) << (readings > 0 ? (double)frameBytes / readings : 0.0)
+        << " bytes/reading in frames, " << std::setprecision(2) << (double)textBytes / std::max<uint64_t>(frameBytes, 1)
+        << "x smaller than text) | " << codec.frames << " frames | codec " << std::setprecision(1)
+        << readings / std::max(codecSeconds, 1e-9) / 1e6 << " M readings/s" << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+    if (!toText && stats.malformed > 0) std::cout << "   " << stats.malformed << " malformed lines skipped" << std::endl;
+    if (codec.rejectedIds > 0) {
+        std::cout << "   " << codec.rejectedIds << (toText ? " records" : " readings") << " with sensor id >= "
+            << codec.idLimit << " skipped" << std::endl;
+    }
+    if (toText && (codec.resyncs > 0 || codec.orphanValues > 0)) {
+        std::cout << "   " << codec.resyncs << " sequence gaps, " << codec.orphanValues << " values without baseline" << std::endl;
+    }
+    if (!ok) {
+        std::cout << "Input ends with an incomplete or malformed " << (toText ? "frame" : "line") << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+// 行协议解析基准：生成64MB合成语料（全通道和部分通道的行混合，带附加标签和非通道字段），
+// 按1MB接收缓冲区分块反复解析直到累计处理量达到 --bench-line-protocol 指定的 GB 数，
+// 对CPU支持的每个扫描内核输出 GB/s 和 lines/s，各内核的读数校验和应一致
+int runLineProtocolBenchmark(const RunOptions& options) {
+    const size_t corpusBytes = 64u << 20;
+    const size_t receiveBuffer = 1u << 20;
+    std::string corpus;
+    corpus.reserve(corpusBytes + 512);
+    PhiloxStream rng(options.hasSeed ? options.seed : 1, RNG_SENSOR_REPLAY, 1, 0);
+    unsigned long long timestamp = 1718000000000000000ULL;
+    char line[512];
+    for (uint64_t i = 0; corpus.size() < corpusBytes; i++) {
+        SensorSample sample;
+        sample.sensorId = rng.below(50000);
+        bool full = rng.uniform(0.0f, 1.0f) < 0.7f;
+        sample.channels = full ? (1u << SENSOR_CHANNELS) - 1 : 0x7u;
+        sample.value[SENSOR_CHANNEL_TEMPERATURE] = std::round(rng.uniform(5.0f, 40.0f) * 10.0f) / 10.0f;
+        sample.value[SENSOR_CHANNEL_HUMIDITY] = std::round(rng.uniform(20.0f, 100.0f));
+        sample.value[SENSOR_CHANNEL_SOIL_MOISTURE] = std::round(rng.uniform(0.0f, 100.0f));
+        sample.value[SENSOR_CHANNEL_PH] = std::round(rng.uniform(4.5f, 9.0f) * 100.0f) / 100.0f;
+        sample.value[SENSOR_CHANNEL_NITROGEN] = std::round(rng.uniform(0.0f, 100.0f));
+        sample.value[SENSOR_CHANNEL_PHOSPHORUS] = std::round(rng.uniform(0.0f, 100.0f));
+        sample.value[SENSOR_CHANNEL_POTASSIUM] = std::round(rng.uniform(0.0f, 100.0f));
+        sample.value[SENSOR_CHANNEL_LIGHT] = std::round(rng.uniform(0.0f, 1500.0f));
+        size_t n = formatSensorLine(line, sizeof(line), sample, timestamp + i * 1000000ULL);
+        if (!full) {
+            // 部分行带站点标签和电量字段（解析时忽略）
+            std::string text(line, n);
+            size_t space = text.find(' ');
+            text.insert(space, ",site=north");
+            text.insert(text.rfind(' '), ",battery=3.71");
+            corpus += text;
+        }
+        else {
+            corpus.append(line, n);
+        }
+    }
+    uint64_t corpusLines = (uint64_t)std::count(corpus.begin(), corpus.end(), '\n');
+    std::cout << "Line protocol benchmark: " << corpus.size() / 1048576 << " MB corpus, " << corpusLines
+        << " lines, " << options.benchLineGigabytes << " GB per kernel in " << receiveBuffer / 1024
+        << " KB receive buffers" << std::endl;
+
+    PlantKernelLevel supported = detectPlantKernelLevel();
+    std::vector<SensorSample> samples;
+    samples.reserve(receiveBuffer / 16);
+    const uint64_t target = (uint64_t)(options.benchLineGigabytes * 1e9);
+    for (int level = 0; level <= (int)supported; level++) {
+        if (options.plantKernel >= 0 && level != options.plantKernel) continue;
+        selectLineScanKernel((PlantKernelLevel)level);
+        LineParseStats stats;
+        uint64_t sampleCount = 0;
+        double checksum = 0.0;
+        auto start = std::chrono::steady_clock::now();
+        while (stats.bytes < target) {
+            size_t offset = 0;
+            while (offset < corpus.size()) {
+                size_t chunk = std::min(receiveBuffer, corpus.size() - offset);
+                samples.clear();
+                offset += parseSensorLines(corpus.data() + offset, chunk, offset + chunk == corpus.size(), samples, stats);
+                sampleCount += samples.size();
+                for (const SensorSample& sample : samples) checksum += sample.value[SENSOR_CHANNEL_TEMPERATURE];
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "   " << std::fixed << std::setprecision(2) << stats.bytes / seconds / 1e9 << " GB/s, "
+            << std::setprecision(1) << stats.lines / seconds / 1e6 << " M lines/s | " << stats.lines << " lines, "
+            << sampleCount << " readings, " << stats.malformed << " malformed in " << std::setprecision(2)
+            << seconds << " s | checksum " << std::setprecision(1) << checksum << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+    }
+    return 0;
+}
+
+// 按 --sample-period 换算各通道的采样周期（步数）。随机游走和噪声步长按 sqrt(周期/2秒)、
+// 露天回归比例按 1 - 0.8^(周期/2秒) 折算，与原来统一每2秒刷新时的漂移和回归速率一致
+void initializeSensorSchedule() {
+    SensorSampleSchedule& schedule = sensorSchedule;
+    for (int c = 0; c < SENSOR_CHANNELS; c++) {
+        float period = std::max(runOptions.samplePeriod[c], simClock.fixedStep);
+        schedule.periodTicks[c] = (uint32_t)std::max(1.0, std::round((double)period / simClock.fixedStep));
+        float ratio = schedule.periodTicks[c] * simClock.fixedStep / 2.0f;
+        schedule.drift[c] = std::sqrt(ratio);
+        schedule.relax[c] = 1.0f - std::pow(0.8f, ratio);
+    }
+    schedule.due.assign(sensorStore.size(), 0);
+    std::cout << "Sensor sampling: temp " << runOptions.samplePeriod[SENSOR_CHANNEL_TEMPERATURE] << " s, soil "
+        << runOptions.samplePeriod[SENSOR_CHANNEL_SOIL_MOISTURE] << " s, pH " << runOptions.samplePeriod[SENSOR_CHANNEL_PH]
+        << " s, NPK " << runOptions.samplePeriod[SENSOR_CHANNEL_NITROGEN] << " s (sim), phases staggered across ticks" << std::endl;
+}
+
+// 刷新本步到期的传感器通道 - 到期行按块并行，共享计数写入各线程累加器后归约。
+// 每步的工作量只与到期的行和通道数成正比
+void sampleSensorChannels() {
+    SensorSampleSchedule& schedule = sensorSchedule;
+    const size_t count = sensorStore.size();
+    if (count == 0) return;
+    auto start = std::chrono::steady_clock::now();
+    if (schedule.due.size() != count) schedule.due.assign(count, 0);
+    if (sensorEvents.size() != count) sensorEvents.assign(count, 0);
+
+    // 每个通道的到期行是一个连续区间：相位 floor(r * P / N) == (tick + 通道错开量) mod P
+    schedule.rows.clear();
+    uint64_t tick = (uint64_t)simClock.totalSteps;
+    for (int c = 0; c < SENSOR_CHANNELS; c++) {
+        uint64_t period = schedule.periodTicks[c];
+        uint64_t slot = (tick + (uint64_t)c * period / SENSOR_CHANNELS) % period;
+        size_t begin = (size_t)((slot * count + period - 1) / period);
+        size_t end = (size_t)(((slot + 1) * count + period - 1) / period);
+        for (size_t r = begin; r < end; r++) {
+            if (schedule.due[r] == 0) schedule.rows.push_back((uint32_t)r);
+            schedule.due[r] |= (unsigned char)(1u << c);
+        }
+    }
+    schedule.ticks++;
+    if (schedule.rows.empty()) return;
+    std::sort(schedule.rows.begin(), schedule.rows.end());
+
+    SensorTickParams sensorParams;
+    sensorParams.dayFactor = (std::sin(dayNightCycle * 2.0f * 3.14159f) + 1.0f) * 0.5f;
+    sensorParams.outdoorTemperature = weather.temperature;
+    sensorParams.outdoorHumidity = weather.humidity;
+    sensorParams.applyFertilizer = farmStatus.autoFertilizer && farmStatus.fertilizerLevel > 10.0f;
+
+    const size_t rows = schedule.rows.size();
+    prepareChunkAccumulators(rows, sensorChunkSize);
+    threadPool.parallelFor(rows, sensorChunkSize, [&](size_t begin, size_t end, int) {
+        TickAccumulator& acc = chunkAccumulators[begin / sensorChunkSize];
+        for (size_t k = begin; k < end; k++) {
+            uint32_t row = schedule.rows[k];
+            sensorEvents[row] = 0;
+            updateSensorReading(row, schedule.due[row], sensorParams, acc, sensorEvents[row]);
+        }
+    });
+
+    const TickAccumulator& total = reduceChunkAccumulators();
+    sensorReportStats.channelSamples += total.channelSamples;
+    sensorReportStats.channelReports += total.channelReports;
+    sensorReportStats.sensorRefreshes += rows;
+    sensorReportStats.cleanRefreshes += total.cleanSensors;
+    // 只有上报值变化时才让下游重新采样微气候；土壤湿度上报变化才需要重排灌溉计划
+    if (total.reportedChannels != 0) microclimateStale = true;
+    if (total.reportedChannels & (1u << SENSOR_CHANNEL_SOIL_MOISTURE)) irrigationSchedule.dirty = true;
+    farmStatus.fertilizerLevel -= total.fertilizerUsed;
+
+    for (uint32_t row : schedule.rows) {
+        if (simEventLog && (sensorEvents[row] & SENSOR_EVENT_FERTILIZED)) {
+            std::cout << "FERTILIZER APPLIED at sensor " << row
+                << " - nitrogen fertigation on, PK levels boosted!" << std::endl;
+        }
+        schedule.channelsSampled += countChannels(schedule.due[row]);
+        schedule.due[row] = 0;
+    }
+    schedule.rowsSampled += rows;
+    schedule.peakRows = std::max(schedule.peakRows, rows);
+    double millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    schedule.millis += millis;
+    schedule.peakMillis = std::max(schedule.peakMillis, millis);
+}
+
+// 更新农场模拟 - 优化
+void updateFarmSimulation(float deltaTime) {
+    // 所有模拟计时使用固定步长累计的模拟时间，与帧率无关
+    float simTime = (float)simClock.simTime;
+
+    // 天气：从气象文件或预先生成的逐小时时间线插值
+    if (weatherFile.active()) applyWeatherFile(simClock.simTime);
+    else applyWeatherTimeline(simClock.simTime);
+
+    // 昼夜循环 (90秒一个周期)
+    dayNightCycle += deltaTime / dayLengthSeconds;
+    if (dayNightCycle > 1.0f) dayNightCycle -= 1.0f;
+
+    // 动态风效果
+    windDirection.x = std::cos(simTime * 0.3f) + std::sin(simTime * 0.8f) * 0.5f;
+    windDirection.y = std::sin(simTime * 0.4f) + std::cos(simTime * 1.1f) * 0.4f;
+    windDirection = glm::normalize(windDirection);
+
+    // 温室热湿区和气候控制回路每个模拟步推进
+    stepGreenhouseZones(deltaTime);
+
+    // 实测读数：取出接入线程送来的全部读数
+    if (sensorIngest.active()) drainSensorIngest();
+
+    // 多速率采样：刷新本步到期的传感器通道
+    sampleSensorChannels();
+
+    // 温室气候日志每2秒输出
+    if (simEventLog && simClock.simTime - simClock.lastClimateLog > 2.0) {
+        simClock.lastClimateLog = simClock.simTime;
+        const GreenhouseZones& g = greenhouseZones;
+        for (size_t z = 0; farmStatus.climateControl && z < std::min(g.zones(), (size_t)8); z++) {
+            std::cout << "CLIMATE CONTROL greenhouse " << z
+                << " - Temperature: " << g.airTemperature[z] << "C, Humidity: " << g.humidity[z]
+                << "% | Heat " << (int)(g.heat[z] * 100.0f) << "% Vent " << (int)(g.vent[z] * 100.0f)
+                << "% Mist " << (int)(g.mist[z] * 100.0f) << "%" << std::endl;
+        }
+    }
+
+    // 蒸散需水预报：每模拟小时按最新传感器读数和作物生长阶段刷新
+    if (simClock.simTime - simClock.lastEtForecast >= dayLengthSeconds / 24.0f) {
+        simClock.lastEtForecast = simClock.simTime;
+        refreshEtForecast();
+        irrigationSchedule.dirty = true;
+    }
+
+    // 土壤场：按实际经过的模拟时间步进
+    if (simClock.simTime - simClock.lastSoilUpdate >= soilStepSeconds) {
+        float soilDt = (float)(simClock.simTime - simClock.lastSoilUpdate);
+        simClock.lastSoilUpdate = simClock.simTime;
+        if (irrigationSchedule.dirty) solveIrrigationSchedule();
+        applyIrrigationSlot(soilDt);
+        stepSoilGrid(soilDt, (std::sin(dayNightCycle * 2.0f * 3.14159f) + 1.0f) * 0.5f);
+        microclimateStale = true;
+    }
+
+    // 更新植物生长和健康度 - 每tick一致的条件先合并成内核参数
+    float weatherEffect = 1.0f;
+    if (weather.weatherType == 0) weatherEffect = 1.01f;      // 晴天有利
+    else if (weather.weatherType == 1) weatherEffect = 1.005f; // 多云中性
+    else if (weather.weatherType == 2) weatherEffect = 1.002f; // 雨天适度有利
+    else if (weather.weatherType == 3) weatherEffect = 0.995f; // 暴风雨不利
+
+    PlantKernelParams kernelParams;
+
+    // 施肥系统对植物的超明显影响
+    if (farmStatus.autoFertilizer && farmStatus.fertilizerLevel > 20.0f) {
+        kernelParams.fertilizerHealth = 0.005f; // 增加效果
+        kernelParams.fertilizerGrowth = 0.002f; // 加速生长
+        static int fertilizerCount = 0;
+        fertilizerCount += (int)plantStore.sim.size();
+        if (fertilizerCount % 50 < (int)plantStore.sim.size() && simEventLog) { // 每50次输出一次避免刷屏
+            std::cout << "FERTILIZER boosting plant growth - "
+                << fertilizerCount << " plants enhanced!" << std::endl;
+        }
+    }
+
+    // 夜间照明超明显延长生长时间
+    if (farmStatus.nightLighting) {
+        weatherEffect *= 1.08f; // 大幅生长奖励
+        kernelParams.nightGrowth = deltaTime * 0.001f; // 额外夜间生长
+        static int lightingBonusCount = 0;
+        lightingBonusCount += (int)plantStore.sim.size();
+        if (lightingBonusCount % 100 < (int)plantStore.sim.size() && simEventLog) {
+            std::cout << "NIGHT LIGHTING providing 24/7 growth boost - "
+                << lightingBonusCount << " growth cycles enhanced!" << std::endl;
+        }
+    }
+
+    // 自动收获成熟植物 - 更明显的效果
+    if (farmStatus.autoHarvest) {
+        kernelParams.harvestGrowthMin = 0.9f;
+    }
+
+    // 气候控制提供超稳定生长环境
+    if (farmStatus.climateControl) {
+        weatherEffect = std::max(weatherEffect, 1.05f); // 确保优秀生长率
+        kernelParams.climateHealth = 0.0005f; // 长期健康提升
+    }
+    kernelParams.weatherEffect = weatherEffect;
+
+    // 每种作物一份内核参数（积温、物候阶段、适宜范围）
+    cropKernelParams.resize(cropTable.size());
+    for (size_t c = 0; c < cropTable.size(); c++) {
+        cropKernelParams[c] = kernelParams;
+        cropKernelParams[c].setCrop(cropTable[c], deltaTime);
+    }
+    if (plantBatchesStale) rebuildPlantBatches();
+
+    // 按作物批次并行：传感器或土壤有更新时先按采样表收集小气候（两次更新之间输入不变，
+    // 不必每tick重采），再运行该作物习性的特化内核（同一批数据仍在缓存中）
+    bool resampleMicroclimate = microclimateStale;
+    microclimateStale = false;
+    if (resampleMicroclimate) pestGrid.susceptibilityStale = true;
+    prepareChunkAccumulators(plantBatches.size(), 1);
+    threadPool.parallelFor(plantBatches.size(), 1, [&](size_t begin, size_t end, int) {
+        for (size_t b = begin; b < end; b++) {
+            const PlantBatch& batch = plantBatches[b];
+            if (resampleMicroclimate) samplePlantMicroclimate(batch.begin, batch.end);
+            plantKernels[cropTable[batch.crop].habit](plantStore.sim, batch.begin, batch.end,
+                cropKernelParams[batch.crop], chunkAccumulators[b].plants);
+        }
+    });
+    const PlantKernelResult& kernelResult = reduceChunkAccumulators().plants;
+
+    // 收获的植物已在内核中原地重置为幼苗，这里只换代，使旧句柄失效
+    for (uint32_t row : kernelResult.harvestedRows) {
+        plantStore.replant(row);
+    }
+
+    if (kernelResult.harvested > 0) {
+        farmStatus.harvestYield += 0.5f * kernelResult.harvested; // 增加收获量
+        if (simEventLog) {
+            std::cout << "AUTO HARVEST collected " << kernelResult.harvested << " mature plant(s)! Total yield: "
+                << std::fixed << std::setprecision(1) << farmStatus.harvestYield << " kg" << std::endl;
+        }
+    }
+
+    // 每秒清除一次枯死植物并在原位补种幼苗
+    if (simClock.simTime - simClock.lastPlantCull >= 1.0) {
+        simClock.lastPlantCull = simClock.simTime;
+        cullDeadPlants();
+    }
+
+    // 病虫害：邻域传播（湿度、风驱动）按固定步长推进，病虫防治开启时每秒按喷洒覆盖范围治疗一轮。
+    // 植物增删后先按新行号重建分桶
+    if (pestGrid.bucketsStale) rebuildPestGrid();
+    if (simClock.simTime - simClock.lastPestSpread >= pestStepSeconds) {
+        float pestDt = (float)(simClock.simTime - simClock.lastPestSpread);
+        simClock.lastPestSpread = simClock.simTime;
+        stepPestSpread(pestDt);
+    }
+    if (farmStatus.pestControl && simClock.simTime - simClock.lastPestSpray >= 1.0) {
+        simClock.lastPestSpray = simClock.simTime;
+        sprayPestFootprints();
+    }
+
+    // 更新光照位置 (太阳轨迹)
+    float sunAngle = dayNightCycle * 2.0f * 3.14159f;
+    lightPos = glm::vec3(
+        cos(sunAngle) * 25.0f,
+        5.0f + sin(sunAngle) * 15.0f,
+        sin(sunAngle) * 15.0f
+    );
+
+    // 动态光照颜色
+    float dayIntensity = clamp(lightPos.y / 20.0f, 0.0f, 1.0f);
+    if (dayIntensity > 0.1f) {
+        lightColor = glm::mix(glm::vec3(1.0f, 0.7f, 0.4f), glm::vec3(1.0f, 0.95f, 0.8f), dayIntensity);
+    }
+    else {
+        lightColor = glm::vec3(0.3f, 0.4f, 0.8f); // 夜晚蓝色调
+    }
+
+    // 根据天气调整光照颜色
+    switch (weather.weatherType) {
+    case 1: // 多云
+        lightColor *= 0.9f;
+        break;
+    case 2: // 雨天
+        lightColor *= 0.7f;
+        break;
+    case 3: // 暴风雨
+        lightColor *= 0.5f;
+        break;
+    }
+}
+
+// 植物小气候采样：温度、湿度按权重表从邻近传感器插值，土壤水分取所在土壤单元格
+void samplePlantMicroclimate(size_t begin, size_t end) {
+    PlantColumns& sim = plantStore.sim;
+    const SensorReadings* readings = sensorStore.readings.data();
+    const SensorWeights* weights = plantStore.site.sensorWeights.data();
+    const uint32_t* soilCell = plantStore.site.soilCell.data();
+    const float* moisture = soilGrid.moisture.data();
+    for (size_t i = begin; i < end; i++) {
+        const SensorWeights& w = weights[i];
+        float temperature = 0.0f;
+        float humidity = 0.0f;
+        for (int k = 0; k < microclimateNeighbors; k++) {
+            const SensorReadings& sensor = readings[w.sensor[k]];
+            temperature += w.weight[k] * sensor.temperature;
+            humidity += w.weight[k] * sensor.humidity;
+        }
+        sim.localTemperature[i] = temperature;
+        sim.localHumidity[i] = humidity;
+        sim.localMoisture[i] = moisture[soilCell[i]];
+    }
+}
+
+// 初始化病虫害网格：植物按位置分桶，统计初始感染
+// 清除枯死植物（每秒调用）：健康持续 plantDeathSeconds 处于 plantDeathHealth 的植株删除（末行补位），
+// 并在原位补种同一作物的幼苗。从末行向前扫描，补位移入的行都已检查过；
+// 新种植追加在末尾并复用刚释放的编号（新代数）
+void cullDeadPlants() {
+    PlantColumns& sim = plantStore.sim;
+    int culled = 0;
+    for (size_t row = plantStore.size(); row-- > 0;) {
+        if (sim.healthFactor[row] > plantDeathHealth) {
+            sim.witherSeconds[row] = 0.0f;
+            continue;
+        }
+        sim.witherSeconds[row] += 1.0f;
+        if (sim.witherSeconds[row] < plantDeathSeconds) continue;
+        const PlantShapeColumns& shape = plantStore.shape;
+        DetailedPlant seedling;
+        seedling.position = shape.position[row];
+        seedling.height = shape.height[row];
+        seedling.stemRadius = shape.stemRadius[row];
+        seedling.leafSize = shape.leafSize[row];
+        seedling.rootSpread = shape.rootSpread[row];
+        seedling.windPhase = shape.windPhase[row];
+        seedling.stemColor = shape.stemColor[row];
+        seedling.leafColor = glm::vec3(0.2f, 0.8f, shape.leafColorB[row]);
+        seedling.leafCount = shape.leafCount[row];
+        seedling.plantType = shape.plantType[row];
+        seedling.growthStage = 0.2f;
+        seedling.healthFactor = 0.8f;
+
+        plantStore.remove(plantStore.index.handle(row));
+        plantStore.add(seedling);
+        culled++;
+    }
+    if (culled == 0) return;
+    culledPlants += culled;
+    if (simEventLog) {
+        std::cout << "DEAD PLANTS culled: " << culled << " (replanted as seedlings, " << culledPlants << " total)" << std::endl;
+    }
+}
+
+void initializePestGrid() {
+    size_t infected = rebuildPestGrid();
+    pestGrid.sprayCursor = 0;
+    std::cout << "Pest spread grid: " << pestGrid.plants.cellsX << " x " << pestGrid.plants.cellsZ << " cells ("
+        << pestCellSize << "m) | " << infected << " initially infected plant(s)" << std::endl;
+}
+
+// 按当前植物行重建单元格分桶和感染位集（种植或清除植物后行号变化），返回感染株数
+size_t rebuildPestGrid() {
+    PestGrid& grid = pestGrid;
+    std::vector<glm::vec2> points(plantStore.size());
+    for (size_t i = 0; i < plantStore.size(); i++) {
+        points[i] = glm::vec2(plantStore.shape.position[i].x, plantStore.shape.position[i].z);
+    }
+    grid.plants.build(points, pestCellSize);
+    grid.rowWords = (grid.plants.cellsX + 63) / 64;
+    size_t words = (size_t)grid.rowWords * grid.plants.cellsZ;
+    grid.infectedCells.assign(words, 0);
+    grid.infectedCount.assign((size_t)grid.plants.cellsX * grid.plants.cellsZ, 0);
+    grid.susceptibility.assign((size_t)grid.plants.cellsX * grid.plants.cellsZ, 0.0f);
+    grid.susceptibilityStale = true;
+    grid.bucketsStale = false;
+
+    size_t infected = 0;
+    for (size_t i = 0; i < plantStore.size(); i++) {
+        if (!plantStore.sim.pestInfected[i]) continue;
+        int cell = grid.cellOf(points[i].x, points[i].y);
+        grid.infectedCount[cell]++;
+        grid.setBit(grid.infectedCells, grid.bitOf(cell));
+        infected++;
+    }
+    return infected;
+}
+
+// 病虫害湿度系数：空气湿度低于40%时难以传播，越潮湿越快
+inline float pestHumidityFactor(float humidity) {
+    return clamp((humidity - 40.0f) / 30.0f, 0.0f, 2.0f);
+}
+
+// 单元格易感度：格内未感染植株的湿度系数之和
+float pestCellSusceptibility(int cell) {
+    const PestGrid& grid = pestGrid;
+    float total = 0.0f;
+    for (int k = grid.plants.cellStart[cell]; k < grid.plants.cellStart[cell + 1]; k++) {
+        int row = grid.plants.items[k];
+        if (!plantStore.sim.pestInfected[row]) total += pestHumidityFactor(plantStore.sim.localHumidity[row]);
+    }
+    return total;
+}
+
+// 病虫害传播一步：按行把感染位集膨胀为暴露单元格，只在暴露单元格里按邻域感染压力抽样。
+// 每行一条随机流：沿行累加各格的感染风险（压力 × 易感度），超过指数分布阈值时才逐株定位
+// 被感染的植株并重新抽取阈值，等价于每株独立以 1-exp(-风险) 的概率感染。
+// 所有判定读取本步开始时的状态，新感染先记入各块累加器，最后按行顺序写入，结果与线程数无关
+void stepPestSpread(float dt) {
+    PestGrid& grid = pestGrid;
+    const int cellsX = grid.plants.cellsX;
+    const int cellsZ = grid.plants.cellsZ;
+    const int rowWords = grid.rowWords;
+    if (cellsX == 0 || cellsZ == 0) return;
+
+    // 小气候重新采样后按行并行重算各格易感度（感染和治愈只重算受影响的格）
+    if (grid.susceptibilityStale) {
+        grid.susceptibilityStale = false;
+        threadPool.parallelFor(cellsZ, pestRowChunkSize, [&](size_t begin, size_t end, int) {
+            for (int cell = (int)begin * cellsX; cell < (int)end * cellsX; cell++) {
+                grid.susceptibility[cell] = pestCellSusceptibility(cell);
+            }
+        });
+    }
+
+    // 邻域权重：同格最高，下风向的邻格受上风向感染格影响更大，对角按距离衰减
+    float weights[3][3];
+    for (int dz = -1; dz <= 1; dz++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            if (dx == 0 && dz == 0) {
+                weights[1][1] = 2.0f;
+                continue;
+            }
+            float length = std::sqrt((float)(dx * dx + dz * dz));
+            // 病原从邻格(dx, dz)吹向本格的方向为(-dx, -dz)
+            float downwind = -(windDirection.x * dx + windDirection.y * dz) / length;
+            weights[dz + 1][dx + 1] = std::max(0.1f, 1.0f + 0.5f * windStrength * downwind) / length;
+        }
+    }
+    const float spreadRate = 0.002f * dt;   // 每单位邻域感染压力每秒的感染风险
+
+    // 按行并行：感染位集膨胀（上下行按位或，再左右各移一位）得到暴露单元格，逐格累加风险
+    const uint64_t lastWordMask = (cellsX % 64) ? ((1ull << (cellsX % 64)) - 1) : ~0ull;
+    const unsigned char* infected = plantStore.sim.pestInfected.data();
+    const float* humidity = plantStore.sim.localHumidity.data();
+    prepareChunkAccumulators(cellsZ, pestRowChunkSize);
+    threadPool.parallelFor(cellsZ, pestRowChunkSize, [&](size_t begin, size_t end, int) {
+        TickAccumulator& acc = chunkAccumulators[begin / pestRowChunkSize];
+        for (size_t z = begin; z < end; z++) {
+            const uint64_t* up = z > 0 ? &grid.infectedCells[(z - 1) * rowWords] : nullptr;
+            const uint64_t* mid = &grid.infectedCells[z * rowWords];
+            const uint64_t* down = z + 1 < (size_t)cellsZ ? &grid.infectedCells[(z + 1) * rowWords] : nullptr;
+            auto column = [&](int w) {
+                return mid[w] | (up ? up[w] : 0) | (down ? down[w] : 0);
+            };
+            const uint32_t* countUp = z > 0 ? &grid.infectedCount[(z - 1) * cellsX] : nullptr;
+            const uint32_t* countMid = &grid.infectedCount[z * cellsX];
+            const uint32_t* countDown = z + 1 < (size_t)cellsZ ? &grid.infectedCount[(z + 1) * cellsX] : nullptr;
+            const uint32_t* countRows[3] = { countUp, countMid, countDown };
+
+            PhiloxStream rng(simulationSeed, RNG_PEST_SPREAD, (uint32_t)z, (uint64_t)simClock.totalSteps);
+            float threshold = -std::log(1.0f - rng.uniform(0.0f, 1.0f));
+            float hazard = 0.0f;
+            for (int w = 0; w < rowWords; w++) {
+                uint64_t v = column(w);
+                uint64_t fromLeft = w > 0 ? column(w - 1) >> 63 : 0;
+                uint64_t fromRight = w + 1 < rowWords ? column(w + 1) << 63 : 0;
+                uint64_t exposed = v | (v << 1) | fromLeft | (v >> 1) | fromRight;
+                if (w == rowWords - 1) exposed &= lastWordMask;
+
+                for (uint64_t bits = exposed; bits != 0; bits &= bits - 1) {
+                    int x = w * 64 + lowestSetBit64(bits);
+                    int cell = (int)z * cellsX + x;
+                    float susceptibility = grid.susceptibility[cell];
+                    if (susceptibility <= 0.0f) continue;
+
+                    float pressure = 0.0f;
+                    for (int r = 0; r < 3; r++) {
+                        if (!countRows[r]) continue;
+                        if (x > 0) pressure += weights[r][0] * countRows[r][x - 1];
+                        pressure += weights[r][1] * countRows[r][x];
+                        if (x + 1 < cellsX) pressure += weights[r][2] * countRows[r][x + 1];
+                    }
+                    float cellHazard = spreadRate * pressure;
+                    if (hazard + cellHazard * susceptibility < threshold) {
+                        hazard += cellHazard * susceptibility;
+                        continue;
+                    }
+
+                    // 阈值落在本格内：逐株定位（可能不止一株）
+                    for (int k = grid.plants.cellStart[cell]; k < grid.plants.cellStart[cell + 1]; k++) {
+                        int row = grid.plants.items[k];
+                        if (infected[row]) continue;
+                        hazard += cellHazard * pestHumidityFactor(humidity[row]);
+                        if (hazard >= threshold) {
+                            acc.newInfections.push_back((uint32_t)row);
+                            threshold = -std::log(1.0f - rng.uniform(0.0f, 1.0f));
+                            hazard = 0.0f;
+                        }
+                    }
+                }
+            }
+        }
+    });
+
+    // 按块顺序写入新感染，并重算受影响单元格的易感度
+    const TickAccumulator& total = reduceChunkAccumulators();
+    for (uint32_t row : total.newInfections) {
+        plantStore.sim.pestInfected[row] = 1;
+        const glm::vec3& position = plantStore.shape.position[row];
+        int cell = grid.cellOf(position.x, position.z);
+        grid.infectedCount[cell]++;
+        grid.setBit(grid.infectedCells, grid.bitOf(cell));
+        grid.susceptibility[cell] = pestCellSusceptibility(cell);
+    }
+    if (!total.newInfections.empty() && simEventLog) {
+        std::cout << "PEST SPREAD - " << total.newInfections.size() << " new plant infection(s)" << std::endl;
+    }
+}
+
+// 病虫防治喷洒：从轮转位置开始在感染位集中找下一个感染单元格，以其为中心喷洒圆形范围，
+// 范围内的感染植物治愈并恢复部分健康。每轮最多喷洒 sprayPasses 次
+void sprayPestFootprints() {
+    PestGrid& grid = pestGrid;
+    const int sprayPasses = 8;
+    const float sprayRadius = 4.0f;
+    const float cureHealth = 0.15f;
+    size_t totalBits = grid.infectedCells.size() * 64;
+    if (totalBits == 0) return;
+
+    for (int pass = 0; pass < sprayPasses; pass++) {
+        // 轮转查找下一个感染单元格（最多绕一圈）
+        size_t bit = grid.sprayCursor % totalBits;
+        size_t found = totalBits;
+        for (size_t scanned = 0; scanned <= grid.infectedCells.size(); scanned++) {
+            size_t word = bit >> 6;
+            uint64_t bits = grid.infectedCells[word] & (~0ull << (bit & 63));
+            if (bits != 0) {
+                found = word * 64 + lowestSetBit64(bits);
+                break;
+            }
+            bit = ((word + 1) % grid.infectedCells.size()) * 64;
+        }
+        if (found == totalBits) break;
+        grid.sprayCursor = found + 1;
+
+        int cellX = (int)(found % ((size_t)grid.rowWords * 64));
+        int cellZ = (int)(found / ((size_t)grid.rowWords * 64));
+        float centerX = grid.plants.originX + (cellX + 0.5f) * grid.plants.cellSize;
+        float centerZ = grid.plants.originZ + (cellZ + 0.5f) * grid.plants.cellSize;
+
+        int cured = 0;
+        grid.plants.forEachNear(centerX, centerZ, sprayRadius, [&](int row) {
+            const glm::vec3& position = plantStore.shape.position[row];
+            float dx = position.x - centerX, dz = position.z - centerZ;
+            if (dx * dx + dz * dz > sprayRadius * sprayRadius || !plantStore.sim.pestInfected[row]) return;
+            plantStore.sim.pestInfected[row] = 0;
+            plantStore.sim.healthFactor[row] = std::min(1.0f, plantStore.sim.healthFactor[row] + cureHealth);
+            int cell = grid.cellOf(position.x, position.z);
+            if (--grid.infectedCount[cell] == 0) {
+                grid.clearBit(grid.infectedCells, grid.bitOf(cell));
+            }
+            grid.susceptibility[cell] = pestCellSusceptibility(cell);
+            cured++;
+        });
+
+        if (simEventLog) {
+            std::cout << "PEST CONTROL sprayed " << sprayRadius << "m around (" << centerX << ", " << centerZ
+                << ") - " << cured << " plant(s) cured, Health +" << cureHealth << std::endl;
+        }
+    }
+}
+
+// 土壤场前进一步：按行块并行执行模板更新，写入后缓冲后交换
+void stepSoilGrid(float dt, float dayFactor) {
+    float cellArea = soilGrid.cellSize * soilGrid.cellSize;
+    SoilStepParams params;
+    params.dt = dt;
+    params.diffusion = std::min(0.2f, 0.02f * dt / cellArea);         // 水分横向扩散 0.02 m²/s（显式格式稳定上限）
+    params.nutrientDiffusion = std::min(0.2f, 0.005f * dt / cellArea);
+    params.rainfall = weather.precipitation * 8.0f * dt;
+    params.evaporation = (0.001f + 0.006f * dayFactor) * dt;            // 白天蒸发强
+    params.fieldCapacity = 60.0f;
+    params.drainFraction = std::min(1.0f, 0.2f * dt);
+    params.leachRate = 0.01f;
+    params.zoneWater = soilGrid.zoneWater.data();
+    params.zoneNitrogen = soilGrid.zoneNitrogen.data();
+
+    threadPool.parallelFor(soilGrid.height, soilRowChunkSize, [&](size_t begin, size_t end, int) {
+        for (size_t z = begin; z < end; z++) {
+            soilRowKernel(soilGrid, (int)z, params);
+        }
+    });
+    soilGrid.moisture.swap(soilGrid.moistureNext);
+    soilGrid.nitrogen.swap(soilGrid.nitrogenNext);
+}
+
+// 作物系数曲线（FAO-56 分段）：苗期恒定，0.2-0.5 线性升到中期值，0.8 之后线性降到末期值
+float cropCoefficient(const CropSpec& crop, float growth) {
+    if (growth < 0.2f) return crop.kcInitial;
+    if (growth < 0.5f) return crop.kcInitial + (crop.kcMid - crop.kcInitial) * (growth - 0.2f) / 0.3f;
+    if (growth < 0.8f) return crop.kcMid;
+    return crop.kcMid + (crop.kcEnd - crop.kcMid) * std::min((growth - 0.8f) / 0.2f, 1.0f);
+}
 
-    // 根据天气类型更新参数 - 修复雨天和暴风雨
-    switch (weather.weatherType) {
-    case 0: // 晴天
-        weather.cloudCoverage = 0.1f + sin(systemTime * 0.1f) * 0.1f;
-        weather.precipitation = 0.0f;
-        windStrength = 0.3f + sin(systemTime * 0.5f) * 0.2f;
-        weather.fogDensity = 0.005f;
-        weather.fogColor = glm::vec3(0.9f, 0.9f, 1.0f);
-        break;
-    case 1: // 多云
-        weather.cloudCoverage = 0.5f + sin(systemTime * 0.15f) * 0.2f;
-        weather.precipitation = 0.0f;
-        windStrength = 0.5f + sin(systemTime * 0.8f) * 0.3f;
-        weather.fogDensity = 0.01f;
-        weather.fogColor = glm::vec3(0.8f, 0.8f, 0.9f);
-        break;
-    case 2: // 雨天 - 修复
-        weather.cloudCoverage = clamp(0.8f + sin(systemTime * 0.2f) * 0.15f, 0.7f, 0.95f);
-        weather.precipitation = clamp(0.6f + sin(systemTime * 1.2f) * 0.3f, 0.4f, 0.9f);
-        windStrength = clamp(0.7f + sin(systemTime * 1.0f) * 0.4f, 0.5f, 1.1f);
-        weather.fogDensity = 0.025f;
-        weather.fogColor = glm::vec3(0.65f, 0.65f, 0.75f);
-        break;
-    case 3: // 暴风雨 - 修复
-        weather.cloudCoverage = clamp(0.95f + sin(systemTime * 0.3f) * 0.05f, 0.9f, 1.0f);
-        weather.precipitation = clamp(0.85f + sin(systemTime * 2.0f) * 0.15f, 0.7f, 1.0f);
-        windStrength = clamp(1.5f + sin(systemTime * 1.5f) * 0.8f, 1.0f, 2.3f);
-        weather.fogDensity = 0.04f;
-        weather.fogColor = glm::vec3(0.4f, 0.4f, 0.55f);
-        break;
+// 按传感器（灌溉区）建立预报输入输出，区域面积取土壤网格中归属本区的单元格，并做第一次刷新
+void initializeEtForecast() {
+    EtForecast& f = etForecast;
+    size_t zones = sensorStore.size();
+    f.temperature.assign(zones, 22.0f);
+    f.humidity.assign(zones, 60.0f);
+    f.lightScale.assign(zones, 1.0f);
+    f.cropCoefficient.assign(zones, 0.0f);
+    f.area.assign(zones, 0.0f);
+    f.etNow.assign(zones, 0.0f);
+    f.demand24.assign(zones, 0.0f);
+    f.demand48.assign(zones, 0.0f);
+    f.demand72.assign(zones, 0.0f);
+    float cellArea = soilGrid.cellSize * soilGrid.cellSize;
+    for (uint32_t zone : soilGrid.zone) {
+        f.area[zone] += cellArea;
     }
+    refreshEtForecast();
+    std::cout << "Evapotranspiration forecast: " << zones << " zones x " << etForecastHours << " h"
+        << " | 24h demand " << std::fixed << std::setprecision(1) << f.totalDemand24 / 1000.0 << " m3" << std::endl;
+}
 
-    // 昼夜循环 (90秒一个周期)
-    dayNightCycle += deltaTime / 90.0f;
-    if (dayNightCycle > 1.0f) dayNightCycle -= 1.0f;
-
-    // 动态风效果
-    windDirection.x = cos(systemTime * 0.3f) + sin(systemTime * 0.8f) * 0.5f;
-    windDirection.y = sin(systemTime * 0.4f) + cos(systemTime * 1.1f) * 0.4f;
-    windDirection = glm::normalize(windDirection);
-
-    // 更新传感器数据 (每2秒更频繁更新)
-    static float lastSensorUpdate = 0.0f;
-    if (systemTime - lastSensorUpdate > 2.0f) {
-        lastSensorUpdate = systemTime;
+// 蒸散预报用的指数函数：范围归约到 [-ln2/2, ln2/2] 后用6阶多项式，再乘 2^n。
+// SIMD版本按完全相同的运算顺序计算（四舍五入到偶数取整），结果逐位一致
+inline float etExp(float x) {
+    x = std::min(std::max(x, -80.0f), 80.0f);
+    float n = std::nearbyint(x * 1.44269504f);
+    float r = (x - n * 0.693145752f) - n * 1.42860677e-6f;
+    float p = 1.38888889e-3f;
+    p = p * r + 8.33333333e-3f;
+    p = p * r + 4.16666667e-2f;
+    p = p * r + 1.66666667e-1f;
+    p = p * r + 0.5f;
+    p = p * r + 1.0f;
+    p = p * r + 1.0f;
+    int32_t bits = ((int32_t)n + 127) << 23;
+    float scale;
+    memcpy(&scale, &bits, sizeof(scale));
+    return p * scale;
+}
 
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_real_distribution<float> variation(-1.0f, 1.0f);
+// Penman-Monteith 常数：干湿表常数 γ（kPa/°C，海拔约100米）、逐小时 Stefan-Boltzmann 常数（MJ/m²/h/K⁴）
+const float etPsychrometric = 0.067f;
+const float etStefanBoltzmann = 2.043e-10f;
+
+// 蒸散预报内核 - 标量版本（也是SIMD版本的尾部处理和参考实现）。
+// 预报气温按昼夜系数变化，实际水汽压保持当前值（日内基本不变），湿度随气温自然变化
+void forecastEtZonesScalar(EtForecast& f, size_t begin, size_t end) {
+    const float u2 = f.windSpeed;
+    const float gammaWind = etPsychrometric * (1.0f + 0.34f * u2);
+    for (size_t z = begin; z < end; z++) {
+        float t0 = f.temperature[z];
+        float ea = 0.6108f * etExp(17.27f * t0 / (t0 + 237.3f)) * (f.humidity[z] * 0.01f);
+        float longwave = etStefanBoltzmann * (0.34f - 0.14f * std::sqrt(ea)) * f.cloudFactor;
+        float light = f.lightScale[z];
+        float kc = f.cropCoefficient[z];
+        float total = 0.0f;
+        for (int h = 0; h < etForecastHours; h++) {
+            float t = t0 + f.temperatureSwing * (f.dayFactor[h] - f.dayFactorNow);
+            float denom = t + 237.3f;
+            float es = 0.6108f * etExp(17.27f * t / denom);
+            float delta = 4098.0f * es / (denom * denom);
+            float tk = t + 273.16f;
+            float tk2 = tk * tk;
+            float rn = 0.77f * (light * f.radiation[h]) - longwave * (tk2 * tk2);
+            float soilHeat = f.soilHeatFraction[h] * rn;
+            float aero = etPsychrometric * (37.0f / tk) * u2 * (es - ea);
+            float eto = std::max((0.408f * delta * (rn - soilHeat) + aero) / (delta + gammaWind), 0.0f);
+            float etc = kc * eto;
+            total += etc;
+            if (h == 0) f.etNow[z] = etc;
+            if (h == 23) f.demand24[z] = total;
+            if (h == 47) f.demand48[z] = total;
+        }
+        f.demand72[z] = total;
+    }
+}
 
-        float dayFactor = (sin(dayNightCycle * 2.0f * 3.14159f) + 1.0f) * 0.5f;
+#ifdef FARM_X86
+// 与 etExp 相同运算顺序的4通道版本
+inline __m128 etExpSSE2(__m128 x) {
+    x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-80.0f)), _mm_set1_ps(80.0f));
+    __m128i n = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.44269504f)));
+    __m128 nf = _mm_cvtepi32_ps(n);
+    __m128 r = _mm_sub_ps(_mm_sub_ps(x, _mm_mul_ps(nf, _mm_set1_ps(0.693145752f))),
+        _mm_mul_ps(nf, _mm_set1_ps(1.42860677e-6f)));
+    __m128 p = _mm_set1_ps(1.38888889e-3f);
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(8.33333333e-3f));
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(4.16666667e-2f));
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(1.66666667e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(0.5f));
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(1.0f));
+    p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(1.0f));
+    __m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23));
+    return _mm_mul_ps(p, scale);
+}
 
-        for (auto& sensor : sensors) {
-            // 温度随昼夜和天气变化
-            sensor.temperature += variation(gen) * 0.8f;
-            sensor.temperature += (dayFactor - 0.5f) * 3.0f; // 昼夜温差
+// 蒸散预报内核 - SSE2版本，每条指令处理4个区域
+void forecastEtZonesSSE2(EtForecast& f, size_t begin, size_t end) {
+    const float u2 = f.windSpeed;
+    const __m128 windSpeed = _mm_set1_ps(u2);
+    const __m128 gammaWind = _mm_set1_ps(etPsychrometric * (1.0f + 0.34f * u2));
+    const __m128 gamma = _mm_set1_ps(etPsychrometric);
+    const __m128 magnusA = _mm_set1_ps(17.27f);
+    const __m128 magnusB = _mm_set1_ps(237.3f);
+    const __m128 es0 = _mm_set1_ps(0.6108f);
+    const __m128 slope = _mm_set1_ps(4098.0f);
+    const __m128 kelvin = _mm_set1_ps(273.16f);
+    const __m128 netShortwave = _mm_set1_ps(0.77f);
+    const __m128 radiationToEvaporation = _mm_set1_ps(0.408f);
+    const __m128 aeroCoefficient = _mm_set1_ps(37.0f);
+    const __m128 swing = _mm_set1_ps(f.temperatureSwing);
+    const __m128 dayFactorNow = _mm_set1_ps(f.dayFactorNow);
+    const __m128 zero = _mm_setzero_ps();
+
+    size_t z = begin;
+    for (; z + 4 <= end; z += 4) {
+        __m128 t0 = _mm_loadu_ps(&f.temperature[z]);
+        __m128 ea = _mm_mul_ps(_mm_mul_ps(es0, etExpSSE2(_mm_div_ps(_mm_mul_ps(magnusA, t0), _mm_add_ps(t0, magnusB)))),
+            _mm_mul_ps(_mm_loadu_ps(&f.humidity[z]), _mm_set1_ps(0.01f)));
+        __m128 longwave = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(etStefanBoltzmann),
+            _mm_sub_ps(_mm_set1_ps(0.34f), _mm_mul_ps(_mm_set1_ps(0.14f), _mm_sqrt_ps(ea)))), _mm_set1_ps(f.cloudFactor));
+        __m128 light = _mm_loadu_ps(&f.lightScale[z]);
+        __m128 kc = _mm_loadu_ps(&f.cropCoefficient[z]);
+        __m128 total = zero;
+        for (int h = 0; h < etForecastHours; h++) {
+            __m128 t = _mm_add_ps(t0, _mm_mul_ps(swing, _mm_sub_ps(_mm_set1_ps(f.dayFactor[h]), dayFactorNow)));
+            __m128 denom = _mm_add_ps(t, magnusB);
+            __m128 es = _mm_mul_ps(es0, etExpSSE2(_mm_div_ps(_mm_mul_ps(magnusA, t), denom)));
+            __m128 delta = _mm_div_ps(_mm_mul_ps(slope, es), _mm_mul_ps(denom, denom));
+            __m128 tk = _mm_add_ps(t, kelvin);
+            __m128 tk2 = _mm_mul_ps(tk, tk);
+            __m128 rn = _mm_sub_ps(_mm_mul_ps(netShortwave, _mm_mul_ps(light, _mm_set1_ps(f.radiation[h]))),
+                _mm_mul_ps(longwave, _mm_mul_ps(tk2, tk2)));
+            __m128 soilHeat = _mm_mul_ps(_mm_set1_ps(f.soilHeatFraction[h]), rn);
+            __m128 aero = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(gamma, _mm_div_ps(aeroCoefficient, tk)), windSpeed),
+                _mm_sub_ps(es, ea));
+            __m128 eto = _mm_max_ps(_mm_div_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(radiationToEvaporation, delta),
+                _mm_sub_ps(rn, soilHeat)), aero), _mm_add_ps(delta, gammaWind)), zero);
+            __m128 etc = _mm_mul_ps(kc, eto);
+            total = _mm_add_ps(total, etc);
+            if (h == 0) _mm_storeu_ps(&f.etNow[z], etc);
+            if (h == 23) _mm_storeu_ps(&f.demand24[z], total);
+            if (h == 47) _mm_storeu_ps(&f.demand48[z], total);
+        }
+        _mm_storeu_ps(&f.demand72[z], total);
+    }
 
-            // 天气影响
-            if (weather.weatherType >= 2) { // 雨天/暴风雨
-                sensor.temperature -= 2.0f; // 降温
-                sensor.humidity += 15.0f;   // 增湿
-                sensor.soilMoisture += 10.0f; // 土壤湿润
-            }
+    forecastEtZonesScalar(f, z, end);
+}
 
-            sensor.temperature = clamp(sensor.temperature, 12.0f, 40.0f);
+// 与 etExp 相同运算顺序的8通道版本
+FARM_TARGET_AVX2
+inline __m256 etExpAVX2(__m256 x) {
+    x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-80.0f)), _mm256_set1_ps(80.0f));
+    __m256i n = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504f)));
+    __m256 nf = _mm256_cvtepi32_ps(n);
+    __m256 r = _mm256_sub_ps(_mm256_sub_ps(x, _mm256_mul_ps(nf, _mm256_set1_ps(0.693145752f))),
+        _mm256_mul_ps(nf, _mm256_set1_ps(1.42860677e-6f)));
+    __m256 p = _mm256_set1_ps(1.38888889e-3f);
+    p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(8.33333333e-3f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(4.16666667e-2f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(1.66666667e-1f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(0.5f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(1.0f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(1.0f));
+    __m256 scale = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(n, _mm256_set1_epi32(127)), 23));
+    return _mm256_mul_ps(p, scale);
+}
 
-            // 湿度变化
-            sensor.humidity += variation(gen) * 2.0f;
-            sensor.humidity = clamp(sensor.humidity, 25.0f, 95.0f);
+// 蒸散预报内核 - AVX2版本，每条指令处理8个区域
+FARM_TARGET_AVX2
+void forecastEtZonesAVX2(EtForecast& f, size_t begin, size_t end) {
+    const float u2 = f.windSpeed;
+    const __m256 windSpeed = _mm256_set1_ps(u2);
+    const __m256 gammaWind = _mm256_set1_ps(etPsychrometric * (1.0f + 0.34f * u2));
+    const __m256 gamma = _mm256_set1_ps(etPsychrometric);
+    const __m256 magnusA = _mm256_set1_ps(17.27f);
+    const __m256 magnusB = _mm256_set1_ps(237.3f);
+    const __m256 es0 = _mm256_set1_ps(0.6108f);
+    const __m256 slope = _mm256_set1_ps(4098.0f);
+    const __m256 kelvin = _mm256_set1_ps(273.16f);
+    const __m256 netShortwave = _mm256_set1_ps(0.77f);
+    const __m256 radiationToEvaporation = _mm256_set1_ps(0.408f);
+    const __m256 aeroCoefficient = _mm256_set1_ps(37.0f);
+    const __m256 swing = _mm256_set1_ps(f.temperatureSwing);
+    const __m256 dayFactorNow = _mm256_set1_ps(f.dayFactorNow);
+    const __m256 zero = _mm256_setzero_ps();
+
+    size_t z = begin;
+    for (; z + 8 <= end; z += 8) {
+        __m256 t0 = _mm256_loadu_ps(&f.temperature[z]);
+        __m256 ea = _mm256_mul_ps(_mm256_mul_ps(es0, etExpAVX2(_mm256_div_ps(_mm256_mul_ps(magnusA, t0),
+            _mm256_add_ps(t0, magnusB)))), _mm256_mul_ps(_mm256_loadu_ps(&f.humidity[z]), _mm256_set1_ps(0.01f)));
+        __m256 longwave = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(etStefanBoltzmann),
+            _mm256_sub_ps(_mm256_set1_ps(0.34f), _mm256_mul_ps(_mm256_set1_ps(0.14f), _mm256_sqrt_ps(ea)))),
+            _mm256_set1_ps(f.cloudFactor));
+        __m256 light = _mm256_loadu_ps(&f.lightScale[z]);
+        __m256 kc = _mm256_loadu_ps(&f.cropCoefficient[z]);
+        __m256 total = zero;
+        for (int h = 0; h < etForecastHours; h++) {
+            __m256 t = _mm256_add_ps(t0, _mm256_mul_ps(swing, _mm256_sub_ps(_mm256_set1_ps(f.dayFactor[h]), dayFactorNow)));
+            __m256 denom = _mm256_add_ps(t, magnusB);
+            __m256 es = _mm256_mul_ps(es0, etExpAVX2(_mm256_div_ps(_mm256_mul_ps(magnusA, t), denom)));
+            __m256 delta = _mm256_div_ps(_mm256_mul_ps(slope, es), _mm256_mul_ps(denom, denom));
+            __m256 tk = _mm256_add_ps(t, kelvin);
+            __m256 tk2 = _mm256_mul_ps(tk, tk);
+            __m256 rn = _mm256_sub_ps(_mm256_mul_ps(netShortwave, _mm256_mul_ps(light, _mm256_set1_ps(f.radiation[h]))),
+                _mm256_mul_ps(longwave, _mm256_mul_ps(tk2, tk2)));
+            __m256 soilHeat = _mm256_mul_ps(_mm256_set1_ps(f.soilHeatFraction[h]), rn);
+            __m256 aero = _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(gamma, _mm256_div_ps(aeroCoefficient, tk)), windSpeed),
+                _mm256_sub_ps(es, ea));
+            __m256 eto = _mm256_max_ps(_mm256_div_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(radiationToEvaporation, delta),
+                _mm256_sub_ps(rn, soilHeat)), aero), _mm256_add_ps(delta, gammaWind)), zero);
+            __m256 etc = _mm256_mul_ps(kc, eto);
+            total = _mm256_add_ps(total, etc);
+            if (h == 0) _mm256_storeu_ps(&f.etNow[z], etc);
+            if (h == 23) _mm256_storeu_ps(&f.demand24[z], total);
+            if (h == 47) _mm256_storeu_ps(&f.demand48[z], total);
+        }
+        _mm256_storeu_ps(&f.demand72[z], total);
+    }
 
-            // 土壤湿度 (考虑灌溉和蒸发)
-            sensor.soilMoisture += variation(gen) * 1.5f;
-            sensor.soilMoisture -= dayFactor * 0.5f; // 白天蒸发
-
-            // 超级明显的灌溉系统效果
-            bool needsIrrigation = sensor.soilMoisture < 40.0f;
-            if (farmStatus.autoIrrigation && needsIrrigation) {
-                float irrigationEffect = 8.0f + farmStatus.irrigationIntensity * 5.0f;
-                sensor.soilMoisture += irrigationEffect;
-                farmStatus.waterUsage += 0.2f * farmStatus.irrigationIntensity;
-                farmStatus.irrigationActive = true;
-                farmStatus.activeNozzles++;
-
-                // 水箱水位下降
-                farmStatus.waterTankLevel -= 0.1f * farmStatus.irrigationIntensity;
-                farmStatus.waterTankLevel = clamp(farmStatus.waterTankLevel, 10.0f, 100.0f);
-
-                std::cout << "IRRIGATION SYSTEM ACTIVE - Sensor " << (&sensor - &sensors[0])
-                    << " | Soil +" << irrigationEffect << "% | Water Tank: "
-                    << (int)farmStatus.waterTankLevel << "% | Pressure: "
-                    << (int)farmStatus.waterPressure << " PSI" << std::endl;
-            }
-
-            // 施肥系统超明显效果
-            if (farmStatus.autoFertilizer && farmStatus.fertilizerLevel > 10.0f) {
-                bool needsFertilizer = sensor.nitrogenLevel < 60.0f ||
-                    sensor.phosphorusLevel < 60.0f ||
-                    sensor.potassiumLevel < 60.0f;
-                if (needsFertilizer) {
-                    sensor.nitrogenLevel += 8.0f;    // 大幅增加
-                    sensor.phosphorusLevel += 6.0f;
-                    sensor.potassiumLevel += 7.0f;
-                    farmStatus.fertilizerLevel -= 0.5f;
-                    std::cout << "FERTILIZER APPLIED at sensor " << (&sensor - &sensors[0])
-                        << " - NPK levels boosted!" << std::endl;
-                }
-            }
+    forecastEtZonesScalar(f, z, end);
+}
+#else
+// 非x86平台只有标量内核
+void forecastEtZonesSSE2(EtForecast& f, size_t begin, size_t end) {
+    forecastEtZonesScalar(f, begin, end);
+}
 
-            // 气候控制超明显效果
-            if (farmStatus.climateControl) {
-                bool climateAdjusted = false;
-                if (sensor.temperature > 28.0f) {
-                    sensor.temperature -= 3.0f;  // 大幅调整
-                    climateAdjusted = true;
-                }
-                if (sensor.temperature < 20.0f) {
-                    sensor.temperature += 3.0f;
-                    climateAdjusted = true;
-                }
-                if (sensor.humidity < 55.0f) {
-                    sensor.humidity += 5.0f;
-                    climateAdjusted = true;
-                }
-                if (sensor.humidity > 75.0f) {
-                    sensor.humidity -= 5.0f;
-                    climateAdjusted = true;
-                }
-                if (climateAdjusted) {
-                    std::cout << "CLIMATE CONTROL adjusted sensor " << (&sensor - &sensors[0])
-                        << " - Temperature: " << sensor.temperature
-                        << "C, Humidity: " << sensor.humidity << "%" << std::endl;
-                }
-            }
+void forecastEtZonesAVX2(EtForecast& f, size_t begin, size_t end) {
+    forecastEtZonesScalar(f, begin, end);
+}
+#endif
 
-            sensor.soilMoisture = clamp(sensor.soilMoisture, 15.0f, 85.0f);
+// 蒸散预报内核与植物内核使用同一指令集级别
+void selectEtKernel(PlantKernelLevel level) {
+    const char* names[] = { "Scalar", "SSE2 (4 zones/op)", "AVX2 (8 zones/op)" };
+    switch (level) {
+    case PLANT_KERNEL_AVX2: etForecastKernel = forecastEtZonesAVX2; break;
+    case PLANT_KERNEL_SSE2: etForecastKernel = forecastEtZonesSSE2; break;
+    default: etForecastKernel = forecastEtZonesScalar; break;
+    }
+    std::cout << "Evapotranspiration kernel: " << names[level] << std::endl;
+}
 
-            // pH值缓慢变化
-            sensor.pH += variation(gen) * 0.1f;
-            sensor.pH = clamp(sensor.pH, 5.0f, 8.5f);
+// 刷新需水预报：逐小时共享输入 -> 各区平均作物系数 -> 按区域块并行收集传感器读数并运行内核
+void refreshEtForecast() {
+    auto start = std::chrono::steady_clock::now();
+    EtForecast& f = etForecast;
+    const float hourLength = 1.0f / 24.0f;
+
+    // 逐小时共享输入：太阳高度按昼夜周期，云量按当前天气持续（Angstrom 公式 Rs/Rso = (0.25 + 0.5·日照比) / 0.75）
+    float sunshineRatio = (0.25f + 0.5f * (1.0f - weather.cloudCoverage)) / 0.75f;
+    f.dayFactorNow = (std::sin(dayNightCycle * 2.0f * 3.14159f) + 1.0f) * 0.5f;
+    f.windSpeed = weather.windSpeed;
+    f.cloudFactor = 1.35f * sunshineRatio - 0.35f;
+    for (int h = 0; h < etForecastHours; h++) {
+        float sun = std::sin((dayNightCycle + (h + 0.5f) * hourLength) * 2.0f * 3.14159f);
+        f.dayFactor[h] = (sun + 1.0f) * 0.5f;
+        f.radiation[h] = 3.0f * std::max(sun, 0.0f) * sunshineRatio;   // 晴空正午约 3 MJ/m²/h
+        f.soilHeatFraction[h] = sun > 0.0f ? 0.1f : 0.5f;
+    }
 
-            // 营养元素变化
-            sensor.nitrogenLevel += variation(gen) * 2.0f;
-            sensor.phosphorusLevel += variation(gen) * 1.5f;
-            sensor.potassiumLevel += variation(gen) * 2.0f;
+    // 各区平均作物系数（植物按最近传感器归区，按作物批次取系数曲线）；没有植物的区按裸土计
+    if (plantBatchesStale) rebuildPlantBatches();
+    std::vector<float> kcSum(f.zones(), 0.0f);
+    std::vector<int> kcCount(f.zones(), 0);
+    for (const PlantBatch& batch : plantBatches) {
+        const CropSpec& crop = cropTable[batch.crop];
+        for (size_t i = batch.begin; i < batch.end; i++) {
+            uint32_t zone = plantStore.site.sensorWeights[i].sensor[0];
+            kcSum[zone] += cropCoefficient(crop, plantStore.sim.growthStage[i]);
+            kcCount[zone]++;
+        }
+    }
 
-            sensor.nitrogenLevel = clamp(sensor.nitrogenLevel, 10.0f, 90.0f);
-            sensor.phosphorusLevel = clamp(sensor.phosphorusLevel, 10.0f, 90.0f);
-            sensor.potassiumLevel = clamp(sensor.potassiumLevel, 10.0f, 90.0f);
+    threadPool.parallelFor(f.zones(), etZoneChunkSize, [&](size_t begin, size_t end, int) {
+        for (size_t z = begin; z < end; z++) {
+            const SensorReadings& sensor = sensorStore.readings[z];
+            f.temperature[z] = sensor.temperature;
+            f.humidity[z] = sensor.humidity;
+            // 传感器光照 = 200 + 昼夜系数 × 1000，白天用实测与曲线之比修正区域辐射（遮阴、局部云影）
+            f.lightScale[z] = f.dayFactorNow > 0.2f ?
+                clamp((sensor.lightLevel - 200.0f) / (1000.0f * f.dayFactorNow), 0.5f, 1.5f) : 1.0f;
+            f.cropCoefficient[z] = kcCount[z] > 0 ? kcSum[z] / kcCount[z] : 0.3f;
+        }
+        etForecastKernel(f, begin, end);
+    });
+
+    f.totalDemand24 = f.totalDemand48 = f.totalDemand72 = 0.0;
+    for (size_t z = 0; z < f.zones(); z++) {
+        f.totalDemand24 += (double)f.demand24[z] * f.area[z];
+        f.totalDemand48 += (double)f.demand48[z] * f.area[z];
+        f.totalDemand72 += (double)f.demand72[z] * f.area[z];
+    }
+    f.refreshCount++;
+    f.refreshMillis += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
 
-            // 光照强度
-            sensor.lightLevel = 200.0f + dayFactor * 1000.0f + variation(gen) * 100.0f;
-            sensor.lightLevel = clamp(sensor.lightLevel, 100.0f, 1400.0f);
+    if (simEventLog) {
+        std::cout << "ET FORECAST - farm water demand 24h: " << std::fixed << std::setprecision(1)
+            << f.totalDemand24 / 1000.0 << " m3, 72h: " << f.totalDemand72 / 1000.0 << " m3" << std::endl;
+    }
+}
 
-            // 更新7个可视化数据柱
-            sensor.dataHeight[0] = (sensor.temperature - 10.0f) / 35.0f * 2.5f;
-            sensor.dataHeight[1] = sensor.humidity / 100.0f * 2.5f;
-            sensor.dataHeight[2] = sensor.soilMoisture / 100.0f * 2.5f;
-            sensor.dataHeight[3] = (sensor.pH - 4.5f) / 4.5f * 2.5f;
-            sensor.dataHeight[4] = sensor.nitrogenLevel / 100.0f * 2.5f;
-            sensor.dataHeight[5] = sensor.phosphorusLevel / 100.0f * 2.5f;
-            sensor.dataHeight[6] = sensor.potassiumLevel / 100.0f * 2.5f;
+// 按灌溉区建立阀门、支管和供水系统参数：支管按传感器网格列划分，可同时开启一半阀门；
+// 水泵额定流量为全部阀门流量的35%，水箱可按压力限制流量供水30秒，水源补水为泵流量的4%
+void initializeIrrigationSchedule() {
+    IrrigationSchedule& s = irrigationSchedule;
+    size_t valves = sensorStore.size();
+    float litresPerPercent = rootZoneDepthMm / 100.0f;   // 每平方米根区含水量升高1%需要的水量（升）
+    float nominalRate = (8.0f + 3.0f * 5.0f) * 0.5f;     // 中等强度下的喷灌强度
+    s.branchCount = std::max(1, (int)std::round(farmConfig.fieldHalfExtent * 2.0f / farmConfig.sensorPitch));
+    s.flowPerRate.resize(valves);
+    s.flow.assign(valves, 0.0f);
+    s.branch.resize(valves);
+    s.urgency.assign(valves, 0.0f);
+    s.needSlots.assign(valves, 0);
+    s.allocatedSlots.assign(valves, 0);
+    s.windowStart.assign(valves, 0);
+    s.windowLength.assign(valves, 0);
+    std::vector<float> branchFlow(s.branchCount, 0.0f), largestValve(s.branchCount, 0.0f);
+    float totalFlow = 0.0f, maxValve = 0.0f;
+    for (size_t v = 0; v < valves; v++) {
+        // 没有喷头的区（喷头间距比传感器间距粗时）水送不到，按无可灌溉面积处理，不参与排程
+        s.flowPerRate[v] = pipeNetwork.zoneNozzles[v] > 0 ? etForecast.area[v] * litresPerPercent : 0.0f;
+        int column = (int)std::floor((sensorStore.position[v].x + farmConfig.fieldHalfExtent) / farmConfig.sensorPitch);
+        s.branch[v] = (uint32_t)SpatialHashGrid::clampCell(column, s.branchCount);
+        float q = s.flowPerRate[v] * nominalRate;
+        branchFlow[s.branch[v]] += q;
+        largestValve[s.branch[v]] = std::max(largestValve[s.branch[v]], q);
+        totalFlow += q;
+        maxValve = std::max(maxValve, q);
+    }
+    // 支管上限按最大强度计，保证任一阀门都能单独开启
+    float maxScale = (8.0f + 5.0f * 5.0f) / (8.0f + 3.0f * 5.0f);
+    s.branchCapacity.resize(s.branchCount);
+    for (int b = 0; b < s.branchCount; b++) {
+        s.branchCapacity[b] = std::max(0.5f * branchFlow[b], largestValve[b] * maxScale);
+    }
+    // 泵特性曲线：压力 = 95 - 65·(Q/Q泵)² PSI，喷头最低工作压力 40 PSI
+    s.pumpCapacity = std::max(0.35f * totalFlow, maxValve * maxScale / 0.9f);
+    s.pressureLimitedFlow = s.pumpCapacity * std::sqrt((95.0f - 40.0f) / 65.0f);
+    s.tankCapacity = s.pressureLimitedFlow * 30.0f;
+    s.tankRefill = 0.04f * s.pumpCapacity;
+    s.slotFlow.assign(irrigationSlots, 0.0f);
+    s.branchSlotFlow.assign((size_t)s.branchCount * irrigationSlots, 0.0f);
+    s.queue.reserve(valves);
+    s.dirty = true;
+    std::cout << "Irrigation schedule: " << valves << " valves on " << s.branchCount << " branches"
+        << " | pump " << std::fixed << std::setprecision(1) << s.pumpCapacity / 1000.0f << " m3/s"
+        << " | tank " << s.tankCapacity / 1000.0f << " m3" << std::endl;
+}
 
-            // 状态指示灯逻辑
-            bool tempAlert = (sensor.temperature > 35.0f || sensor.temperature < 15.0f);
-            bool humidAlert = (sensor.humidity < 30.0f);
-            bool soilAlert = (sensor.soilMoisture < 25.0f);
-            bool pHAlert = (sensor.pH < 5.8f || sensor.pH > 7.8f);
-            bool nutrientAlert = (sensor.nitrogenLevel < 30.0f || sensor.phosphorusLevel < 20.0f);
+// 阀门在槽位 t 开启是否仍满足该槽位的总流量和支管流量上限
+bool fitIrrigationSlot(const IrrigationSchedule& s, uint32_t valve, int t, float maxFlow) {
+    float q = s.flow[valve];
+    return s.slotFlow[t] + q <= maxFlow &&
+        s.branchSlotFlow[(size_t)s.branch[valve] * irrigationSlots + t] + q <= s.branchCapacity[s.branch[valve]];
+}
 
-            if (tempAlert || humidAlert || soilAlert || pHAlert || nutrientAlert) {
-                sensor.statusColor = glm::vec3(1.0f, 0.2f, 0.2f); // 红色警告
-            }
-            else if (sensor.temperature > 32.0f || sensor.humidity < 40.0f || sensor.soilMoisture < 35.0f) {
-                sensor.statusColor = glm::vec3(1.0f, 0.8f, 0.0f); // 黄色注意
-            }
-            else {
-                sensor.statusColor = glm::vec3(0.2f, 1.0f, 0.3f); // 绿色正常
-            }
-        }
-    }
-
-    // 更新植物生长和健康度
-    for (auto& plant : plants) {
-        // 天气对植物的影响
-        float weatherEffect = 1.0f;
-        if (weather.weatherType == 0) weatherEffect = 1.01f;      // 晴天有利
-        else if (weather.weatherType == 1) weatherEffect = 1.005f; // 多云中性
-        else if (weather.weatherType == 2) weatherEffect = 1.002f; // 雨天适度有利
-        else if (weather.weatherType == 3) weatherEffect = 0.995f; // 暴风雨不利
-
-        // 超级明显的农场系统对植物的影响
-        if (farmStatus.pestControl && plant.isPestInfected) {
-            plant.isPestInfected = false;
-            plant.healthFactor = std::min(1.0f, plant.healthFactor + 0.15f); // 大幅提升
-            std::cout << "PEST CONTROL cured plant at (" << plant.position.x
-                << ", " << plant.position.z << ") - Health +" << 0.15f << std::endl;
-        }
-
-        // 施肥系统对植物的超明显影响
-        if (farmStatus.autoFertilizer && farmStatus.fertilizerLevel > 20.0f) {
-            float oldHealth = plant.healthFactor;
-            plant.healthFactor = std::min(1.0f, plant.healthFactor + 0.005f); // 增加效果
-            plant.growthStage = std::min(1.0f, plant.growthStage + 0.002f);   // 加速生长
-            if (plant.healthFactor > oldHealth) {
-                static int fertilizerCount = 0;
-                if (++fertilizerCount % 50 == 0) { // 每50次输出一次避免刷屏
-                    std::cout << "FERTILIZER boosting plant growth - "
-                        << fertilizerCount << " plants enhanced!" << std::endl;
-                }
-            }
+// 为阀门安排至多 slots 个连续槽位：已有窗口先向后、再向前延长；没有窗口时取最早一段足够长的
+// 可用槽位，都不够长则取最长的一段（截断）。跳跃扫描：槽位放不下时从下一个槽位重新计数
+void placeIrrigationWindow(IrrigationSchedule& s, uint32_t valve, int slots, float maxFlow) {
+    int start = s.windowStart[valve];
+    int length = s.windowLength[valve];
+    int added = 0, addedStart = 0;
+    if (length > 0) {
+        int end = start + length;
+        while (length + added < slots && end + added < irrigationSlots && fitIrrigationSlot(s, valve, end + added, maxFlow)) added++;
+        addedStart = end;
+        int before = 0;
+        while (length + added + before < slots && start - before > 0 && fitIrrigationSlot(s, valve, start - before - 1, maxFlow)) before++;
+        for (int t = start - before; t < start; t++) {
+            s.slotFlow[t] += s.flow[valve];
+            s.branchSlotFlow[(size_t)s.branch[valve] * irrigationSlots + t] += s.flow[valve];
         }
-
-        // 夜间照明超明显延长生长时间
-        if (farmStatus.nightLighting) {
-            weatherEffect *= 1.08f; // 大幅生长奖励
-            plant.growthStage += deltaTime * 0.001f; // 额外夜间生长
-            static int lightingBonusCount = 0;
-            if (++lightingBonusCount % 100 == 0) {
-                std::cout << "NIGHT LIGHTING providing 24/7 growth boost - "
-                    << lightingBonusCount << " growth cycles enhanced!" << std::endl;
+        start -= before;
+        length += before;
+    }
+    else {
+        int bestStart = 0, bestLength = 0, runStart = 0;
+        for (int t = 0; t < irrigationSlots && bestLength < slots; t++) {
+            if (!fitIrrigationSlot(s, valve, t, maxFlow)) {
+                runStart = t + 1;
+                continue;
+            }
+            if (t + 1 - runStart > bestLength) {
+                bestStart = runStart;
+                bestLength = t + 1 - runStart;
             }
         }
+        start = bestStart;
+        added = std::min(bestLength, slots);
+        addedStart = bestStart;
+    }
+    for (int t = addedStart; t < addedStart + added; t++) {
+        s.slotFlow[t] += s.flow[valve];
+        s.branchSlotFlow[(size_t)s.branch[valve] * irrigationSlots + t] += s.flow[valve];
+    }
+    s.windowStart[valve] = (uint8_t)start;
+    s.windowLength[valve] = (uint8_t)(length + added);
+}
 
-        // 自动收获成熟植物 - 更明显的效果
-        if (farmStatus.autoHarvest && plant.growthStage > 0.9f && plant.healthFactor > 0.75f) {
-            farmStatus.harvestYield += 0.5f; // 增加收获量
-            plant.growthStage = 0.2f; // 重新种植
-            plant.healthFactor = 0.8f; // 新植物起始健康度
-            std::cout << "AUTO HARVEST collected mature plant! Total yield: "
-                << std::fixed << std::setprecision(1) << farmStatus.harvestYield << " kg" << std::endl;
+// 求解未来 irrigationSlots 个槽位的阀门开启窗口（传感器刷新或手动调节后调用，整个计划从当前槽位重排）。
+// 需水：按未来24小时作物需水预计土壤会低于40%时补到45%（预报刷新前需水为0，退化为按当前读数判断）
+void solveIrrigationSchedule() {
+    auto start = std::chrono::steady_clock::now();
+    IrrigationSchedule& s = irrigationSchedule;
+    const float slotSeconds = (float)soilStepSeconds;
+    s.dirty = false;
+    s.slot = 0;
+    std::fill(s.windowLength.begin(), s.windowLength.end(), 0);
+    std::fill(s.slotFlow.begin(), s.slotFlow.end(), 0.0f);
+    std::fill(s.branchSlotFlow.begin(), s.branchSlotFlow.end(), 0.0f);
+    s.queue.clear();
+    s.flowPrice = s.tankPrice = s.branchPrice = 0.0f;
+    s.scheduledValves = s.truncatedValves = 0;
+    s.plannedVolume = 0.0;
+    if (!farmStatus.autoIrrigation) return;
+
+    // 候选阀门
+    s.valveRate = (8.0f + farmStatus.irrigationIntensity * 5.0f) * 0.5f;
+    for (uint32_t v = 0; v < (uint32_t)s.valves(); v++) {
+        s.flow[v] = s.flowPerRate[v] * s.valveRate;
+        float projected = sensorStore.readings[v].soilMoisture - etForecast.demand24[v] * (100.0f / rootZoneDepthMm);
+        s.urgency[v] = 0.0f;
+        // 没有土壤单元格或没有喷头的区没有可灌溉面积（flowPerRate 为0），不参与排程
+        if (projected >= 40.0f || s.flowPerRate[v] <= 0.0f) continue;
+        s.urgency[v] = 45.0f - projected;
+        s.needSlots[v] = (uint8_t)std::min((int)std::ceil(s.urgency[v] / (s.valveRate * slotSeconds)), irrigationSlots);
+        s.queue.push_back(v);
+    }
+    std::sort(s.queue.begin(), s.queue.end(), [&](uint32_t a, uint32_t b) {
+        return s.urgency[a] != s.urgency[b] ? s.urgency[a] > s.urgency[b] : a < b;
+    });
+
+    // 线性规划（按体积）：总量受泵/压力流量和水箱可用水量（保留10%）约束，各支管受支管流量约束。
+    // 按紧迫度依次分配，某个约束第一次截断阀门时，该阀门的紧迫度就是这个约束的对偶价格
+    const float horizon = irrigationSlots * slotSeconds;
+    const float maxFlow = std::min(s.pumpCapacity, s.pressureLimitedFlow);
+    float flowVolume = maxFlow * horizon;
+    float tankVolume = std::max(farmStatus.waterTankLevel - 10.0f, 0.0f) * 0.01f * s.tankCapacity + s.tankRefill * horizon;
+    s.branchVolume.resize(s.branchCount);
+    for (int b = 0; b < s.branchCount; b++) s.branchVolume[b] = s.branchCapacity[b] * horizon;
+    for (uint32_t v : s.queue) {
+        float slotVolume = s.flow[v] * slotSeconds;
+        float& branchVolume = s.branchVolume[s.branch[v]];
+        int byFlow = (int)(flowVolume / slotVolume);
+        int byTank = (int)(tankVolume / slotVolume);
+        int byBranch = (int)(branchVolume / slotVolume);
+        int slots = std::max(std::min(std::min((int)s.needSlots[v], byFlow), std::min(byTank, byBranch)), 0);
+        if (slots < s.needSlots[v]) {
+            float price = s.urgency[v] / s.flowPerRate[v];
+            float& binding = byFlow == slots ? s.flowPrice : (byTank == slots ? s.tankPrice : s.branchPrice);
+            if (binding == 0.0f) binding = price;
         }
+        s.allocatedSlots[v] = (uint8_t)slots;
+        flowVolume -= slots * slotVolume;
+        tankVolume -= slots * slotVolume;
+        branchVolume -= slots * slotVolume;
+    }
 
-        // 气候控制提供超稳定生长环境
-        if (farmStatus.climateControl) {
-            weatherEffect = std::max(weatherEffect, 1.05f); // 确保优秀生长率
-            plant.healthFactor = std::min(1.0f, plant.healthFactor + 0.0005f); // 长期健康提升
-        }
+    // 装入逐槽位流量容量，再用剩余容量细化：先补足被装箱截断的分配，再给线性规划截掉的阀门
+    float spareVolume = std::min(flowVolume, tankVolume);
+    for (uint32_t v : s.queue) {
+        if (s.allocatedSlots[v] > 0) placeIrrigationWindow(s, v, s.allocatedSlots[v], maxFlow);
+        spareVolume += (s.allocatedSlots[v] - s.windowLength[v]) * s.flow[v] * slotSeconds;
+    }
+    for (uint32_t v : s.queue) {
+        int want = std::min((int)s.needSlots[v], s.windowLength[v] + (int)(spareVolume / (s.flow[v] * slotSeconds)));
+        if (want <= s.windowLength[v]) continue;
+        int before = s.windowLength[v];
+        placeIrrigationWindow(s, v, want, maxFlow);
+        spareVolume -= (s.windowLength[v] - before) * s.flow[v] * slotSeconds;
+    }
+    for (uint32_t v : s.queue) {
+        if (s.windowLength[v] > 0) s.scheduledValves++;
+        if (s.windowLength[v] < s.needSlots[v]) s.truncatedValves++;
+        s.plannedVolume += (double)s.windowLength[v] * s.flow[v] * slotSeconds;
+    }
+    s.solveCount++;
+    s.solveMillis += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    if (simEventLog && s.scheduledValves > 0) {
+        std::cout << "IRRIGATION SCHEDULE - " << s.scheduledValves << "/" << s.queue.size() << " dry zones get valve windows"
+            << " | " << std::fixed << std::setprecision(1) << s.plannedVolume / 1000.0 << " m3 over next "
+            << horizon << " s | Tank: " << (int)farmStatus.waterTankLevel << "%";
+        if (s.flowPrice > 0.0f) std::cout << " | pump-limited";
+        if (s.tankPrice > 0.0f) std::cout << " | tank-limited";
+        if (s.branchPrice > 0.0f) std::cout << " | branch-limited";
+        std::cout << std::endl;
+    }
+}
 
-        // 健康度微调
-        plant.healthFactor *= weatherEffect;
-        plant.healthFactor = clamp(plant.healthFactor, 0.4f, 1.0f);
+// 执行当前槽位：开启窗口内的阀门，水箱按流量放水、水源补水，管网压力按泵特性曲线
+// 喷头出水按管网求解的节点压力：区内喷灌强度和用水量乘该区喷头的平均出水比例
+void applyIrrigationSlot(float dt) {
+    IrrigationSchedule& s = irrigationSchedule;
+    PipeNetwork& net = pipeNetwork;
+    std::vector<unsigned char> valveOpen(s.valves(), 0);
+    int openValves = 0;
+    for (size_t v = 0; v < s.valves(); v++) {
+        valveOpen[v] = s.slot >= s.windowStart[v] && s.slot < s.windowStart[v] + s.windowLength[v];
+        openValves += valveOpen[v];
+    }
+    if (s.slot < irrigationSlots) s.slot++;
 
-        // 缓慢生长
-        plant.growthStage += deltaTime * 0.002f * plant.healthFactor;
-        plant.growthStage = clamp(plant.growthStage, 0.0f, 1.0f);
+    for (size_t i = 0; i < net.nodes(); i++) {
+        unsigned char open = valveOpen[net.zone[i]];
+        if (net.open[i] != open) {
+            net.open[i] = open;
+            net.dirty = true;
+        }
+    }
+    if (net.dirty || !net.converged) solvePipeNetwork();
 
-        // 根据健康度和生长阶段调整外观
-        float healthEffect = plant.healthFactor * plant.growthStage;
-        plant.leafColor = glm::vec3(
-            0.1f + (1.0f - healthEffect) * 0.2f,  // 不健康时稍微偏红
-            0.3f + healthEffect * 0.5f,           // 健康时更绿
-            0.1f
-        );
+    float totalFlow = 0.0f;
+    for (size_t v = 0; v < s.valves(); v++) {
+        float output = valveOpen[v] ? net.zoneOutput[v] : 0.0f;
+        soilGrid.zoneWater[v] = s.valveRate * output;
+        totalFlow += s.flow[v] * output;
+    }
 
-        // 更新叶片位置（重新计算以反映生长）
-        if ((int)plant.leafPositions.size() != plant.leafCount) {
-            plant.leafPositions.clear();
-            plant.leafSizes.clear();
+    float volume = totalFlow * dt;
+    farmStatus.waterUsage += volume;
+    farmStatus.waterTankLevel = clamp(farmStatus.waterTankLevel + (s.tankRefill * dt - volume) / s.tankCapacity * 100.0f,
+        10.0f, 100.0f);
+    farmStatus.activeNozzles = openValves;
+    farmStatus.irrigationActive = openValves > 0;
+}
 
-            for (int j = 0; j < plant.leafCount; j++) {
-                float heightRatio = (float)(j + 1) / (plant.leafCount + 1);
-                float angle = j * 137.5f * 3.14159f / 180.0f; // 黄金角度螺旋
+// 管段流量和线性化电导：水头差小于5cm（低流速，Hazen-Williams 公式本不适用）时改用与之一阶光滑衔接的
+// 三次式 Q = aΔ + bΔ³。Q ∝ Δ^0.54 在零点附近电导趋于无穷，衔接区太窄时近零流量的管段会在牛顿迭代中来回振荡
+const double pipeSmoothHead = 0.05;
+
+PipeLaw makePipeLaw(double resistance, double exponent) {
+    PipeLaw law;
+    law.resistance = resistance;
+    law.exponent = exponent;
+    double q0 = std::pow(pipeSmoothHead / resistance, exponent) / pipeSmoothHead;
+    law.c1 = q0 * (3.0 - exponent) * 0.5;
+    law.c3 = q0 * (exponent - 1.0) * 0.5 / (pipeSmoothHead * pipeSmoothHead);
+    return law;
+}
 
-                glm::vec3 leafPos = plant.position + glm::vec3(
-                    cos(angle) * plant.leafSize * (1.0f + heightRatio * 0.5f),
-                    plant.height * heightRatio * plant.growthStage,
-                    sin(angle) * plant.leafSize * (1.0f + heightRatio * 0.5f)
-                );
+inline double pipeSegmentFlow(double dh, const PipeLaw& law, double& conductance) {
+    double a = std::abs(dh);
+    if (a < pipeSmoothHead) {
+        conductance = law.c1 + 3.0 * law.c3 * dh * dh;
+        return (law.c1 + law.c3 * dh * dh) * dh;
+    }
+    double q = std::pow(a / law.resistance, law.exponent);
+    conductance = law.exponent * q / a;
+    return dh > 0.0 ? q : -q;
+}
 
-                plant.leafPositions.push_back(leafPos);
-                plant.leafSizes.push_back(plant.leafSize * (0.7f + heightRatio * 0.5f) * plant.healthFactor);
-            }
+// 喷头出水 q = K·√p，压力很低时改用一阶光滑衔接的二次式（负压不出水，保留小电导使雅可比正定）
+inline double emitterFlow(double pressure, double k, double& conductance) {
+    const double smoothPressure = 0.1;
+    if (pressure < smoothPressure) {
+        double c1 = 1.5 * k / std::sqrt(smoothPressure);
+        double c2 = -0.5 * k / (smoothPressure * std::sqrt(smoothPressure));
+        if (pressure <= 0.0) {
+            conductance = 1e-3 * c1;
+            return 0.0;
         }
+        conductance = c1 + 2.0 * c2 * pressure;
+        return (c1 + c2 * pressure) * pressure;
+    }
+    double q = k * std::sqrt(pressure);
+    conductance = 0.5 * q / pressure;
+    return q;
+}
 
-        // 开花结果逻辑
-        if (plant.plantType == 2) { // 番茄
-            plant.hasFlowers = plant.growthStage > 0.6f;
-            plant.hasFruits = plant.growthStage > 0.8f && plant.healthFactor > 0.7f;
-        }
-        else if (plant.plantType == 0) { // 玉米
-            plant.hasFlowers = plant.growthStage > 0.8f;
+// Hazen-Williams 管段阻力系数（SI，C=140 的塑料管）：水头损失 = r·Q^1.852
+inline double hazenWilliamsResistance(double length, double diameter) {
+    return 10.67 * length / (std::pow(140.0, 1.852) * std::pow(diameter, 4.87));
+}
+
+// 按 generateDetailedFarm 的喷头格网建立管网。设计流量为全部喷头额定流量的35%（与灌溉排程的水泵一致），
+// 管径按设计流量下的水头损失选取：干管沿西侧边缘约 6 PSI，支管横穿田地约 15 PSI，主管约 1 PSI
+void initializePipeNetwork() {
+    PipeNetwork& net = pipeNetwork;
+    float spacing = farmConfig.nozzleSpacing;
+    float nozzleExtent = farmConfig.nozzleHalfExtent();
+    net.size = (int)(nozzleExtent * 2.0f / spacing + 0.001f) + 1;
+    net.inlet = (uint32_t)((net.size / 2) * net.size);
+
+    const double nominalPressure = 40.0 * psiToMetres;
+    net.nominalFlow = 0.3e-3;   // 每个喷头 0.3 L/s
+    net.emitterK = net.nominalFlow / std::sqrt(nominalPressure);
+    double designFlow = 0.35 * net.nominalFlow * net.nodes();
+    net.reservoirHead = 95.0 * psiToMetres;
+    net.pumpLaw = makePipeLaw(65.0 * psiToMetres / (designFlow * designFlow), 0.5);
+    double n = net.size;
+    auto diameterFor = [](double length, double flow, double headLoss) {
+        return std::max(0.025, std::pow(10.67 * length * std::pow(flow, 1.852) / (std::pow(140.0, 1.852) * headLoss), 1.0 / 4.87));
+    };
+    double headerDiameter = diameterFor(spacing * n * 0.5, designFlow * 0.5, 6.0 * psiToMetres);
+    double lateralDiameter = diameterFor(spacing * n, designFlow / n, 15.0 * psiToMetres);
+    double mainDiameter = diameterFor(2.0, designFlow, 1.0 * psiToMetres);
+    net.headerLaw = makePipeLaw(hazenWilliamsResistance(spacing, headerDiameter), 0.54);
+    net.lateralLaw = makePipeLaw(hazenWilliamsResistance(spacing, lateralDiameter), 0.54);
+    net.mainLaw = makePipeLaw(hazenWilliamsResistance(2.0, mainDiameter), 0.54);
+
+    size_t nodes = net.nodes();
+    net.zone.resize(nodes);
+    net.open.assign(nodes, 0);
+    net.zoneNozzles.assign(sensorStore.size(), 0);
+    for (int iz = 0; iz < net.size; iz++) {
+        for (int ix = 0; ix < net.size; ix++) {
+            size_t cell = soilGrid.cellAt(-nozzleExtent + ix * spacing, -nozzleExtent + iz * spacing);
+            net.zone[(size_t)iz * net.size + ix] = soilGrid.zone[cell];
+            net.zoneNozzles[soilGrid.zone[cell]]++;
         }
-        else if (plant.plantType == 1) { // 小麦
-            plant.hasFlowers = plant.growthStage > 0.7f;
+    }
+    net.head.assign(nodes, net.reservoirHead);
+    net.pumpHead = net.reservoirHead;
+    for (std::vector<double>* v : { &net.flowEast, &net.flowNorth, &net.residual, &net.delta, &net.cgP, &net.cgPNext, &net.cgAp }) {
+        v->assign(nodes, 0.0);
+    }
+    // 多重网格层：每层边长减半，直到不超过4
+    net.levels.clear();
+    for (int levelSize = net.size; ; levelSize = (levelSize + 1) / 2) {
+        PipeLevel level;
+        level.size = levelSize;
+        size_t levelNodes = (size_t)levelSize * levelSize;
+        for (std::vector<double>* v : { &level.gEast, &level.gNorth, &level.diag, &level.x, &level.b, &level.r }) {
+            v->assign(levelNodes, 0.0);
         }
+        net.levels.push_back(std::move(level));
+        if (levelSize <= 4) break;
     }
+    net.coarseFactor.assign(net.levels.back().x.size() * net.levels.back().x.size(), 0.0);
+    net.chunkSums.assign((net.size + pipeRowChunkSize - 1) / pipeRowChunkSize, 0.0);
+    net.chunkSums2.assign(net.chunkSums.size(), 0.0);
+    net.zoneOutput.assign(sensorStore.size(), 0.0f);
+    net.dirty = true;
+    net.converged = false;
+    std::cout << "Pipe network: " << nodes << " nozzles, " << net.segments() << " segments, "
+        << net.levels.size() << " multigrid levels"
+        << " | header " << std::fixed << std::setprecision(0) << headerDiameter * 1000.0
+        << " mm, laterals " << lateralDiameter * 1000.0 << " mm, main " << mainDiameter * 1000.0 << " mm" << std::endl;
+}
 
-    // 更新光照位置 (太阳轨迹)
-    float sunAngle = dayNightCycle * 2.0f * 3.14159f;
-    lightPos = glm::vec3(
-        cos(sunAngle) * 25.0f,
-        5.0f + sin(sunAngle) * 15.0f,
-        sin(sunAngle) * 15.0f
-    );
+// 计算所有管段流量和节点流量不平衡，并组装牛顿雅可比（第0层电导和对角元），返回不平衡的二范数
+double evaluatePipeNetwork() {
+    PipeNetwork& net = pipeNetwork;
+    PipeLevel& jac = net.levels[0];
+    const int size = net.size;
+    threadPool.parallelFor(size, pipeRowChunkSize, [&](size_t begin, size_t end, int) {
+        for (size_t iz = begin; iz < end; iz++) {
+            for (int ix = 0; ix < size; ix++) {
+                size_t i = iz * size + ix;
+                if (ix + 1 < size) {
+                    net.flowEast[i] = pipeSegmentFlow(net.head[i] - net.head[i + 1], net.lateralLaw, jac.gEast[i]);
+                }
+                if ((int)iz + 1 < size) {
+                    const PipeLaw& law = ix == 0 ? net.headerLaw : net.lateralLaw;
+                    net.flowNorth[i] = pipeSegmentFlow(net.head[i] - net.head[i + size], law, jac.gNorth[i]);
+                }
+            }
+        }
+    });
+    net.mainFlow = pipeSegmentFlow(net.pumpHead - net.head[net.inlet], net.mainLaw, net.mainConductance);
+    net.pumpFlow = pipeSegmentFlow(net.reservoirHead - net.pumpHead, net.pumpLaw, net.pumpConductance);
+
+    threadPool.parallelFor(size, pipeRowChunkSize, [&](size_t begin, size_t end, int) {
+        double sum = 0.0;
+        for (size_t iz = begin; iz < end; iz++) {
+            for (int ix = 0; ix < size; ix++) {
+                size_t i = iz * size + ix;
+                double f = 0.0, d = 0.0;
+                if (ix + 1 < size) { f += net.flowEast[i]; d += jac.gEast[i]; }
+                if (ix > 0) { f -= net.flowEast[i - 1]; d += jac.gEast[i - 1]; }
+                if ((int)iz + 1 < size) { f += net.flowNorth[i]; d += jac.gNorth[i]; }
+                if (iz > 0) { f -= net.flowNorth[i - size]; d += jac.gNorth[i - size]; }
+                if (net.open[i]) {
+                    double g;
+                    f += emitterFlow(net.head[i], net.emitterK, g);
+                    d += g;
+                }
+                if (i == net.inlet) { f -= net.mainFlow; d += net.mainConductance; }
+                net.residual[i] = f;
+                jac.diag[i] = d;
+                sum += f * f;
+            }
+        }
+        net.chunkSums[begin / pipeRowChunkSize] = sum;
+    });
+    net.pumpResidual = net.mainFlow - net.pumpFlow;
+    double sum = net.pumpResidual * net.pumpResidual;
+    for (double chunk : net.chunkSums) sum += chunk;
+    return std::sqrt(sum);
+}
 
-    // 动态光照颜色
-    float dayIntensity = clamp(lightPos.y / 20.0f, 0.0f, 1.0f);
-    if (dayIntensity > 0.1f) {
-        lightColor = glm::mix(glm::vec3(1.0f, 0.7f, 0.4f), glm::vec3(1.0f, 0.95f, 0.8f), dayIntensity);
+// 整体水头修正：所有节点水头同加 s，使水泵流量等于开启喷头的总出水（二分求 s）。这是常数模态上的
+// 非线性修正——阀门开关变化后总流量跳变，泵和喷头的平方根特性在这个方向上会让牛顿迭代多走好几步
+void balancePipeNetworkHead() {
+    PipeNetwork& net = pipeNetwork;
+    std::vector<uint32_t> openNodes;
+    double highest = net.pumpHead;
+    for (size_t i = 0; i < net.nodes(); i++) {
+        if (net.open[i]) openNodes.push_back((uint32_t)i);
+        highest = std::max(highest, net.head[i]);
     }
-    else {
-        lightColor = glm::vec3(0.3f, 0.4f, 0.8f); // 夜晚蓝色调
+    double lo = -highest, hi = net.reservoirHead - net.pumpHead;
+    for (int iteration = 0; iteration < 40 && !openNodes.empty(); iteration++) {
+        double shift = 0.5 * (lo + hi), g;
+        double demand = 0.0;
+        for (uint32_t i : openNodes) demand += emitterFlow(net.head[i] + shift, net.emitterK, g);
+        double supply = std::sqrt(std::max(net.reservoirHead - net.pumpHead - shift, 0.0) / net.pumpLaw.resistance);
+        if (demand > supply) hi = shift;
+        else lo = shift;
     }
+    double shift = 0.5 * (lo + hi);
+    for (size_t i = 0; i < net.nodes(); i++) net.head[i] += shift;
+    net.pumpHead += shift;
+}
 
-    // 根据天气调整光照颜色
-    switch (weather.weatherType) {
-    case 1: // 多云
-        lightColor *= 0.9f;
-        break;
-    case 2: // 雨天
-        lightColor *= 0.7f;
-        break;
-    case 3: // 暴风雨
-        lightColor *= 0.5f;
-        break;
+// 由第0层逐层聚合出粗层（P 为分片常数延拓时 PᵀAP 仍是五点格网：跨聚合电导相加，
+// 对角元为聚合内对角元之和减去两倍内部电导），最粗层做稠密 Cholesky 分解
+void buildPipeLevels() {
+    PipeNetwork& net = pipeNetwork;
+    for (size_t l = 1; l < net.levels.size(); l++) {
+        const PipeLevel& fine = net.levels[l - 1];
+        PipeLevel& coarse = net.levels[l];
+        const int fs = fine.size, cs = coarse.size;
+        threadPool.parallelFor(cs, pipeRowChunkSize, [&](size_t begin, size_t end, int) {
+            for (size_t cz = begin; cz < end; cz++) {
+                for (int cx = 0; cx < cs; cx++) {
+                    size_t c = cz * cs + cx;
+                    double d = 0.0, east = 0.0, north = 0.0;
+                    for (int dz = 0; dz < 2; dz++) {
+                        int fz = (int)cz * 2 + dz;
+                        if (fz >= fs) break;
+                        for (int dx = 0; dx < 2; dx++) {
+                            int fx = cx * 2 + dx;
+                            if (fx >= fs) break;
+                            size_t f = (size_t)fz * fs + fx;
+                            d += fine.diag[f];
+                            if (fx + 1 < fs) {
+                                if (dx == 0) d -= 2.0 * fine.gEast[f];
+                                else east += fine.gEast[f];
+                            }
+                            if (fz + 1 < fs) {
+                                if (dz == 0) d -= 2.0 * fine.gNorth[f];
+                                else north += fine.gNorth[f];
+                            }
+                        }
+                    }
+                    coarse.diag[c] = d;
+                    coarse.gEast[c] = cx + 1 < cs ? east : 0.0;
+                    coarse.gNorth[c] = (int)cz + 1 < cs ? north : 0.0;
+                }
+            }
+        });
+    }
+
+    const PipeLevel& last = net.levels.back();
+    const int cs = last.size;
+    const size_t n = last.x.size();
+    std::vector<double>& a = net.coarseFactor;
+    std::fill(a.begin(), a.end(), 0.0);
+    for (size_t i = 0; i < n; i++) {
+        a[i * n + i] = last.diag[i];
+        if ((int)(i % cs) + 1 < cs) a[i * n + i + 1] = a[(i + 1) * n + i] = -last.gEast[i];
+        if (i + cs < n) a[i * n + i + cs] = a[(i + cs) * n + i] = -last.gNorth[i];
+    }
+    for (size_t j = 0; j < n; j++) {
+        double d = a[j * n + j];
+        for (size_t k = 0; k < j; k++) d -= a[j * n + k] * a[j * n + k];
+        a[j * n + j] = std::sqrt(std::max(d, 1e-300));
+        for (size_t i = j + 1; i < n; i++) {
+            double v = a[i * n + j];
+            for (size_t k = 0; k < j; k++) v -= a[i * n + k] * a[j * n + k];
+            a[i * n + j] = v / a[j * n + j];
+        }
     }
 }
 
-// 更新农场状态 - 超级明显版
-void updateFarmStatus() {
-    // 统计健康植物 - 更详细
-    farmStatus.healthyPlants = 0;
-    farmStatus.sickPlants = 0;
-    int excellentPlants = 0;
-    int criticalPlants = 0;
+// 红黑 Gauss-Seidel：只更新 (x+z) 奇偶为 color 的节点，同色节点互不相邻，可按行块并行且结果与线程数无关
+void smoothPipeLevel(PipeLevel& level, int color) {
+    const int size = level.size;
+    threadPool.parallelFor(size, pipeRowChunkSize, [&](size_t begin, size_t end, int) {
+        for (size_t iz = begin; iz < end; iz++) {
+            for (int ix = (int)((iz + color) & 1); ix < size; ix += 2) {
+                size_t i = iz * size + ix;
+                double v = level.b[i];
+                if (ix + 1 < size) v += level.gEast[i] * level.x[i + 1];
+                if (ix > 0) v += level.gEast[i - 1] * level.x[i - 1];
+                if ((int)iz + 1 < size) v += level.gNorth[i] * level.x[i + size];
+                if (iz > 0) v += level.gNorth[i - size] * level.x[i - size];
+                level.x[i] = v / level.diag[i];
+            }
+        }
+    });
+}
 
-    for (const auto& plant : plants) {
-        if (plant.healthFactor > 0.9f && !plant.isPestInfected) {
-            excellentPlants++;
-            farmStatus.healthyPlants++;
+// 从第 l 层开始的V循环（零初值）：前光滑两遍红-黑、后光滑两遍黑-红，预条件算子对称。
+// 分片常数延拓的粗网格修正偏弱，修正量乘 1.8（过修正）后共轭梯度迭代次数约减半
+void pipeVCycle(size_t l) {
+    PipeNetwork& net = pipeNetwork;
+    PipeLevel& level = net.levels[l];
+    const int size = level.size;
+    if (l + 1 == net.levels.size()) {
+        const size_t n = level.x.size();
+        const std::vector<double>& a = net.coarseFactor;
+        for (size_t i = 0; i < n; i++) {
+            double v = level.b[i];
+            for (size_t k = 0; k < i; k++) v -= a[i * n + k] * level.x[k];
+            level.x[i] = v / a[i * n + i];
         }
-        else if (plant.healthFactor > 0.7f && !plant.isPestInfected) {
-            farmStatus.healthyPlants++;
+        for (size_t i = n; i-- > 0;) {
+            double v = level.x[i];
+            for (size_t k = i + 1; k < n; k++) v -= a[k * n + i] * level.x[k];
+            level.x[i] = v / a[i * n + i];
         }
-        else if (plant.healthFactor < 0.5f || plant.isPestInfected) {
-            criticalPlants++;
-            farmStatus.sickPlants++;
+        return;
+    }
+
+    std::fill(level.x.begin(), level.x.end(), 0.0);
+    for (int sweep = 0; sweep < 2; sweep++) {
+        smoothPipeLevel(level, 0);
+        smoothPipeLevel(level, 1);
+    }
+    threadPool.parallelFor(size, pipeRowChunkSize, [&](size_t begin, size_t end, int) {
+        for (size_t iz = begin; iz < end; iz++) {
+            for (int ix = 0; ix < size; ix++) {
+                size_t i = iz * size + ix;
+                double v = level.b[i] - level.diag[i] * level.x[i];
+                if (ix + 1 < size) v += level.gEast[i] * level.x[i + 1];
+                if (ix > 0) v += level.gEast[i - 1] * level.x[i - 1];
+                if ((int)iz + 1 < size) v += level.gNorth[i] * level.x[i + size];
+                if (iz > 0) v += level.gNorth[i - size] * level.x[i - size];
+                level.r[i] = v;
+            }
         }
-        else {
-            farmStatus.sickPlants++;
+    });
+    PipeLevel& coarse = net.levels[l + 1];
+    const int cs = coarse.size;
+    threadPool.parallelFor(cs, pipeRowChunkSize, [&](size_t begin, size_t end, int) {
+        for (size_t cz = begin; cz < end; cz++) {
+            for (int cx = 0; cx < cs; cx++) {
+                double v = 0.0;
+                for (int fz = (int)cz * 2; fz < std::min((int)cz * 2 + 2, size); fz++) {
+                    for (int fx = cx * 2; fx < std::min(cx * 2 + 2, size); fx++) v += level.r[(size_t)fz * size + fx];
+                }
+                coarse.b[cz * cs + cx] = v;
+            }
+        }
+    });
+    pipeVCycle(l + 1);
+    threadPool.parallelFor(size, pipeRowChunkSize, [&](size_t begin, size_t end, int) {
+        for (size_t iz = begin; iz < end; iz++) {
+            for (int ix = 0; ix < size; ix++) {
+                level.x[iz * size + ix] += 1.8 * coarse.x[(iz / 2) * cs + ix / 2];
+            }
         }
+    });
+    for (int sweep = 0; sweep < 2; sweep++) {
+        smoothPipeLevel(level, 1);
+        smoothPipeLevel(level, 0);
     }
+}
 
-    // 统计警报传感器和计算平均值 - 更详细
-    farmStatus.alertSensors = 0;
-    int warningeSensors = 0;
-    int perfectSensors = 0;
-    float totalTemp = 0.0f, totalHumid = 0.0f, totalSoil = 0.0f;
+// 一次牛顿步：解 J·δ = -F（相对精度 tolerance），返回共轭梯度迭代次数。水泵出口节点只连主管，
+// 先把它消去到接入节点上，格网部分用多重网格预条件共轭梯度求解，最后回代出口节点的 δ。
+// p 的更新 p = z + β·p 与矩阵乘合并在一遍中完成（双缓冲，邻居读旧值）
+int solvePipeNetworkStep(double tolerance) {
+    PipeNetwork& net = pipeNetwork;
+    PipeLevel& jac = net.levels[0];
+    const int size = net.size;
+    const int maxIterations = 100;
+    std::vector<double>& r = jac.b;
+    std::vector<double>& z = jac.x;
+    double pumpDiag = net.mainConductance + net.pumpConductance;
+    double pumpRhs = -net.pumpResidual;
+    for (size_t i = 0; i < net.nodes(); i++) r[i] = -net.residual[i];
+    jac.diag[net.inlet] -= net.mainConductance * net.mainConductance / pumpDiag;
+    r[net.inlet] += net.mainConductance * pumpRhs / pumpDiag;
+    buildPipeLevels();
+
+    double rr = 0.0;
+    for (size_t i = 0; i < net.nodes(); i++) {
+        net.delta[i] = 0.0;
+        net.cgP[i] = 0.0;
+        rr += r[i] * r[i];
+    }
+    double target = tolerance * std::sqrt(rr);
+    double rz = 0.0, beta = 0.0;
+    int iteration = 0;
+    while (iteration < maxIterations && std::sqrt(rr) > target) {
+        // z = M⁻¹·r，ρ = r·z
+        pipeVCycle(0);
+        threadPool.parallelFor(size, pipeRowChunkSize, [&](size_t begin, size_t end, int) {
+            double sum = 0.0;
+            for (size_t i = begin * size; i < end * size; i++) sum += r[i] * z[i];
+            net.chunkSums[begin / pipeRowChunkSize] = sum;
+        });
+        double rzNext = 0.0;
+        for (double chunk : net.chunkSums) rzNext += chunk;
+        beta = iteration == 0 ? 0.0 : rzNext / rz;
+        rz = rzNext;
+        iteration++;
+
+        // p = z + β·p 与 Ap
+        threadPool.parallelFor(size, pipeRowChunkSize, [&](size_t begin, size_t end, int) {
+            double sum = 0.0;
+            for (size_t iz = begin; iz < end; iz++) {
+                for (int ix = 0; ix < size; ix++) {
+                    size_t i = iz * size + ix;
+                    double pi = z[i] + beta * net.cgP[i];
+                    double ap = jac.diag[i] * pi;
+                    if (ix + 1 < size) ap -= jac.gEast[i] * (z[i + 1] + beta * net.cgP[i + 1]);
+                    if (ix > 0) ap -= jac.gEast[i - 1] * (z[i - 1] + beta * net.cgP[i - 1]);
+                    if ((int)iz + 1 < size) ap -= jac.gNorth[i] * (z[i + size] + beta * net.cgP[i + size]);
+                    if (iz > 0) ap -= jac.gNorth[i - size] * (z[i - size] + beta * net.cgP[i - size]);
+                    net.cgPNext[i] = pi;
+                    net.cgAp[i] = ap;
+                    sum += pi * ap;
+                }
+            }
+            net.chunkSums[begin / pipeRowChunkSize] = sum;
+        });
+        net.cgP.swap(net.cgPNext);
+        double pAp = 0.0;
+        for (double chunk : net.chunkSums) pAp += chunk;
+        if (pAp <= 0.0) break;
+        double alpha = rz / pAp;
+
+        // δ += α·p，r -= α·Ap
+        threadPool.parallelFor(size, pipeRowChunkSize, [&](size_t begin, size_t end, int) {
+            double sum = 0.0;
+            for (size_t i = begin * size; i < end * size; i++) {
+                net.delta[i] += alpha * net.cgP[i];
+                r[i] -= alpha * net.cgAp[i];
+                sum += r[i] * r[i];
+            }
+            net.chunkSums2[begin / pipeRowChunkSize] = sum;
+        });
+        rr = 0.0;
+        for (double chunk : net.chunkSums2) rr += chunk;
+    }
+    net.pumpDelta = (pumpRhs + net.mainConductance * net.delta[net.inlet]) / pumpDiag;
+    return iteration;
+}
 
-    for (const auto& sensor : sensors) {
-        totalTemp += sensor.temperature;
-        totalHumid += sensor.humidity;
-        totalSoil += sensor.soilMoisture;
+// 牛顿迭代到节点流量不平衡（均方根）低于喷头额定流量的1%；步长不能减小不平衡时折半（最多5次）。
+// 收敛后按节点压力统计各区喷头平均出水、开启喷头的平均压力和 Christiansen 均匀系数；
+// 达到迭代上限仍未收敛时计数并保留上次收敛的结果（下一槽位从当前水头继续求解）
+void solvePipeNetwork() {
+    auto start = std::chrono::steady_clock::now();
+    PipeNetwork& net = pipeNetwork;
+    const size_t count = net.nodes();
+    const int maxNewtonSteps = 12;
+    double tolerance = 1e-2 * net.nominalFlow * std::sqrt((double)count + 1.0);
+    if (net.dirty) balancePipeNetworkHead();
+    double norm = evaluatePipeNetwork();
+    int steps = 0;
+    while (norm > tolerance && steps < maxNewtonSteps) {
+        net.cgIterations += solvePipeNetworkStep(0.1);
+        steps++;
+        double scale = 1.0;
+        for (size_t i = 0; i < count; i++) net.head[i] += net.delta[i];
+        net.pumpHead += net.pumpDelta;
+        double next = evaluatePipeNetwork();
+        for (int halving = 0; halving < 5 && next >= norm; halving++) {
+            scale *= 0.5;
+            for (size_t i = 0; i < count; i++) net.head[i] -= scale * net.delta[i];
+            net.pumpHead -= scale * net.pumpDelta;
+            next = evaluatePipeNetwork();
+        }
+        norm = next;
+    }
+    net.converged = norm <= tolerance;
+    net.dirty = false;
+    net.residualNorm = norm;
+    net.newtonSteps += steps;
+    net.solves++;
+    if (!net.converged) {
+        net.unconverged++;
+        if (simEventLog) {
+            std::cout << "PIPE NETWORK did not converge after " << steps << " Newton steps (residual "
+                << norm / net.nominalFlow << " nozzle flows) - keeping last converged outputs" << std::endl;
+        }
+        net.solveMillis += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return;
+    }
 
-        if (sensor.statusColor.r > 0.8f) { // 红色警报
-            farmStatus.alertSensors++;
+    std::fill(net.zoneOutput.begin(), net.zoneOutput.end(), 0.0f);
+    double flowSum = 0.0, pressureSum = 0.0;
+    int openNozzles = 0;
+    for (size_t i = 0; i < net.nodes(); i++) {
+        if (!net.open[i]) continue;
+        double g;
+        double q = emitterFlow(net.head[i], net.emitterK, g);
+        net.zoneOutput[net.zone[i]] += (float)(q / net.nominalFlow);
+        flowSum += q;
+        pressureSum += net.head[i];
+        openNozzles++;
+    }
+    for (size_t v = 0; v < net.zoneOutput.size(); v++) {
+        net.zoneOutput[v] = net.zoneNozzles[v] > 0 ? net.zoneOutput[v] / net.zoneNozzles[v] : 0.0f;
+    }
+    if (openNozzles > 0) {
+        double mean = flowSum / openNozzles, deviation = 0.0;
+        for (size_t i = 0; i < net.nodes(); i++) {
+            if (!net.open[i]) continue;
+            double g;
+            deviation += std::abs(emitterFlow(net.head[i], net.emitterK, g) - mean);
         }
-        else if (sensor.statusColor.r > 0.7f || sensor.statusColor.g < 0.9f) { // 黄色警告
-            warningeSensors++;
+        farmStatus.waterPressure = (float)(pressureSum / openNozzles / psiToMetres);
+        farmStatus.irrigationEfficiency = (float)(100.0 * (1.0 - deviation / flowSum));
+    }
+    else {
+        farmStatus.waterPressure = (float)(net.pumpHead / psiToMetres);
+    }
+    net.solveMillis += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// 饱和水汽密度（g/m³），Magnus 公式
+float saturationVapourDensity(float t) {
+    return 216.7f * 6.112f * etExp(17.67f * t / (t + 243.5f)) / (t + 273.15f);
+}
+
+// 为 buildings 中每栋温室建立热湿区：覆盖层为四壁加屋面的单层玻璃（U ≈ 6 W/m²K），加热器按比室外低25°C
+// 设计，喷雾按每平方米 0.05 g/s；传感器位于温室占地（向外放宽半个传感器间距）内的归入该温室
+void initializeGreenhouseZones() {
+    GreenhouseZones& g = greenhouseZones;
+    g = GreenhouseZones();
+    for (size_t b = 0; b < buildingStore.size(); b++) {
+        const Building& house = buildingStore.detail[b];
+        if (!house.greenhouse) continue;
+        float floor = house.size.x * house.size.z;
+        float volume = floor * house.size.y;
+        float glazing = floor + 2.0f * (house.size.x + house.size.z) * house.size.y;
+        float ua = glazing * 6.0f;
+        g.building.push_back((uint32_t)b);
+        g.floorArea.push_back(floor);
+        g.volume.push_back(volume);
+        g.heatCapacity.push_back(volume * 1200.0f * 12.0f);   // 空气体积热容 1200 J/m³K，作物和结构约为空气的11倍
+        g.glazingUA.push_back(ua);
+        g.heaterPower.push_back(ua * 25.0f);
+        g.mistRate.push_back(floor * 0.05f);
+        g.airTemperature.push_back(weather.temperature);
+        g.vapourDensity.push_back(weather.humidity * 0.01f * saturationVapourDensity(weather.temperature));
+        g.humidity.push_back(weather.humidity);
+    }
+    const size_t count = g.zones();
+    g.heat.assign(count, 0.0f);
+    g.vent.assign(count, 0.0f);
+    g.mist.assign(count, 0.0f);
+
+    // 回路参数：设定值、方向、比例增益、积分时间、微分时间（秒）；反算时间取 √(Ti·Td)，无微分时取 Ti
+    struct LoopTuning { float setpoint, direction, kp, ti, td; };
+    const LoopTuning tuning[CLIMATE_LOOP_KINDS] = {
+        { 18.0f, 1.0f, 0.30f, 600.0f, 60.0f },    // 加热：气温低于18°C
+        { 26.0f, -1.0f, 0.25f, 900.0f, 0.0f },    // 通风降温：气温高于26°C
+        { 60.0f, 1.0f, 0.05f, 600.0f, 0.0f },     // 喷雾加湿：湿度低于60%
+        { 85.0f, -1.0f, 0.05f, 900.0f, 0.0f }     // 通风除湿：湿度高于85%
+    };
+    ClimateLoops& c = g.loops;
+    const size_t loops = count * CLIMATE_LOOP_KINDS;
+    c.setpoint.resize(loops);
+    c.measurement.resize(loops);
+    c.direction.resize(loops);
+    c.kp.resize(loops);
+    c.ki.resize(loops);
+    c.kd.resize(loops);
+    c.tracking.resize(loops);
+    c.integral.assign(loops, 0.0f);
+    c.previous.resize(loops);
+    c.output.assign(loops, 0.0f);
+    for (int k = 0; k < CLIMATE_LOOP_KINDS; k++) {
+        const LoopTuning& t = tuning[k];
+        bool temperatureLoop = k == CLIMATE_LOOP_HEAT || k == CLIMATE_LOOP_VENT_COOL;
+        for (size_t z = 0; z < count; z++) {
+            size_t i = k * count + z;
+            c.setpoint[i] = t.setpoint;
+            c.direction[i] = t.direction;
+            c.kp[i] = t.kp;
+            c.ki[i] = t.kp / t.ti;
+            c.kd[i] = t.kp * t.td;
+            c.tracking[i] = 1.0f / (t.td > 0.0f ? std::sqrt(t.ti * t.td) : t.ti);
+            c.measurement[i] = c.previous[i] = temperatureLoop ? g.airTemperature[z] : g.humidity[z];
         }
-        else { // 绿色正常
-            perfectSensors++;
+    }
+
+    g.sensorZone.assign(sensorStore.size(), -1);
+    float margin = farmConfig.sensorPitch * 0.5f;
+    int covered = 0;
+    for (size_t z = 0; z < count; z++) {
+        const Building& house = buildingStore.detail[g.building[z]];
+        float halfX = house.size.x * 0.5f + margin, halfZ = house.size.z * 0.5f + margin;
+        int assigned = 0;
+        sensorLocator.forEachNear(house.position.x, house.position.z, std::max(halfX, halfZ), [&](int s) {
+            const glm::vec3& p = sensorStore.position[s];
+            if (g.sensorZone[s] < 0 && std::abs(p.x - house.position.x) <= halfX && std::abs(p.z - house.position.z) <= halfZ) {
+                g.sensorZone[s] = (int32_t)z;
+                assigned++;
+            }
+        });
+        // 占地内没有传感器时取最近的一个
+        uint32_t nearest;
+        float distance2;
+        if (assigned == 0 && findNearestSensors(house.position.x, house.position.z, 1, &nearest, &distance2) == 1 &&
+            g.sensorZone[nearest] < 0) {
+            g.sensorZone[nearest] = (int32_t)z;
+            assigned++;
         }
+        covered += assigned;
+    }
+
+    std::cout << "Greenhouse climate: " << count << " zones x " << CLIMATE_LOOP_KINDS << " PID loops, "
+        << covered << " sensors indoors" << std::endl;
+}
+
+// 气候回路内核 - 标量版本（也是SIMD版本的尾部处理和参考实现）
+void updateClimateLoopsScalar(ClimateLoops& c, size_t begin, size_t end, float dt) {
+    const float invDt = 1.0f / dt;
+    for (size_t i = begin; i < end; i++) {
+        float m = c.measurement[i];
+        float error = c.direction[i] * (c.setpoint[i] - m);
+        float rate = c.direction[i] * (c.previous[i] - m) * invDt;   // 误差变化率（只含测量值部分）
+        float raw = c.kp[i] * error + c.integral[i] + c.kd[i] * rate;
+        float u = std::min(std::max(raw, 0.0f), 1.0f);
+        c.integral[i] += dt * (c.ki[i] * error + c.tracking[i] * (u - raw));
+        c.previous[i] = m;
+        c.output[i] = u;
+    }
+}
+
+#ifdef FARM_X86
+// 气候回路内核 - SSE2版本，每条指令处理4个回路
+void updateClimateLoopsSSE2(ClimateLoops& c, size_t begin, size_t end, float dt) {
+    const __m128 step = _mm_set1_ps(dt);
+    const __m128 invDt = _mm_set1_ps(1.0f / dt);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 m = _mm_loadu_ps(&c.measurement[i]);
+        __m128 direction = _mm_loadu_ps(&c.direction[i]);
+        __m128 error = _mm_mul_ps(direction, _mm_sub_ps(_mm_loadu_ps(&c.setpoint[i]), m));
+        __m128 rate = _mm_mul_ps(_mm_mul_ps(direction, _mm_sub_ps(_mm_loadu_ps(&c.previous[i]), m)), invDt);
+        __m128 integral = _mm_loadu_ps(&c.integral[i]);
+        __m128 raw = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&c.kp[i]), error), integral),
+            _mm_mul_ps(_mm_loadu_ps(&c.kd[i]), rate));
+        __m128 u = _mm_min_ps(_mm_max_ps(raw, zero), one);
+        integral = _mm_add_ps(integral, _mm_mul_ps(step, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&c.ki[i]), error),
+            _mm_mul_ps(_mm_loadu_ps(&c.tracking[i]), _mm_sub_ps(u, raw)))));
+        _mm_storeu_ps(&c.integral[i], integral);
+        _mm_storeu_ps(&c.previous[i], m);
+        _mm_storeu_ps(&c.output[i], u);
+    }
+
+    updateClimateLoopsScalar(c, i, end, dt);
+}
+
+// 气候回路内核 - AVX2版本，每条指令处理8个回路
+FARM_TARGET_AVX2
+void updateClimateLoopsAVX2(ClimateLoops& c, size_t begin, size_t end, float dt) {
+    const __m256 step = _mm256_set1_ps(dt);
+    const __m256 invDt = _mm256_set1_ps(1.0f / dt);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 m = _mm256_loadu_ps(&c.measurement[i]);
+        __m256 direction = _mm256_loadu_ps(&c.direction[i]);
+        __m256 error = _mm256_mul_ps(direction, _mm256_sub_ps(_mm256_loadu_ps(&c.setpoint[i]), m));
+        __m256 rate = _mm256_mul_ps(_mm256_mul_ps(direction, _mm256_sub_ps(_mm256_loadu_ps(&c.previous[i]), m)), invDt);
+        __m256 integral = _mm256_loadu_ps(&c.integral[i]);
+        __m256 raw = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(&c.kp[i]), error), integral),
+            _mm256_mul_ps(_mm256_loadu_ps(&c.kd[i]), rate));
+        __m256 u = _mm256_min_ps(_mm256_max_ps(raw, zero), one);
+        integral = _mm256_add_ps(integral, _mm256_mul_ps(step, _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(&c.ki[i]), error),
+            _mm256_mul_ps(_mm256_loadu_ps(&c.tracking[i]), _mm256_sub_ps(u, raw)))));
+        _mm256_storeu_ps(&c.integral[i], integral);
+        _mm256_storeu_ps(&c.previous[i], m);
+        _mm256_storeu_ps(&c.output[i], u);
+    }
+
+    updateClimateLoopsScalar(c, i, end, dt);
+}
+#else
+// 非x86平台只有标量内核
+void updateClimateLoopsSSE2(ClimateLoops& c, size_t begin, size_t end, float dt) {
+    updateClimateLoopsScalar(c, begin, end, dt);
+}
+
+void updateClimateLoopsAVX2(ClimateLoops& c, size_t begin, size_t end, float dt) {
+    updateClimateLoopsScalar(c, begin, end, dt);
+}
+#endif
+
+// 气候回路内核与植物内核使用同一指令集级别
+void selectClimateKernel(PlantKernelLevel level) {
+    const char* names[] = { "Scalar", "SSE2 (4 loops/op)", "AVX2 (8 loops/op)" };
+    switch (level) {
+    case PLANT_KERNEL_AVX2: climateLoopKernel = updateClimateLoopsAVX2; break;
+    case PLANT_KERNEL_SSE2: climateLoopKernel = updateClimateLoopsSSE2; break;
+    default: climateLoopKernel = updateClimateLoopsScalar; break;
+    }
+    std::cout << "Climate PID kernel: " << names[level] << std::endl;
+}
+
+// 推进温室热湿区一个模拟步（模拟时间按昼夜周期换算为物理时间）：先以当前空气状态批量运行全部回路，
+// 通风取降温和除湿两回路的较大值，再按执行器开度积分热、湿平衡。气候控制关闭时执行器关闭、积分清零，
+// 重新开启时从零积分无扰切换
+void stepGreenhouseZones(float deltaTime) {
+    GreenhouseZones& g = greenhouseZones;
+    ClimateLoops& c = g.loops;
+    const size_t count = g.zones();
+    if (count == 0) return;
+    const float dt = deltaTime * (86400.0f / dayLengthSeconds);
+
+    // 室外条件取天气时间线；辐照度按太阳高度和云量
+    float sun = std::sin(dayNightCycle * 2.0f * 3.14159f);
+    g.outdoorTemperature = weather.temperature;
+    g.outdoorHumidity = weather.humidity;
+    float outdoorVapour = g.outdoorHumidity * 0.01f * saturationVapourDensity(g.outdoorTemperature);
+    float irradiance = 800.0f * std::max(sun, 0.0f) * (1.0f - 0.7f * weather.cloudCoverage);   // W/m²
+    float windFactor = 0.5f + 0.5f * windStrength;   // 风压通风
+
+    for (size_t z = 0; z < count; z++) {
+        c.measurement[CLIMATE_LOOP_HEAT * count + z] = g.airTemperature[z];
+        c.measurement[CLIMATE_LOOP_VENT_COOL * count + z] = g.airTemperature[z];
+        c.measurement[CLIMATE_LOOP_MIST * count + z] = g.humidity[z];
+        c.measurement[CLIMATE_LOOP_VENT_DRY * count + z] = g.humidity[z];
+    }
+    if (farmStatus.climateControl) {
+        auto start = std::chrono::steady_clock::now();
+        climateLoopKernel(c, 0, c.size(), dt);
+        g.controlMillis += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    else {
+        std::fill(c.output.begin(), c.output.end(), 0.0f);
+        std::fill(c.integral.begin(), c.integral.end(), 0.0f);
+        c.previous = c.measurement;
     }
+    g.steps++;
+
+    float electric = 0.0f;
+    double heatSupplied = 0.0;
+    for (size_t z = 0; z < count; z++) {
+        float heat = c.output[CLIMATE_LOOP_HEAT * count + z];
+        float vent = std::max(c.output[CLIMATE_LOOP_VENT_COOL * count + z], c.output[CLIMATE_LOOP_VENT_DRY * count + z]);
+        float mist = c.output[CLIMATE_LOOP_MIST * count + z];
+        g.heat[z] = heat;
+        g.vent[z] = vent;
+        g.mist[z] = mist;
+
+        // 换气次数：缝隙渗透 0.5 次/h，天窗全开 40 次/h
+        float airflow = g.volume[z] / 3600.0f * (0.5f + 40.0f * vent) * windFactor;   // m³/s
+        float conductance = g.glazingUA[z] + 1200.0f * airflow;                         // W/K
+        float evaporation = g.mistRate[z] * mist;                                       // g/s
+        float gain = 0.7f * g.floorArea[z] * irradiance + g.heaterPower[z] * heat - 2450.0f * evaporation;
+        float capacity = g.heatCapacity[z];
+        float t = (capacity * g.airTemperature[z] + dt * (gain + conductance * g.outdoorTemperature)) /
+            (capacity + dt * conductance);
+        float transpiration = g.floorArea[z] * (0.01f + 0.1f * irradiance / 800.0f);     // g/s
+        float volume = g.volume[z];
+        float w = (volume * g.vapourDensity[z] + dt * (transpiration + evaporation + airflow * outdoorVapour)) /
+            (volume + dt * airflow);
+        float saturation = saturationVapourDensity(t);
+        w = std::min(w, saturation);
+        g.airTemperature[z] = t;
+        g.vapourDensity[z] = w;
+        g.humidity[z] = 100.0f * w / saturation;
+
+        heatSupplied += g.heaterPower[z] * heat;
+        electric += g.heaterPower[z] * heat / 3000.0f + 0.75f * vent + 0.4f * mist;   // 热泵 COP 3，风机 0.75 kW，喷雾泵 0.4 kW
+    }
+    g.electricPower = electric;
+    g.heatEnergy += heatSupplied * dt / 3.6e6;
+}
+
+// 统计农场状态：植物健康分级、传感器警报、平均读数和功耗（只根据当前状态计算，可随时重复调用），
+// 返回分级计数
+TickAccumulator refreshFarmStatistics() {
+    // 统计健康植物 - 更详细（按块并行，各块计数后归约）
+    prepareChunkAccumulators(plantStore.sim.size(), statusChunkSize);
+    threadPool.parallelFor(plantStore.sim.size(), statusChunkSize, [&](size_t begin, size_t end, int) {
+        TickAccumulator& acc = chunkAccumulators[begin / statusChunkSize];
+        for (size_t i = begin; i < end; i++) {
+            float health = plantStore.sim.healthFactor[i];
+            bool infected = plantStore.sim.pestInfected[i] != 0;
+            if (health > 0.9f && !infected) {
+                acc.excellentPlants++;
+                acc.healthyPlants++;
+            }
+            else if (health > 0.7f && !infected) {
+                acc.healthyPlants++;
+            }
+            else if (health < 0.5f || infected) {
+                acc.criticalPlants++;
+                acc.sickPlants++;
+            }
+            else {
+                acc.sickPlants++;
+            }
+        }
+    });
+
+    TickAccumulator stats = reduceChunkAccumulators();
 
-    if (!sensors.empty()) {
-        farmStatus.avgTemperature = totalTemp / sensors.size();
-        farmStatus.avgHumidity = totalHumid / sensors.size();
-        farmStatus.avgSoilMoisture = totalSoil / sensors.size();
+    // 统计警报传感器和计算平均值 - 更详细
+    prepareChunkAccumulators(sensorStore.size(), statusChunkSize);
+    threadPool.parallelFor(sensorStore.size(), statusChunkSize, [&](size_t begin, size_t end, int) {
+        TickAccumulator& acc = chunkAccumulators[begin / statusChunkSize];
+        for (size_t i = begin; i < end; i++) {
+            const SensorReadings& sensor = sensorStore.readings[i];
+            const SensorDisplay& display = sensorStore.display[i];
+            acc.totalTemp += sensor.temperature;
+            acc.totalHumid += sensor.humidity;
+            acc.totalSoil += sensor.soilMoisture;
+
+            if (display.statusColor.r > 0.8f) { // 红色警报
+                acc.alertSensors++;
+            }
+            else if (display.statusColor.r > 0.7f || display.statusColor.g < 0.9f) { // 黄色警告
+                acc.warningSensors++;
+            }
+            else { // 绿色正常
+                acc.perfectSensors++;
+            }
+        }
+    });
+
+    TickAccumulator sensorStats = reduceChunkAccumulators();
+    stats.add(sensorStats);
+    farmStatus.healthyPlants = stats.healthyPlants;
+    farmStatus.sickPlants = stats.sickPlants;
+    farmStatus.alertSensors = stats.alertSensors;
+    float totalTemp = stats.totalTemp, totalHumid = stats.totalHumid, totalSoil = stats.totalSoil;
+
+    if (sensorStore.size() > 0) {
+        farmStatus.avgTemperature = totalTemp / sensorStore.size();
+        farmStatus.avgHumidity = totalHumid / sensorStore.size();
+        farmStatus.avgSoilMoisture = totalSoil / sensorStore.size();
     }
 
     // 计算功耗（超详细）
@@ -1736,11 +8132,21 @@ void updateFarmStatus() {
     if (farmStatus.autoFertilizer) farmStatus.powerConsumption += 12.8f;  // 增加
     if (farmStatus.autoHarvest) farmStatus.powerConsumption += 18.5f;     // 增加
     if (farmStatus.nightLighting) farmStatus.powerConsumption += 25.3f;   // 增加
-    if (farmStatus.climateControl) farmStatus.powerConsumption += 35.7f;  // 增加
+    farmStatus.powerConsumption += greenhouseZones.electricPower;         // 温室加热、风机、喷雾按实际开度
 
     // 根据自动化级别调整效率
     float automationMultiplier = 1.0f + (farmStatus.automationLevel - 1) * 0.25f;
     farmStatus.powerConsumption *= automationMultiplier;
+    return stats;
+}
+
+// 更新农场状态 - 超级明显版（每6秒模拟时间：统计状态，再结算施肥补充和收获产量）
+void updateFarmStatus() {
+    TickAccumulator stats = refreshFarmStatistics();
+    int excellentPlants = stats.excellentPlants;
+    int criticalPlants = stats.criticalPlants;
+    int warningeSensors = stats.warningSensors;
+    int perfectSensors = stats.perfectSensors;
 
     // 施肥水平管理 - 更动态
     if (farmStatus.autoFertilizer && farmStatus.fertilizerLevel < 100.0f) {
@@ -1757,8 +8163,7 @@ void updateFarmStatus() {
     }
 
     // 输出详细状态变化
-    static float lastReport = 0.0f;
-    if (systemTime - lastReport > 10.0f) {
+    if (simEventLog && simClock.simTime - simClock.lastStatusReport > 10.0) {
         std::cout << "=== FARM STATUS SUMMARY ===" << std::endl;
         std::cout << "Plant Health: " << excellentPlants << " excellent, "
             << farmStatus.healthyPlants << " healthy, " << farmStatus.sickPlants << " sick, "
@@ -1773,7 +8178,7 @@ void updateFarmStatus() {
         if (farmStatus.nightLighting) std::cout << "LIGHTING ";
         if (farmStatus.climateControl) std::cout << "CLIMATE ";
         std::cout << std::endl;
-        lastReport = systemTime;
+        simClock.lastStatusReport = simClock.simTime;
     }
 }
 
@@ -1785,21 +8190,72 @@ void printUIInfo() {
 
     std::cout << "\n==================== Smart Farm Control Panel ====================" << std::endl;
     std::cout << "Weather: " << weatherNames[weather.weatherType]
-        << " | Cloud Cover: " << (int)(weather.cloudCoverage * 100) << "%" << std::endl;
+        << " | Cloud Cover: " << (int)(weather.cloudCoverage * 100) << "%"
+        << " | Outdoor: " << (int)weather.temperature << "C, " << (int)weather.humidity << "%";
+    if (weatherFile.active()) {
+        std::cout << " | Source: " << weatherFile.path << " (hour " << weatherFile.bufferHour << ")";
+    }
+    else if (weatherTimeline.hours() > 0) {
+        size_t hour = weatherTimelineHour(simClock.simTime);
+        size_t ahead = 1;
+        while (ahead < weatherTimeline.hours() &&
+            weatherTimeline.type[(hour + ahead) % weatherTimeline.hours()] == weatherTimeline.type[hour]) {
+            ahead++;
+        }
+        if (ahead < weatherTimeline.hours()) {
+            std::cout << " | Next: " << weatherNames[weatherTimeline.type[(hour + ahead) % weatherTimeline.hours()]]
+                << " in " << ahead << " h";
+        }
+    }
+    std::cout << std::endl;
 
     std::cout << std::fixed << std::setprecision(1);
     std::cout << "Temperature: " << farmStatus.avgTemperature << "C"
         << " | Humidity: " << farmStatus.avgHumidity << "%" << std::endl;
 
-    std::cout << "Healthy Plants: " << farmStatus.healthyPlants << "/" << plants.size()
+    std::cout << "Healthy Plants: " << farmStatus.healthyPlants << "/" << plantStore.size()
         << " | Sick Plants: " << farmStatus.sickPlants << std::endl;
+    printCropSummary();
 
-    std::cout << "Alert Sensors: " << farmStatus.alertSensors << "/" << sensors.size()
+    std::cout << "Alert Sensors: " << farmStatus.alertSensors << "/" << sensorStore.size()
         << " | Power Usage: " << farmStatus.powerConsumption << " kW" << std::endl;
 
     std::cout << "Auto Irrigation: " << (farmStatus.autoIrrigation ? "ON" : "OFF")
         << " | Pest Control: " << (farmStatus.pestControl ? "ON" : "OFF") << std::endl;
 
+    std::cout << "Water Demand Forecast: 24h " << etForecast.totalDemand24 / 1000.0
+        << " m3 | 48h " << etForecast.totalDemand48 / 1000.0
+        << " m3 | 72h " << etForecast.totalDemand72 / 1000.0 << " m3" << std::endl;
+
+    std::cout << "Irrigation Schedule: " << irrigationSchedule.scheduledValves << " valves planned ("
+        << irrigationSchedule.truncatedValves << " cut) | Open: " << farmStatus.activeNozzles
+        << " | Pressure: " << (int)farmStatus.waterPressure << " PSI | Uniformity: "
+        << (int)farmStatus.irrigationEfficiency << "% | Tank: " << (int)farmStatus.waterTankLevel << "%"
+        << (pipeNetwork.converged ? "" : " | PIPE SOLVE NOT CONVERGED") << std::endl;
+
+    if (greenhouseZones.zones() > 0) {
+        const GreenhouseZones& g = greenhouseZones;
+        float temperature = 0.0f, humidity = 0.0f, heat = 0.0f, vent = 0.0f, mist = 0.0f;
+        for (size_t z = 0; z < g.zones(); z++) {
+            temperature += g.airTemperature[z];
+            humidity += g.humidity[z];
+            heat += g.heat[z];
+            vent += g.vent[z];
+            mist += g.mist[z];
+        }
+        float n = (float)g.zones();
+        std::cout << "Greenhouses: " << g.zones() << " | Air: " << temperature / n << "C (outside "
+            << g.outdoorTemperature << "C) | Humidity: " << (int)(humidity / n) << "% | Heat "
+            << (int)(heat / n * 100.0f) << "% Vent " << (int)(vent / n * 100.0f) << "% Mist "
+            << (int)(mist / n * 100.0f) << "% | Heating: " << (int)g.heatEnergy << " kWh" << std::endl;
+    }
+
+    if (sensorIngest.active()) {
+        std::cout << "Live Sensors: " << sensorIngest.samplesApplied << " readings applied | Dropped: "
+            << sensorIngest.samplesDropped.load() << " | Malformed: " << sensorIngest.malformed.load()
+            << " | Unknown IDs: " << sensorIngest.unknownSensors << std::endl;
+    }
+
     std::cout << "Auto Fertilizer: " << (farmStatus.autoFertilizer ? "ON" : "OFF")
         << " | Auto Harvest: " << (farmStatus.autoHarvest ? "ON" : "OFF") << std::endl;
 
@@ -1813,13 +8269,35 @@ void printUIInfo() {
         std::cout << "Planting Mode: " << plantingModes[farmStatus.plantingMode]
             << " | Automation: " << automationLevels[farmStatus.automationLevel] << std::endl;
         std::cout << "Harvest Yield: " << std::setprecision(2) << farmStatus.harvestYield << " kg"
-            << " | Buildings: " << buildings.size()
-            << " | Sensors: " << sensors.size() << std::endl;
+            << " | Buildings: " << buildingStore.size()
+            << " | Sensors: " << sensorStore.size() << std::endl;
     }
 
     std::cout << "==================================================================" << std::endl;
 }
 
+// 各作物的物候阶段分布：营养生长、开花、结果、成熟（生长阶段达到0.9）
+void printCropSummary() {
+    if (plantBatchesStale) rebuildPlantBatches();
+    std::vector<int> counts(cropTable.size() * 4, 0);
+    for (const PlantBatch& batch : plantBatches) {
+        int* c = &counts[batch.crop * 4];
+        for (size_t i = batch.begin; i < batch.end; i++) {
+            if (plantStore.sim.growthStage[i] >= 0.9f) c[3]++;
+            else if (plantStore.sim.hasFruits[i]) c[2]++;
+            else if (plantStore.sim.hasFlowers[i]) c[1]++;
+            else c[0]++;
+        }
+    }
+    for (size_t crop = 0; crop < cropTable.size(); crop++) {
+        const int* c = &counts[crop * 4];
+        std::cout << "  " << cropTable[crop].name << ": " << (c[0] + c[1] + c[2] + c[3]) << " plants"
+            << " | vegetative " << c[0] << " | flowering " << c[1]
+            << " | fruiting " << c[2] << " | mature " << c[3] << std::endl;
+    }
+}
+
+#ifndef FARM_HEADLESS
 // 生成详细农场场景（保持原有所有功能）
 void generateDetailedFarm() {
     renderObjects.clear();
@@ -1829,11 +8307,15 @@ void generateDetailedFarm() {
     ground.transparent = false;
     ground.castShadow = false;
 
+    // 地面按2米一块铺设，范围随田地大小变化
+    int groundTiles = (int)std::ceil(farmConfig.groundHalfExtent() / 2.0f);
+    float soilRadius = groundTiles * 0.88f;
+
     // 主要农田区域 (深棕色土壤)
-    for (int i = -25; i <= 25; i++) {
-        for (int j = -25; j <= 25; j++) {
+    for (int i = -groundTiles; i <= groundTiles; i++) {
+        for (int j = -groundTiles; j <= groundTiles; j++) {
             float distance = sqrt(i * i + j * j);
-            if (distance < 22.0f) {
+            if (distance < soilRadius) {
                 float soilVariation = sin(i * 0.1f) * cos(j * 0.1f) * 0.05f;
                 glm::vec3 soilColor = glm::vec3(0.3f + soilVariation, 0.2f + soilVariation, 0.1f);
                 addDetailedCube(ground, glm::vec3(i * 2.0f, -0.1f, j * 2.0f),
@@ -1849,7 +8331,7 @@ void generateDetailedFarm() {
     roads.castShadow = false;
 
     // 主干道 (十字形)
-    for (int i = -25; i <= 25; i++) {
+    for (int i = -groundTiles; i <= groundTiles; i++) {
         // 南北主干道
         addDetailedCube(roads, glm::vec3(0.0f, 0.0f, i * 2.0f),
             glm::vec3(3.0f, 0.1f, 2.0f), glm::vec3(0.4f, 0.4f, 0.4f));
@@ -1859,10 +8341,10 @@ void generateDetailedFarm() {
     }
 
     // 连接道路到各个建筑
-    for (const auto& building : buildings) {
+    for (const auto& position : buildingStore.position) {
         int steps = 8;
         glm::vec3 start = glm::vec3(0.0f, 0.0f, 0.0f);
-        glm::vec3 end = building.position;
+        glm::vec3 end = position;
         for (int i = 0; i < steps; i++) {
             float t = (float)i / steps;
             glm::vec3 pos = glm::mix(start, end, t);
@@ -1883,7 +8365,7 @@ void generateDetailedFarm() {
     renderObjects.push_back(std::move(pathsObj));
 
     // 4. 建筑群渲染
-    for (const auto& building : buildings) {
+    for (const auto& building : buildingStore.detail) {
         RenderObject buildingObj;
         createBuildingGeometry(buildingObj, building);
         renderObjects.push_back(std::move(buildingObj));
@@ -1893,20 +8375,23 @@ void generateDetailedFarm() {
     RenderObject sensorNetwork;
     sensorNetwork.transparent = false;
 
-    for (const auto& sensor : sensors) {
+    for (size_t row = 0; row < sensorStore.size(); row++) {
+        const glm::vec3& position = sensorStore.position[row];
+        const SensorDisplay& display = sensorStore.display[row];
+
         // 地面传感器支柱 (更短，贴地)
-        addCylinder(sensorNetwork, sensor.position,
-            sensor.position + glm::vec3(0, 1.5f, 0), 0.08f,  // 降低高度，增加粗细
+        addCylinder(sensorNetwork, position,
+            position + glm::vec3(0, 1.5f, 0), 0.08f,  // 降低高度，增加粗细
             glm::vec3(0.8f, 0.8f, 0.9f), 8, 0.0f);
 
         // 传感器设备舱 (更大更明显)
-        addDetailedCube(sensorNetwork, sensor.position + glm::vec3(0, 1.3f, 0),
+        addDetailedCube(sensorNetwork, position + glm::vec3(0, 1.3f, 0),
             glm::vec3(0.25f, 0.3f, 0.25f), glm::vec3(0.9f, 0.5f, 0.2f),  // 增大尺寸
             glm::vec3(0, 1, 0), 4.0f);
 
         // 状态指示灯 (更大更亮)
-        addDetailedCube(sensorNetwork, sensor.position + glm::vec3(0, 1.6f, 0),
-            glm::vec3(0.06f, 0.06f, 0.06f), sensor.statusColor,  // 更大的指示灯
+        addDetailedCube(sensorNetwork, position + glm::vec3(0, 1.6f, 0),
+            glm::vec3(0.06f, 0.06f, 0.06f), display.statusColor,  // 更大的指示灯
             glm::vec3(0, 1, 0), 4.0f);
 
         // 七个数据可视化柱 (更高更明显)
@@ -1923,10 +8408,10 @@ void generateDetailedFarm() {
         for (int i = 0; i < 7; i++) {
             float angle = i * 51.43f * 3.14159f / 180.0f; // 360/7度
             glm::vec3 offset = glm::vec3(cos(angle) * 0.5f, 0, sin(angle) * 0.5f);  // 增大半径
-            glm::vec3 columnPos = sensor.position + offset + glm::vec3(0, sensor.dataHeight[i] * 0.5f, 0);
+            glm::vec3 columnPos = position + offset + glm::vec3(0, display.dataHeight[i] * 0.5f, 0);
 
             addDetailedCube(sensorNetwork, columnPos,
-                glm::vec3(0.1f, sensor.dataHeight[i], 0.1f),  // 更粗的数据柱
+                glm::vec3(0.1f, display.dataHeight[i], 0.1f),  // 更粗的数据柱
                 dataColors[i], glm::vec3(0, 1, 0), 4.0f);
         }
     }
@@ -1936,8 +8421,8 @@ void generateDetailedFarm() {
     RenderObject plantGroup;
     plantGroup.transparent = false;
 
-    for (const auto& plant : plants) {
-        createDetailedPlantGeometry(plantGroup, plant);
+    for (size_t row = 0; row < plantStore.size(); row++) {
+        createDetailedPlantGeometry(plantGroup, plantStore, row);
     }
     renderObjects.push_back(std::move(plantGroup));
 
@@ -1945,17 +8430,23 @@ void generateDetailedFarm() {
     RenderObject irrigation;
     irrigation.transparent = false;
 
-    // 主水管网络 - 更大更明显
-    for (int i = -20; i <= 20; i += 4) {
-        for (int j = -20; j <= 20; j += 4) {
+    // 主水管网络 - 更大更明显（喷头按配置间距铺满田地）
+    float nozzleSpacing = farmConfig.nozzleSpacing;
+    float nozzleExtent = farmConfig.nozzleHalfExtent();
+    int nozzleSteps = (int)(nozzleExtent * 2.0f / nozzleSpacing + 0.001f);
+    for (int ix = 0; ix <= nozzleSteps; ix++) {
+        for (int iz = 0; iz <= nozzleSteps; iz++) {
+            float i = -nozzleExtent + ix * nozzleSpacing;
+            float j = -nozzleExtent + iz * nozzleSpacing;
+
             // 主水管 (更粗的蓝色管道)
             addCylinder(irrigation, glm::vec3(i, 0.15f, j),
-                glm::vec3(i + 4, 0.15f, j), 0.12f,  // 增加半径
+                glm::vec3(i + nozzleSpacing, 0.15f, j), 0.12f,  // 增加半径
                 glm::vec3(0.2f, 0.5f, 0.9f), 8, 0.0f);
 
             // 垂直供水管
             addCylinder(irrigation, glm::vec3(i, 0.15f, j),
-                glm::vec3(i, 0.15f, j + 4), 0.12f,
+                glm::vec3(i, 0.15f, j + nozzleSpacing), 0.12f,
                 glm::vec3(0.2f, 0.5f, 0.9f), 8, 0.0f);
 
             // 大型喷头 (更明显)
@@ -1964,7 +8455,7 @@ void generateDetailedFarm() {
                 glm::vec3(0.7f, 0.8f, 0.9f), glm::vec3(0, 1, 0), 0.0f);
 
             // 喷水效果指示器 (当灌溉激活时)
-            if (farmStatus.irrigationActive && (i + j) % 8 == 0) {  // 部分喷头激活
+            if (farmStatus.irrigationActive && (ix + iz) % 2 == 0) {  // 部分喷头激活
                 // 水珠效果 (小蓝色圆球)
                 for (int k = 0; k < 6; k++) {
                     float angle = k * 60.0f * 3.14159f / 180.0f;
@@ -1984,11 +8475,11 @@ void generateDetailedFarm() {
 
     // 主水源连接 (从水处理站)
     addCylinder(irrigation, glm::vec3(-15.0f, 0.15f, 8.0f),
-        glm::vec3(-20.0f, 0.15f, 0.0f), 0.2f,  // 主供水管道
+        glm::vec3(-nozzleExtent, 0.15f, 0.0f), 0.2f,  // 主供水管道
         glm::vec3(0.1f, 0.4f, 0.8f), 8, 0.0f);
 
     // 水泵站指示器
-    addDetailedCube(irrigation, glm::vec3(-22.0f, 1.0f, 0.0f),
+    addDetailedCube(irrigation, glm::vec3(-nozzleExtent - 2.0f, 1.0f, 0.0f),
         glm::vec3(0.8f, 0.6f, 0.8f),
         glm::vec3(0.6f, 0.7f, 0.8f), glm::vec3(0, 1, 0), 0.0f);
 
@@ -1999,17 +8490,18 @@ void generateDetailedFarm() {
     fencing.transparent = false;
 
     // 外围围栏
-    for (int i = -25; i <= 25; i += 2) {
+    float fenceExtent = groundTiles * 2.0f;
+    for (int i = -groundTiles; i <= groundTiles; i += 2) {
         // 北侧和南侧围栏
-        addDetailedCube(fencing, glm::vec3(i * 2.0f, 1.2f, -50.0f),
+        addDetailedCube(fencing, glm::vec3(i * 2.0f, 1.2f, -fenceExtent),
             glm::vec3(0.1f, 2.4f, 0.1f), glm::vec3(0.6f, 0.4f, 0.2f));
-        addDetailedCube(fencing, glm::vec3(i * 2.0f, 1.2f, 50.0f),
+        addDetailedCube(fencing, glm::vec3(i * 2.0f, 1.2f, fenceExtent),
             glm::vec3(0.1f, 2.4f, 0.1f), glm::vec3(0.6f, 0.4f, 0.2f));
 
         // 东侧和西侧围栏
-        addDetailedCube(fencing, glm::vec3(-50.0f, 1.2f, i * 2.0f),
+        addDetailedCube(fencing, glm::vec3(-fenceExtent, 1.2f, i * 2.0f),
             glm::vec3(0.1f, 2.4f, 0.1f), glm::vec3(0.6f, 0.4f, 0.2f));
-        addDetailedCube(fencing, glm::vec3(50.0f, 1.2f, i * 2.0f),
+        addDetailedCube(fencing, glm::vec3(fenceExtent, 1.2f, i * 2.0f),
             glm::vec3(0.1f, 2.4f, 0.1f), glm::vec3(0.6f, 0.4f, 0.2f));
     }
     renderObjects.push_back(std::move(fencing));
@@ -2019,7 +8511,7 @@ void generateDetailedFarm() {
 
 // 创建建筑几何体（保持原有功能）
 void createBuildingGeometry(RenderObject& obj, const Building& building) {
-    obj.transparent = (building.name == "温室A" || building.name == "温室B");
+    obj.transparent = building.greenhouse;
 
     glm::vec3 pos = building.position;
     glm::vec3 size = building.size;
@@ -2106,8 +8598,41 @@ void createBuildingGeometry(RenderObject& obj, const Building& building) {
     }
 }
 
+// 渲染用的单株植物视图 - 只读取几何生成需要的列
+struct PlantView {
+    glm::vec3 position;
+    float height;
+    float stemRadius;
+    float leafSize;
+    float rootSpread;
+    float healthFactor;
+    float growthStage;
+    int leafCount;
+    const CropSpec* crop;
+    glm::vec3 stemColor;
+    glm::vec3 leafColor;
+    glm::vec3 flowerColor;
+    glm::vec3 fruitColor;
+    bool hasFlowers;
+    bool hasFruits;
+    bool isPestInfected;
+
+    PlantView(const PlantArchetype& store, size_t row) :
+        position(store.shape.position[row]), height(store.shape.height[row]),
+        stemRadius(store.shape.stemRadius[row]), leafSize(store.shape.leafSize[row]),
+        rootSpread(store.shape.rootSpread[row]), healthFactor(store.sim.healthFactor[row]),
+        growthStage(store.sim.growthStage[row]), leafCount(store.shape.leafCount[row]),
+        crop(&cropTable[store.shape.plantType[row]]), stemColor(store.shape.stemColor[row]),
+        leafColor(store.sim.leafColorR[row], store.sim.leafColorG[row], store.shape.leafColorB[row]),
+        flowerColor(1.0f, 0.8f, 0.2f), fruitColor(0.8f, 0.2f, 0.1f),
+        hasFlowers(store.sim.hasFlowers[row] != 0), hasFruits(store.sim.hasFruits[row] != 0),
+        isPestInfected(store.sim.pestInfected[row] != 0) {
+    }
+};
+
 // 创建精细植物几何体（增强版）
-void createDetailedPlantGeometry(RenderObject& obj, const DetailedPlant& plant) {
+void createDetailedPlantGeometry(RenderObject& obj, const PlantArchetype& store, size_t row) {
+    PlantView plant(store, row);
     glm::vec3 basePos = plant.position;
 
     // 主茎 - 多段式，根据植物类型调整
@@ -2133,44 +8658,43 @@ void createDetailedPlantGeometry(RenderObject& obj, const DetailedPlant& plant)
             plant.stemColor * 0.8f, glm::vec3(0, 1, 0), 1.0f);
     }
 
-    // 详细叶片系统 - 使用预计算的位置
-    for (size_t i = 0; i < plant.leafPositions.size() && i < plant.leafSizes.size(); i++) {
-        float heightRatio = (float)(i + 1) / plant.leafPositions.size();
+    // 详细叶片系统 - 叶片布局按需计算
+    for (int i = 0; i < plant.leafCount; i++) {
+        float heightRatio = (float)(i + 1) / plant.leafCount;
+        LeafLayout leaf = computeLeafLayout(basePos, i, plant.leafCount, plant.leafSize,
+            plant.height, plant.growthStage, plant.healthFactor);
 
         // 叶片方向计算
-        float angle = i * 137.5f * 3.14159f / 180.0f; // 黄金角度螺旋
-        glm::vec3 leafDirection = glm::vec3(cos(angle), 0.3f + heightRatio * 0.2f, sin(angle));
+        glm::vec3 leafDirection = glm::vec3(leafSpiral.cosAngle[i], 0.3f + heightRatio * 0.2f, leafSpiral.sinAngle[i]);
 
         // 根据植物类型调整叶片形状
-        switch (plant.plantType) {
-        case 0: // 玉米 - 长条形叶片
-            addDetailedLeaf(obj, plant.leafPositions[i], leafDirection,
-                plant.leafSizes[i] * 1.5f, plant.leafColor);
+        switch (plant.crop->leafStyle) {
+        case LEAF_BLADE: // 玉米 - 长条形叶片
+            addDetailedLeaf(obj, leaf.position, leafDirection,
+                leaf.size * 1.5f, plant.leafColor);
             break;
-        case 1: // 小麦 - 细长叶片
-            addDetailedLeaf(obj, plant.leafPositions[i], leafDirection,
-                plant.leafSizes[i] * 0.8f, plant.leafColor);
+        case LEAF_NARROW: // 小麦 - 细长叶片
+            addDetailedLeaf(obj, leaf.position, leafDirection,
+                leaf.size * 0.8f, plant.leafColor);
             break;
-        case 2: // 番茄 - 复合叶片
+        case LEAF_COMPOUND: // 番茄 - 复合叶片
             for (int j = 0; j < 3; j++) {
-                glm::vec3 subLeafPos = plant.leafPositions[i] + glm::vec3((j - 1) * plant.leafSizes[i] * 0.3f, 0, 0);
+                glm::vec3 subLeafPos = leaf.position + glm::vec3((j - 1) * leaf.size * 0.3f, 0, 0);
                 addDetailedLeaf(obj, subLeafPos, leafDirection,
-                    plant.leafSizes[i] * 0.7f, plant.leafColor);
+                    leaf.size * 0.7f, plant.leafColor);
             }
             break;
-        case 3: // 菠菜 - 圆形叶片
-            addDetailedCube(obj, plant.leafPositions[i],
-                glm::vec3(plant.leafSizes[i], 0.02f, plant.leafSizes[i] * 0.8f),
+        case LEAF_ROUND: // 菠菜 - 圆形叶片
+            addDetailedCube(obj, leaf.position,
+                glm::vec3(leaf.size, 0.02f, leaf.size * 0.8f),
                 plant.leafColor, glm::vec3(0, 1, 0), 1.0f);
             break;
         }
 
         // 叶脉细节
-        if (i < plant.leafPositions.size()) {
-            glm::vec3 leafTip = plant.leafPositions[i] + leafDirection * plant.leafSizes[i] * 0.8f;
-            addCylinder(obj, plant.leafPositions[i], leafTip, 0.003f,
-                plant.leafColor * 0.7f, 4, 1.0f);
-        }
+        glm::vec3 leafTip = leaf.position + leafDirection * leaf.size * 0.8f;
+        addCylinder(obj, leaf.position, leafTip, 0.003f,
+            plant.leafColor * 0.7f, 4, 1.0f);
     }
 
     // 花朵和果实系统
@@ -2181,8 +8705,8 @@ void createDetailedPlantGeometry(RenderObject& obj, const DetailedPlant& plant)
         addDetailedCube(obj, flowerPos, glm::vec3(0.02f, 0.04f, 0.02f),
             glm::vec3(0.8f, 0.6f, 0.2f), glm::vec3(0, 1, 0), 1.0f);
 
-        // 花瓣 - 根据植物类型
-        int petalCount = (plant.plantType == 2) ? 5 : 6;
+        // 花瓣 - 根据作物参数
+        int petalCount = plant.crop->petalCount;
         for (int i = 0; i < petalCount; i++) {
             float angle = i * (360.0f / petalCount) * 3.14159f / 180.0f;
             glm::vec3 petalPos = flowerPos + glm::vec3(cos(angle) * 0.08f, 0.02f, sin(angle) * 0.08f);
@@ -2191,7 +8715,7 @@ void createDetailedPlantGeometry(RenderObject& obj, const DetailedPlant& plant)
         }
     }
 
-    if (plant.hasFruits && plant.plantType == 2) { // 番茄果实
+    if (plant.hasFruits) { // 果实（只有结果作物会置位）
         int fruitCount = (int)(plant.healthFactor * 4.0f) + 1;
         for (int i = 0; i < fruitCount; i++) {
             float angle = i * 120.0f * 3.14159f / 180.0f;
@@ -2247,12 +8771,12 @@ void createDetailedPlantGeometry(RenderObject& obj, const DetailedPlant& plant)
     // 病虫害可视化
     if (plant.isPestInfected) {
         // 病变叶片（部分叶片变色）
-        int affectedLeaves = std::min(3, (int)plant.leafPositions.size());
+        int affectedLeaves = std::min(3, plant.leafCount);
         for (int i = 0; i < affectedLeaves; i++) {
-            if (i < (int)plant.leafPositions.size()) {
-                addDetailedCube(obj, plant.leafPositions[i] + glm::vec3(0, 0, 0.01f),
-                    glm::vec3(0.02f, 0.02f, 0.01f), glm::vec3(0.6f, 0.3f, 0.1f), glm::vec3(0, 1, 0), 1.0f);
-            }
+            LeafLayout leaf = computeLeafLayout(basePos, i, plant.leafCount, plant.leafSize,
+                plant.height, plant.growthStage, plant.healthFactor);
+            addDetailedCube(obj, leaf.position + glm::vec3(0, 0, 0.01f),
+                glm::vec3(0.02f, 0.02f, 0.01f), glm::vec3(0.6f, 0.3f, 0.1f), glm::vec3(0, 1, 0), 1.0f);
         }
     }
 }
@@ -2523,30 +9047,30 @@ void render() {
     if (weatherTypeLoc >= 0) glUniform1i(weatherTypeLoc, weather.weatherType);
 
     GLint cloudCoverageLoc = glGetUniformLocation(shaderProgram, "cloudCoverage");
-    if (cloudCoverageLoc >= 0) glUniform1f(cloudCoverageLoc, weather.cloudCoverage);
+    if (cloudCoverageLoc >= 0) glUniform1f(cloudCoverageLoc, renderState.cloudCoverage);
 
     GLint precipitationLoc = glGetUniformLocation(shaderProgram, "precipitation");
-    if (precipitationLoc >= 0) glUniform1f(precipitationLoc, weather.precipitation);
+    if (precipitationLoc >= 0) glUniform1f(precipitationLoc, renderState.precipitation);
 
     GLint fogColorLoc = glGetUniformLocation(shaderProgram, "fogColor");
-    if (fogColorLoc >= 0) glUniform3fv(fogColorLoc, 1, glm::value_ptr(weather.fogColor));
+    if (fogColorLoc >= 0) glUniform3fv(fogColorLoc, 1, glm::value_ptr(renderState.fogColor));
 
     GLint fogDensityLoc = glGetUniformLocation(shaderProgram, "fogDensity");
-    if (fogDensityLoc >= 0) glUniform1f(fogDensityLoc, weather.fogDensity);
+    if (fogDensityLoc >= 0) glUniform1f(fogDensityLoc, renderState.fogDensity);
 
     // 设置动画uniform
     GLint timeLoc = glGetUniformLocation(shaderProgram, "time");
     if (timeLoc >= 0) glUniform1f(timeLoc, systemTime);
 
     GLint windDirLoc = glGetUniformLocation(shaderProgram, "windDirection");
-    if (windDirLoc >= 0) glUniform2fv(windDirLoc, 1, glm::value_ptr(windDirection));
+    if (windDirLoc >= 0) glUniform2fv(windDirLoc, 1, glm::value_ptr(renderState.windDirection));
 
     GLint windStrLoc = glGetUniformLocation(shaderProgram, "windStrength");
-    if (windStrLoc >= 0) glUniform1f(windStrLoc, windStrength);
+    if (windStrLoc >= 0) glUniform1f(windStrLoc, renderState.windStrength);
 
     // 光照空间矩阵
     glm::mat4 lightProjection = glm::ortho(-30.0f, 30.0f, -30.0f, 30.0f, 1.0f, 50.0f);
-    glm::mat4 lightView = glm::lookAt(lightPos, glm::vec3(0.0f), glm::vec3(0.0, 1.0, 0.0));
+    glm::mat4 lightView = glm::lookAt(renderState.lightPos, glm::vec3(0.0f), glm::vec3(0.0, 1.0, 0.0));
     glm::mat4 lightSpaceMatrix = lightProjection * lightView;
     GLint lightSpaceLoc = glGetUniformLocation(shaderProgram, "lightSpaceMatrix");
     if (lightSpaceLoc >= 0) glUniformMatrix4fv(lightSpaceLoc, 1, GL_FALSE, glm::value_ptr(lightSpaceMatrix));
@@ -2609,7 +9133,7 @@ void render() {
 
 void updateLighting() {
     // 根据天气调整光照
-    glm::vec3 adjustedLightColor = lightColor;
+    glm::vec3 adjustedLightColor = renderState.lightColor;
     float lightIntensity = 1.0f;
 
     switch (weather.weatherType) {
@@ -2632,8 +9156,8 @@ void updateLighting() {
     }
 
     // 计算动态光照方向
-    float dayIntensity = clamp(lightPos.y / 20.0f, 0.0f, 1.0f);
-    glm::vec3 lightDirection = glm::normalize(-lightPos);
+    float dayIntensity = clamp(renderState.lightPos.y / 20.0f, 0.0f, 1.0f);
+    glm::vec3 lightDirection = glm::normalize(-renderState.lightPos);
 
     // 设置光照参数
     GLint lightDirLoc = glGetUniformLocation(shaderProgram, "lightDir");
@@ -2712,4 +9236,5 @@ void updateCamera() {
             glUniformMatrix4fv(mvpLoc, 1, GL_FALSE, glm::value_ptr(mvp));
         }
     }
-} 
\ No newline at end of file
+} 
+#endif